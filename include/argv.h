@@ -9,6 +9,7 @@
 
 #include "common.h"
 #include "error.h"
+#include "ssl.h"
 #include "utils.h"
 
 #define OPT_LSEP "--"
@@ -19,7 +20,18 @@
 #define MAX_URL_LENGTH 268
 
 #define NUM_METHODS 6
-#define NUM_OPTIONS 14
+#define NUM_OPTIONS 48
+
+#define DEFAULT_CONCURRENCY 64
+#define MAX_CONCURRENCY 65536
+#define MAX_TIMEOUT 3600000
+#define MAX_RESUME 1000
+#define MAX_COUNT 10000000
+#define MAX_RATE 10000000
+#define MAX_DURATION 86400
+#define MAX_CACHE_TTL 31536000
+
+#define DEFAULT_DURATION 10
 
 #define OPT_SSLV2 1
 #define OPT_SSLV3 2
@@ -28,9 +40,15 @@
 #define OPT_TLSV1_2 16
 #define OPT_TLSV1_3 32
 
+/**
+ * Protocol version, by key, bitmask, OpenSSL
+ * version number, and name as OpenSSL gives it.
+ */
 typedef struct {
 	char *key;
 	int value;
+	int version;
+	char *name;
 } method_t;
 
 typedef struct {
@@ -39,10 +57,62 @@ typedef struct {
 	char *desc;
 } option_t;
 
-static method_t methods[NUM_METHODS];
-static option_t options[NUM_OPTIONS];
+/**
+ * Runtime settings, as given on the command line.
+ */
+typedef struct {
+	int bits;
+	int chain;
+	int cipher;
+	int issuer;
+	int method;
+	int no_sni;
+	int pad_fmt;
+	int quiet;
+	int raw;
+	int serial;
+	int sig_algo;
+	int subject;
+	int validity;
+	int timing;
+	int concurrency;
+	char *targets;
+	char *resolver;
+	int address;
+	int connect_timeout;
+	int handshake_timeout;
+	int deadline;
+	int resume;
+	int count;
+	int interval;
+	int load;
+	int rate;
+	int duration;
+	int format;
+	char *decode;
+	char *cache;
+	int cache_ttl;
+	char *since;
+	int watch;
+	int arena;
+	int mem_stats;
+	int enumerate;
+	int verify;
+	char *ca_file;
+	int cert_only;
+	char *metrics_file;
+	int metrics_port;
+	char *trace;
+	char *sni_list;
+	char *connect;
+	int per_ip;
+	int per_prefix;
+	int adaptive;
+} settings_t;
 
 int get_bitmask_from_key(char *);
+method_t *get_method(int);
+method_t *get_method_from_version(int);
 void usage(void);
 
 #endif /* KEUKA_ARGV_H */
@@ -0,0 +1,38 @@
+/**
+ * buf.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_BUF_H
+#define KEUKA_BUF_H
+
+#include <stdarg.h>
+#include "common.h"
+#include "error.h"
+#include "mem.h"
+#include "utils.h"
+
+#define BUF_INITIAL_SIZE 4096
+
+/**
+ * Growable output buffer. It is meant to be reset
+ * and reused, so once it has grown to fit the largest
+ * record, rendering doesn't allocate anymore.
+ */
+typedef struct {
+	char *data;
+	size_t len;
+	size_t size;
+} buf_t;
+
+buf_t *buf_new(size_t);
+void buf_free(buf_t *);
+void buf_reset(buf_t *);
+void buf_append(buf_t *, const char *, size_t);
+void buf_puts(buf_t *, const char *);
+void buf_printf(buf_t *, const char *, ...);
+void buf_json(buf_t *, const char *, size_t);
+int buf_write(buf_t *, int);
+
+#endif /* KEUKA_BUF_H */
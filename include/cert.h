@@ -0,0 +1,83 @@
+/**
+ * cert.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_CERT_H
+#define KEUKA_CERT_H
+
+#include <pthread.h>
+#include <openssl/sha.h>
+#include "common.h"
+#include "buf.h"
+#include "error.h"
+#include "mem.h"
+#include "ssl.h"
+#include "utils.h"
+
+#define CERT_CACHE_SIZE 1024
+#define CERT_CACHE_LIMIT 4096
+#define CERT_FINGERPRINT_LENGTH (SHA256_DIGEST_LENGTH * 2)
+#define CERT_MAX_REFS 32
+
+/**
+ * A certificate seen during a batch, keyed by
+ * SHA-256 of its DER encoding, with its fields
+ * rendered once. Whether it has been written out
+ * in full is only known (and changed) under the
+ * output lock, so it follows the order of output.
+ * Entries are pinned by reports that refer to them
+ * until those are written out, and are kept in order
+ * of use, so the least recently used unpinned ones
+ * can be dropped once the cache is full.
+ */
+typedef struct cert_entry {
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	char fingerprint[CERT_FINGERPRINT_LENGTH + NULL_BYTE];
+	char *full;
+	size_t fulllen;
+	char *ref;
+	size_t reflen;
+	int emitted;
+	int pins;
+	struct cert_entry *next;
+	struct cert_entry *newer;
+	struct cert_entry *older;
+} cert_entry_t;
+
+/**
+ * Renders the fields of a certificate into buf.
+ */
+typedef void (*cert_render_t)(buf_t *, X509 *, const char *, void *);
+
+typedef struct {
+	cert_entry_t **buckets;
+	size_t size;
+	size_t count;
+	size_t limit;
+	cert_entry_t *newest;
+	cert_entry_t *oldest;
+	const char *ref_fmt;
+	pthread_mutex_t lock;
+} cert_cache_t;
+
+/**
+ * Places in a rendered report where a certificate
+ * goes, either in full or by reference.
+ */
+typedef struct {
+	size_t offsets[CERT_MAX_REFS];
+	cert_entry_t *entries[CERT_MAX_REFS];
+	int count;
+} cert_refs_t;
+
+void cert_hex(const unsigned char *, char *);
+int cert_digest(X509 *, unsigned char *, char *);
+cert_cache_t *cert_cache_new(const char *);
+void cert_cache_free(cert_cache_t *);
+cert_entry_t *cert_cache_get(cert_cache_t *, X509 *, cert_render_t, void *);
+void cert_cache_expand(const cert_refs_t *, const char *, size_t, buf_t *);
+void cert_cache_release(cert_cache_t *, const cert_refs_t *);
+
+#endif /* KEUKA_CERT_H */
@@ -7,8 +7,44 @@
 #ifndef KEUKA_CLOCK_H
 #define KEUKA_CLOCK_H
 
+#include <errno.h>
+#include <stdint.h>
 #include <time.h>
 
-double get_elapsed_ticks(clock_t);
+#define NSEC_PER_SEC 1000000000ULL
+#define NSEC_PER_MSEC 1000000ULL
+#define NSEC_PER_USEC 1000ULL
+
+/**
+ * Discrete phases of a probe, in order.
+ */
+typedef enum {
+	PHASE_RESOLVE = 0,
+	PHASE_CONNECT,
+	PHASE_HANDSHAKE,
+	PHASE_EXTRACT,
+	NUM_PHASES
+} phase_t;
+
+/**
+ * Monotonic begin/end timestamps (in nanoseconds)
+ * per phase. A zero timestamp means not reached.
+ */
+typedef struct {
+	uint64_t start;
+	uint64_t begin[NUM_PHASES];
+	uint64_t end[NUM_PHASES];
+} timing_t;
+
+uint64_t clock_now(void);
+double get_elapsed_time(uint64_t);
+void clock_sleep(uint64_t);
+
+void timing_init(timing_t *);
+void timing_begin(timing_t *, phase_t);
+void timing_end(timing_t *, phase_t);
+uint64_t timing_duration(const timing_t *, phase_t);
+uint64_t timing_total(const timing_t *);
+const char *phase_name(phase_t);
 
 #endif /* KEUKA_CLOCK_H */
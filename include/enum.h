@@ -0,0 +1,96 @@
+/**
+ * enum.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_ENUM_H
+#define KEUKA_ENUM_H
+
+#include "common.h"
+#include "argv.h"
+#include "buf.h"
+#include "clock.h"
+#include "error.h"
+#include "event.h"
+#include "format.h"
+#include "mem.h"
+#include "probe.h"
+#include "resolve.h"
+#include "sock.h"
+#include "ssl.h"
+#include "target.h"
+#include "utils.h"
+
+#define NUM_ENUM_VERSIONS NUM_METHODS
+#define ENUM_CIPHERSUITES "TLS_AES_256_GCM_SHA384:TLS_CHACHA20_POLY1305_SHA256:" \
+                          "TLS_AES_128_GCM_SHA256:TLS_AES_128_CCM_SHA256:TLS_AES_128_CCM_8_SHA256"
+
+/**
+ * Protocol version to enumerate, with the cipher
+ * suites we're able to offer under it.
+ */
+typedef struct {
+	int version;
+	const char *name;
+	const SSL_CIPHER **ciphers;
+	int nciphers;
+} enum_version_t;
+
+typedef struct enum_run enum_run_t;
+
+/**
+ * Target being enumerated. Versions are tried first,
+ * each with every suite offered, then each suite on
+ * its own, for the versions the server accepted.
+ */
+typedef struct {
+	enum_run_t *run;
+	target_t target;
+	uint64_t start;
+	int pending;
+	int handshakes;
+	int reached;
+	probe_error_t error;
+	int accepted[NUM_ENUM_VERSIONS];
+	unsigned char *ciphers[NUM_ENUM_VERSIONS];
+} enum_host_t;
+
+/**
+ * Handshake to attempt, offering one version and
+ * either one cipher suite, or all (if cipher is -1).
+ */
+typedef struct enum_task {
+	enum_host_t *host;
+	int version;
+	int cipher;
+	struct enum_task *next;
+} enum_task_t;
+
+/**
+ * Drives handshakes for every target in a list
+ * concurrently, from a single event loop, with
+ * at most limit in flight across all targets.
+ */
+struct enum_run {
+	settings_t *settings;
+	target_list_t *list;
+	BIO *bp;
+	SSL_CTX *ctx;
+	ev_loop_t *loop;
+	resolver_t *resolver;
+	buf_t *buf;
+	enum_version_t versions[NUM_ENUM_VERSIONS];
+	int nversions;
+	enum_task_t *head;
+	enum_task_t *tail;
+	int hosts;
+	int inflight;
+	int limit;
+	int eof;
+	long failed;
+};
+
+int enum_run(settings_t *, target_list_t *, BIO *);
+
+#endif /* KEUKA_ENUM_H */
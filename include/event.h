@@ -0,0 +1,73 @@
+/**
+ * event.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_EVENT_H
+#define KEUKA_EVENT_H
+
+#include <poll.h>
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+#include "common.h"
+#include "clock.h"
+#include "error.h"
+#include "mem.h"
+#include "utils.h"
+
+#define EV_READ 1
+#define EV_WRITE 2
+#define EV_ERROR 4
+
+#define EV_MAX_EVENTS 256
+
+typedef struct ev_loop ev_loop_t;
+typedef struct ev_watch ev_watch_t;
+
+typedef struct ev_timer ev_timer_t;
+
+typedef void (*ev_cb_t)(ev_watch_t *, int);
+typedef void (*ev_timer_cb_t)(ev_timer_t *);
+
+/**
+ * A file descriptor registered with the loop. Watches
+ * are owned (usually embedded) by the caller, and must
+ * be removed via ev_del before their memory is reused.
+ */
+struct ev_watch {
+	int fd;
+	int events;
+	int slot;
+	ev_cb_t cb;
+	void *arg;
+};
+
+/**
+ * A one-shot timer, fired from ev_wait once its
+ * deadline passes. Like watches, timers are owned
+ * by the caller and must be stopped before reuse.
+ */
+struct ev_timer {
+	uint64_t when;
+	int slot;
+	ev_timer_cb_t cb;
+	void *arg;
+};
+
+ev_loop_t *ev_new(void);
+void ev_free(ev_loop_t *);
+void ev_set(ev_watch_t *, int, ev_cb_t, void *);
+int ev_add(ev_loop_t *, ev_watch_t *, int);
+int ev_mod(ev_loop_t *, ev_watch_t *, int);
+int ev_del(ev_loop_t *, ev_watch_t *);
+int ev_count(ev_loop_t *);
+int ev_wait(ev_loop_t *, int);
+
+void ev_timer_set(ev_timer_t *, ev_timer_cb_t, void *);
+void ev_timer_start(ev_loop_t *, ev_timer_t *, uint64_t);
+void ev_timer_stop(ev_loop_t *, ev_timer_t *);
+int ev_timer_active(ev_timer_t *);
+
+#endif /* KEUKA_EVENT_H */
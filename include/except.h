@@ -31,11 +31,16 @@ enum {
 	Except_finalized
 };
 
+/**
+ * Each thread raises and handles its own exceptions.
+ */
 #ifdef WIN32
-__declspec(thread)
+#define EXCEPT_THREAD __declspec(thread)
+#else
+#define EXCEPT_THREAD __thread
 #endif
 
-extern Except_Frame *Except_stack;
+extern EXCEPT_THREAD Except_Frame *Except_stack;
 extern const Except_T Assert_Failed;
 
 void Except_raise(const T *e, const char *file, int line);
@@ -11,4 +11,11 @@
 #define KEUKA_INBOUND_INDICATOR "<--"
 #define KEUKA_NEUTRAL_INDICATOR "---"
 
+/**
+ * Output formats, as given with --format.
+ */
+#define FORMAT_TEXT 0
+#define FORMAT_NDJSON 1
+#define FORMAT_BIN 2
+
 #endif /* KEUKA_FORMAT_H */
@@ -0,0 +1,44 @@
+/**
+ * hist.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_HIST_H
+#define KEUKA_HIST_H
+
+#include <stdint.h>
+#include "common.h"
+#include "mem.h"
+
+/**
+ * Log-linear buckets, in the style of HdrHistogram.
+ * Each power of two range is split in HIST_SUB_COUNT / 2
+ * linear sub-buckets, so values are recorded to within
+ * 1/64 (~1.6%) of their actual value, in fixed memory.
+ */
+#define HIST_SUB_BITS 7
+#define HIST_SUB_COUNT (1 << HIST_SUB_BITS)
+#define HIST_HALF_COUNT (HIST_SUB_COUNT / 2)
+#define HIST_MAX_BITS 42
+#define HIST_MAX_VALUE ((1ULL << HIST_MAX_BITS) - 1)
+#define HIST_NUM_COUNTS (HIST_SUB_COUNT + ((HIST_MAX_BITS - HIST_SUB_BITS) * HIST_HALF_COUNT))
+
+typedef struct {
+	uint64_t total;
+	uint64_t sum;
+	uint64_t min;
+	uint64_t max;
+	uint32_t counts[HIST_NUM_COUNTS];
+} hist_t;
+
+hist_t *hist_new(void);
+void hist_free(hist_t *);
+void hist_reset(hist_t *);
+void hist_record(hist_t *, uint64_t);
+void hist_merge(hist_t *, const hist_t *);
+uint64_t hist_percentile(const hist_t *, double);
+uint64_t hist_mean(const hist_t *);
+uint64_t hist_count(const hist_t *, uint64_t);
+
+#endif /* KEUKA_HIST_H */
@@ -0,0 +1,69 @@
+/**
+ * load.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_LOAD_H
+#define KEUKA_LOAD_H
+
+#include <pthread.h>
+#include "common.h"
+#include "argv.h"
+#include "clock.h"
+#include "error.h"
+#include "event.h"
+#include "format.h"
+#include "hist.h"
+#include "mem.h"
+#include "probe.h"
+#include "resolve.h"
+#include "sock.h"
+#include "ssl.h"
+#include "target.h"
+#include "utils.h"
+
+/**
+ * Intervals, in milliseconds.
+ */
+#define LOAD_REPORT_INTERVAL 1000
+#define LOAD_POLL_INTERVAL 100
+#define LOAD_DRAIN_TIMEOUT 1000
+
+typedef struct load load_t;
+
+/**
+ * Worker thread, with its own SSL context, event loop
+ * and resolver, opening handshakes against the target
+ * as fast as allowed. Results are kept under lock, and
+ * collected by the main thread once per interval.
+ */
+typedef struct {
+	pthread_t thread;
+	load_t *load;
+	SSL_CTX *ctx;
+	ev_loop_t *loop;
+	resolver_t *resolver;
+	probe_t **probes;
+	int limit;
+	int inflight;
+	uint64_t period;
+	uint64_t next;
+	pthread_mutex_t lock;
+	hist_t *hist;
+	long ok;
+	long failed;
+} worker_t;
+
+struct load {
+	settings_t *settings;
+	target_t target;
+	BIO *bp;
+	int nworkers;
+	worker_t *workers;
+	int stop;
+};
+
+int load_run(settings_t *, const target_t *, BIO *);
+
+#endif /* KEUKA_LOAD_H */
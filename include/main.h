@@ -16,5 +16,11 @@
 #include "sock.h"
 #include "ssl.h"
 #include "clock.h"
+#include "enum.h"
+#include "load.h"
+#include "scan.h"
+#include "sweep.h"
+#include "target.h"
+#include "trace.h"
 
 #endif /* KEUKA_MAIN_H */
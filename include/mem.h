@@ -7,11 +7,91 @@
 #ifndef KEUKA_MEM_H
 #define KEUKA_MEM_H
 
+#include <pthread.h>
+#include <stdint.h>
+#include <openssl/crypto.h>
 #include "common.h"
 #include "assert.h"
 #include "except.h"
 #include "utils.h"
 
+#define MEM_ALIGN 16
+#define MEM_CHUNK_SIZE 16384
+#define MEM_ARENA_MAX_ALLOC (MEM_CHUNK_SIZE / 4)
+#define MEM_ARENA_SPARES 1024
+#define MEM_SITES 4096
+#define MEM_TOP_SITES 20
+
+/**
+ * What Mem_arena_init turns on.
+ */
+#define MEM_ARENAS 1
+#define MEM_STATS 2
+
+typedef struct mem_chunk mem_chunk_t;
+typedef struct mem_site mem_site_t;
+typedef struct mem_arena mem_arena_t;
+
+/**
+ * Header in front of every allocation once arenas or
+ * stats are enabled, naming the chunk it was carved
+ * from (NULL if it came from malloc), and the arena
+ * and call site it's accounted to.
+ */
+typedef struct {
+	mem_chunk_t *chunk;
+	mem_arena_t *arena;
+	mem_site_t *site;
+	size_t size;
+} mem_header_t;
+
+/**
+ * Fixed-size block allocations are bumped out of. The
+ * count of live allocations includes one held by the
+ * arena, so the chunk goes back to the spares once
+ * the arena is released and everything in it freed,
+ * whichever happens last.
+ */
+struct mem_chunk {
+	mem_chunk_t *next;
+	void *arena;
+	long live;
+	size_t used;
+};
+
+/**
+ * Allocations made and bytes still live, either
+ * overall, at one call site, or for one probe.
+ */
+typedef struct {
+	long allocs;
+	long frees;
+	long bytes;
+	long live;
+	long peak;
+} mem_tally_t;
+
+/**
+ * Call site allocations are accounted to.
+ */
+struct mem_site {
+	const char *file;
+	int line;
+	mem_tally_t tally;
+};
+
+/**
+ * Region of memory for allocations made on behalf of
+ * one probe, released in one shot when it's done. The
+ * arena itself sticks around until everything that
+ * was accounted to it has been freed.
+ */
+struct mem_arena {
+	mem_chunk_t *chunks;
+	long refs;
+	mem_tally_t tally;
+};
+
 extern const Except_T Mem_Failed;
 
 extern void *Mem_alloc(long nbytes, const char *file, int line);
@@ -19,6 +99,13 @@ extern void *Mem_calloc(long count, long nbytes, const char *file, int line);
 extern void Mem_free(void *ptr, const char *file, int line);
 extern void *Mem_resize(void *ptr, long nbytes, const char *file, int line);
 
+extern int Mem_arena_init(int flags);
+extern mem_arena_t *Mem_arena_new(void);
+extern void Mem_arena_free(mem_arena_t *arena);
+extern mem_arena_t *Mem_arena_enter(mem_arena_t *arena);
+extern void Mem_arena_leave(mem_arena_t *previous);
+extern void Mem_stats_print(FILE *fp);
+
 #define ALLOC(nbytes)         Mem_alloc((nbytes), __FILE__, __LINE__)
 #define CALLOC(count, nbytes) Mem_calloc((count), (nbytes), __FILE__, __LINE__)
 #define NEW(p)                ((p) = ALLOC((long)sizeof *(p)))
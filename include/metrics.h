@@ -0,0 +1,87 @@
+/**
+ * metrics.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_METRICS_H
+#define KEUKA_METRICS_H
+
+#include "common.h"
+#include "buf.h"
+#include "clock.h"
+#include "error.h"
+#include "event.h"
+#include "hist.h"
+#include "mem.h"
+#include "probe.h"
+#include "sock.h"
+#include "ssl.h"
+#include "utils.h"
+
+/**
+ * How often the metrics file is rewritten, in seconds.
+ */
+#define METRICS_INTERVAL 10
+
+#define METRICS_MAX_LABELS 64
+#define METRICS_MAX_LABEL 64
+#define METRICS_MAX_REQUEST 4096
+
+/**
+ * Count of probes by a label, e.g. negotiated protocol.
+ */
+typedef struct {
+	char name[METRICS_MAX_LABEL];
+	uint64_t count;
+} metrics_label_t;
+
+typedef struct metrics metrics_t;
+
+/**
+ * Scrape in progress on the metrics port. The
+ * request is read (and ignored) before the reply
+ * is written, so closing doesn't reset it.
+ */
+typedef struct metrics_client {
+	metrics_t *metrics;
+	ev_watch_t watch;
+	struct metrics_client *next;
+} metrics_client_t;
+
+/**
+ * Counters and histograms of a scan, kept on the I/O
+ * thread, and exposed in the Prometheus text format,
+ * either written to a file every METRICS_INTERVAL
+ * seconds (and once more when done), or served on a
+ * loopback port, or both. Latency histograms are of
+ * each phase, then of the total, in nanoseconds.
+ */
+struct metrics {
+	ev_loop_t *loop;
+	const char *path;
+	int fd;
+	ev_watch_t watch;
+	ev_timer_t timer;
+	metrics_client_t *clients;
+	buf_t *buf;
+	uint64_t started;
+	uint64_t completed;
+	uint64_t cached;
+	uint64_t failed[NUM_PHASES][NUM_PROBE_ERRORS];
+	uint64_t bytes_read;
+	uint64_t bytes_written;
+	hist_t *latency[NUM_PHASES + 1];
+	metrics_label_t protocols[METRICS_MAX_LABELS];
+	int nprotocols;
+	metrics_label_t ciphers[METRICS_MAX_LABELS];
+	int nciphers;
+};
+
+metrics_t *metrics_new(ev_loop_t *, const char *, int);
+void metrics_free(metrics_t *);
+void metrics_started(metrics_t *);
+void metrics_cached(metrics_t *);
+void metrics_done(metrics_t *, const probe_t *);
+
+#endif /* KEUKA_METRICS_H */
@@ -0,0 +1,72 @@
+/**
+ * pool.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_POOL_H
+#define KEUKA_POOL_H
+
+#include <pthread.h>
+#include "common.h"
+#include "error.h"
+#include "mem.h"
+#include "utils.h"
+
+#define POOL_DEQUE_SIZE 64
+
+typedef void (*pool_fn_t)(void *);
+
+typedef struct {
+	pool_fn_t fn;
+	void *arg;
+} pool_task_t;
+
+/**
+ * Ring buffer of tasks. The owning worker takes from
+ * the bottom (newest first), while idle workers steal
+ * from the top (oldest first).
+ */
+typedef struct {
+	pthread_mutex_t lock;
+	pool_task_t *tasks;
+	int cap;
+	int head;
+	int count;
+} pool_deque_t;
+
+typedef struct pool pool_t;
+
+typedef struct {
+	pthread_t thread;
+	pool_t *pool;
+	int id;
+	unsigned int seed;
+	pool_deque_t deque;
+} pool_worker_t;
+
+/**
+ * Work-stealing thread pool. Tasks are spread over the
+ * workers' deques, and a worker whose deque runs dry
+ * steals from the others before going to sleep.
+ */
+struct pool {
+	int nworkers;
+	int started;
+	pool_worker_t *workers;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t idle;
+	int queued;
+	int pending;
+	int max;
+	int next;
+	int stop;
+};
+
+pool_t *pool_new(int, int);
+void pool_submit(pool_t *, pool_fn_t, void *);
+void pool_wait(pool_t *);
+void pool_free(pool_t *);
+
+#endif /* KEUKA_POOL_H */
@@ -0,0 +1,201 @@
+/**
+ * probe.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_PROBE_H
+#define KEUKA_PROBE_H
+
+#include "common.h"
+#include "clock.h"
+#include "error.h"
+#include "event.h"
+#include "mem.h"
+#include "resolve.h"
+#include "sock.h"
+#include "ssl.h"
+#include "target.h"
+#include "utils.h"
+
+#define MAX_ADDR_LENGTH 46
+
+/**
+ * Happy Eyeballs (RFC 8305) parameters, in milliseconds.
+ */
+#define CONNECT_ATTEMPT_DELAY 250
+#define RESOLUTION_DELAY 50
+#define MAX_ATTEMPTS (RESOLVE_MAX_ADDRS * 2)
+
+/**
+ * How long to wait for a TLS 1.3 session ticket
+ * after the handshake, in milliseconds.
+ */
+#define TICKET_TIMEOUT 250
+
+/**
+ * Address family slots, in order of preference.
+ */
+enum {
+	FAMILY_INET6 = 0,
+	FAMILY_INET,
+	NUM_FAMILIES
+};
+
+typedef enum {
+	PROBE_INIT = 0,
+	PROBE_RESOLVE,
+	PROBE_HELD,
+	PROBE_CONNECT,
+	PROBE_HANDSHAKE,
+	PROBE_TICKET,
+	PROBE_DONE,
+	PROBE_FAILED
+} probe_state_t;
+
+typedef enum {
+	PROBE_OK = 0,
+	PROBE_ERR_RESOLVE,
+	PROBE_ERR_CONNECT,
+	PROBE_ERR_ATTACH,
+	PROBE_ERR_HANDSHAKE,
+	PROBE_ERR_CONNECT_TIMEOUT,
+	PROBE_ERR_HANDSHAKE_TIMEOUT,
+	PROBE_ERR_DEADLINE,
+	NUM_PROBE_ERRORS
+} probe_error_t;
+
+/**
+ * Progress notifications delivered to the owner
+ * of a probe as it moves through its states.
+ */
+enum {
+	PROBE_NOTE_CONNECT = 0,
+	PROBE_NOTE_CONNECTED,
+	PROBE_NOTE_ATTACH,
+	PROBE_NOTE_HANDSHAKE,
+	PROBE_NOTE_COMPLETE,
+	PROBE_NOTE_RESUME
+};
+
+typedef struct probe probe_t;
+
+typedef void (*probe_cb_t)(probe_t *, int);
+
+/**
+ * Asked before a probe first connects, with the
+ * address it's about to connect to. Returns 0 to
+ * hold the probe back, until probe_resume.
+ */
+typedef int (*probe_admit_t)(probe_t *, const resolve_addr_t *);
+
+typedef enum {
+	ATTEMPT_PENDING = 0,
+	ATTEMPT_CONNECTED,
+	ATTEMPT_FAILED,
+	ATTEMPT_CANCELLED
+} attempt_status_t;
+
+/**
+ * Progress of a chain of handshakes against the
+ * same target, used to measure session resumption.
+ * Round 0 is the initial full handshake.
+ */
+typedef struct {
+	int round;
+	int reused;
+	uint64_t full;
+	uint64_t resumed;
+} resume_t;
+
+/**
+ * Version and cipher suite the server picked, as read
+ * from its ServerHello (zero until one has arrived).
+ */
+typedef struct {
+	int version;
+	int cipher;
+} hello_t;
+
+/**
+ * A single connection attempt to one of the
+ * addresses of a target. Attempts are raced,
+ * the first one to connect wins.
+ */
+typedef struct {
+	resolve_addr_t addr;
+	char name[MAX_ADDR_LENGTH];
+	int fd;
+	int error;
+	attempt_status_t status;
+	uint64_t begin;
+	uint64_t end;
+	ev_watch_t watch;
+	probe_t *probe;
+} attempt_t;
+
+/**
+ * A single connect + handshake against a target,
+ * driven to completion by readiness events.
+ */
+struct probe {
+	target_t target;
+	probe_state_t state;
+	probe_error_t error;
+	int fd;
+	int no_sni;
+	int connect_timeout;
+	int handshake_timeout;
+	int deadline;
+	int resume;
+	int version;
+	const char *ciphers;
+	int hello_only;
+	hello_t hello;
+	int cert_only;
+	int captured;
+	STACK_OF(X509) *received;
+	const resolve_addr_t *pinned;
+	SSL *ssl;
+	SSL_SESSION *session;
+	SSL_SESSION *ticket;
+	SSL_CTX *ctx;
+	mem_arena_t *arena;
+	ev_loop_t *loop;
+	resolver_t *resolver;
+	ev_watch_t watch;
+	ev_timer_t timer;
+	ev_timer_t expiry;
+	ev_timer_t overdue;
+	char addr[MAX_ADDR_LENGTH];
+	resolve_addr_t addrs[NUM_FAMILIES][RESOLVE_MAX_ADDRS];
+	int naddrs[NUM_FAMILIES];
+	int cursor[NUM_FAMILIES];
+	int lookups;
+	int family;
+	attempt_t attempts[MAX_ATTEMPTS];
+	int nattempts;
+	int active;
+	resume_t rounds;
+	timing_t timing;
+	probe_cb_t notify;
+	probe_admit_t admit;
+	int admitted;
+	uint64_t held;
+	void *arg;
+	void *chain;
+	void *entry;
+	void *slot;
+};
+
+probe_t *probe_new(const target_t *, SSL_CTX *, ev_loop_t *, resolver_t *);
+void probe_start(probe_t *);
+void probe_resume(probe_t *);
+void probe_free(probe_t *);
+int probe_session(SSL *, SSL_SESSION *);
+int probe_certificate(X509_STORE_CTX *, void *);
+const SSL_CIPHER *probe_cipher(const SSL *);
+STACK_OF(X509) *probe_chain(const SSL *);
+const char *probe_error_name(probe_error_t);
+
+#endif /* KEUKA_PROBE_H */
@@ -0,0 +1,75 @@
+/**
+ * record.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_RECORD_H
+#define KEUKA_RECORD_H
+
+#include <stdint.h>
+#include <arpa/inet.h>
+#include <openssl/sha.h>
+#include "common.h"
+#include "argv.h"
+#include "buf.h"
+#include "cert.h"
+#include "clock.h"
+#include "error.h"
+#include "format.h"
+#include "mem.h"
+#include "probe.h"
+#include "report.h"
+#include "ssl.h"
+#include "target.h"
+#include "utils.h"
+
+/**
+ * Binary result format, as written with --format bin.
+ *
+ * The stream starts with RECORD_MAGIC, followed by records,
+ * each a 32-bit length (of what follows it), a type byte and
+ * the body. All integers are in network byte order.
+ *
+ * A cert record (index, DER) is written the first time a
+ * certificate is seen, probe records refer to it by index:
+ *
+ *   u8 error, u8 resumed, u16 round, u16 version, u16 cipher,
+ *   u8 family, u8 addr[16], NUM_PHASES x (u32 begin, u32 end)
+ *   in microseconds since the start of the probe, u16 name
+ *   length, name, u8 chain length, u32 cert index per cert.
+ */
+#define RECORD_MAGIC "KEUKAB\0\1"
+#define RECORD_MAGIC_LENGTH 8
+#define RECORD_CERT 1
+#define RECORD_PROBE 2
+#define RECORD_MAX_CHAIN 255
+#define RECORD_MAX_LENGTH (16 * 1024 * 1024)
+#define RECORD_UNSET 0xFFFFFFFFU
+#define RECORD_NO_ROUND 0xFFFF
+#define RECORD_CERTS_SIZE 1024
+
+typedef struct {
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	uint32_t index;
+	int used;
+} record_slot_t;
+
+/**
+ * Certificates written so far, by SHA-256 digest
+ * (as in the batch certificate cache), so each
+ * one is only stored once per stream.
+ */
+typedef struct {
+	record_slot_t *slots;
+	size_t size;
+	uint32_t count;
+} record_certs_t;
+
+record_certs_t *record_certs_new(void);
+void record_certs_free(record_certs_t *);
+void record_header(buf_t *);
+void record_probe(buf_t *, record_certs_t *, const probe_t *, int);
+int record_decode(settings_t *, const char *, BIO *);
+
+#endif /* KEUKA_RECORD_H */
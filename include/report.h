@@ -0,0 +1,63 @@
+/**
+ * report.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_REPORT_H
+#define KEUKA_REPORT_H
+
+#include "common.h"
+#include "buf.h"
+#include "cert.h"
+#include "clock.h"
+#include "argv.h"
+#include "error.h"
+#include "format.h"
+#include "mem.h"
+#include "probe.h"
+#include "ssl.h"
+#include "store.h"
+#include "utils.h"
+
+/**
+ * Outcome of a probe, as reported. It is filled in
+ * either from a live session, or from a record read
+ * back with --decode. The round is -1 unless --resume
+ * was given, the error is NULL unless the probe failed.
+ * With a cache, certificates are put in by reference
+ * and only expanded when the report is written out.
+ * With --since, changes are relative to the previous
+ * result, if there was one. With --verify, the chain
+ * is verified, and the error is NULL if it passed.
+ */
+typedef struct {
+	const char *name;
+	const char *host;
+	int port;
+	const char *addr;
+	int round;
+	const char *error;
+	const char *method;
+	const char *cipher;
+	int resumed;
+	STACK_OF(X509) *chain;
+	cert_cache_t *cache;
+	cert_refs_t *refs;
+	int changes;
+	const store_slot_t *previous;
+	int verified;
+	const char *verify_error;
+} report_t;
+
+void report_session(report_t *, SSL *);
+void report_outcome(BIO *, const report_t *, probe_error_t, int, int, double);
+int report_text(BIO *, const report_t *, settings_t *, const char *);
+void report_timing(BIO *, const timing_t *);
+void report_memory(BIO *, const mem_tally_t *);
+void report_changes(BIO *, const report_t *);
+void report_json(buf_t *, BIO *, const report_t *);
+void report_json_memory(buf_t *, const mem_tally_t *);
+void report_json_timing(buf_t *, const timing_t *);
+
+#endif /* KEUKA_REPORT_H */
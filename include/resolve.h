@@ -0,0 +1,65 @@
+/**
+ * resolve.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_RESOLVE_H
+#define KEUKA_RESOLVE_H
+
+#include "common.h"
+#include "argv.h"
+#include "clock.h"
+#include "error.h"
+#include "event.h"
+#include "mem.h"
+#include "sock.h"
+#include "ssl.h"
+#include "utils.h"
+
+#define RESOLV_CONF "/etc/resolv.conf"
+#define HOSTS_FILE "/etc/hosts"
+
+#define RESOLVE_PORT 53
+#define RESOLVE_BUFSIZE 1232
+#define RESOLVE_MAX_ADDRS 16
+#define RESOLVE_MAX_LINE 1024
+#define RESOLVE_TIMEOUT 1000
+#define RESOLVE_REFUSED_BACKOFF 100
+#define RESOLVE_RETRIES 3
+#define RESOLVE_MAX_TTL 86400
+#define RESOLVE_NEG_TTL 60
+#define RESOLVE_FALLBACK_TTL 60
+#define RESOLVE_MAX_SERVERS 3
+#define RESOLVE_MAX_SEARCH 6
+#define RESOLVE_NDOTS 1
+#define RESOLVE_MAX_NDOTS 15
+
+enum {
+	RESOLVE_OK = 0,
+	RESOLVE_NXDOMAIN,
+	RESOLVE_FAIL
+};
+
+typedef struct {
+	int family;
+	unsigned char addr[16];
+} resolve_addr_t;
+
+typedef struct {
+	int count;
+	resolve_addr_t addrs[RESOLVE_MAX_ADDRS];
+} resolve_result_t;
+
+typedef struct resolver resolver_t;
+
+typedef void (*resolve_cb_t)(void *, int, const resolve_result_t *);
+
+resolver_t *resolver_new(ev_loop_t *, const char *);
+void resolver_free(resolver_t *);
+void resolver_lookup(resolver_t *, const char *, int, resolve_cb_t, void *);
+void resolver_cancel(resolver_t *, const char *, int, resolve_cb_t, void *);
+int resolve_literal(const char *, resolve_addr_t *);
+int resolve_sockaddr(const resolve_addr_t *, int, struct sockaddr_storage *, socklen_t *);
+
+#endif /* KEUKA_RESOLVE_H */
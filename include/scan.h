@@ -0,0 +1,117 @@
+/**
+ * scan.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_SCAN_H
+#define KEUKA_SCAN_H
+
+#include "common.h"
+#include "argv.h"
+#include "buf.h"
+#include "clock.h"
+#include "error.h"
+#include "event.h"
+#include "format.h"
+#include "hist.h"
+#include "metrics.h"
+#include "pool.h"
+#include "probe.h"
+#include "record.h"
+#include "report.h"
+#include "resolve.h"
+#include "throttle.h"
+#include "ssl.h"
+#include "store.h"
+#include "target.h"
+#include "trace.h"
+#include "utils.h"
+#include "verify.h"
+#include "watch.h"
+
+/**
+ * Reusable buffers for reports in a --format other
+ * than text (and for expanding certificate references),
+ * kept on a free list so there's one per rendering
+ * thread, rather than one per probe.
+ */
+typedef struct output {
+	buf_t *buf;
+	buf_t *expanded;
+	BIO *scratch;
+	struct output *next;
+} output_t;
+
+/**
+ * Drives probes for every target in a list
+ * concurrently, from a single event loop.
+ */
+typedef struct {
+	settings_t *settings;
+	target_list_t *list;
+	BIO *bp;
+	SSL_CTX *ctx;
+	ev_loop_t *loop;
+	resolver_t *resolver;
+	pool_t *pool;
+	pthread_mutex_t lock;
+	output_t *outputs;
+	record_certs_t *certs;
+	cert_cache_t *cache;
+	store_t *store;
+	store_t *snapshot;
+	watch_t *watch;
+	verify_t *verify;
+	metrics_t *metrics;
+	throttle_t *throttle;
+	resolve_addr_t addr;
+	int port;
+	uint64_t start;
+	int progress;
+	int inflight;
+	int limit;
+	int eof;
+	long completed;
+	long failed;
+} scan_t;
+
+/**
+ * Latency distribution of repeated probes
+ * of one target, as requested with --count.
+ * The last histogram is of the total time.
+ */
+typedef struct {
+	scan_t *scan;
+	target_t target;
+	int done;
+	int failed;
+	ev_timer_t timer;
+	hist_t *hists[NUM_PHASES + 1];
+} series_t;
+
+/**
+ * Report of a finished probe, rendered into bp
+ * either inline or on the worker pool. The series
+ * is only set on its last repeat. The outcome of
+ * verification is -1 until the chain is verified.
+ */
+typedef struct {
+	scan_t *scan;
+	probe_t *probe;
+	series_t *series;
+	BIO *bp;
+	int first;
+	int chained;
+	int issued;
+	int reused;
+	cert_refs_t refs;
+	int changes;
+	int known;
+	store_slot_t previous;
+	int verify;
+} scan_job_t;
+
+int scan_run(settings_t *, target_list_t *, BIO *);
+
+#endif /* KEUKA_SCAN_H */
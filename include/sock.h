@@ -7,16 +7,22 @@
 #ifndef KEUKA_SOCK_H
 #define KEUKA_SOCK_H
 
+#include <sys/resource.h>
 #include <sys/socket.h>
 #include <resolv.h>
 #include <netdb.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include "common.h"
+#include "argv.h"
 #include "error.h"
 #include "ssl.h"
 #include "utils.h"
 
-int mksock(char *, BIO *);
+int sock_connect(const struct sockaddr *, socklen_t);
+int sock_error(int);
+const char *sock_ntop(const struct sockaddr *, char *, size_t);
+void sock_rlimit(int);
+int sock_listen(int);
 
 #endif /* KEUKA_SOCK_H */
@@ -15,4 +15,12 @@
 #include <openssl/x509_vfy.h>
 #include <openssl/opensslv.h>
 
+/**
+ * TLS 1.3 cipher suites, ASN1_TIME_to_tm, and the
+ * 1.1 accessors used throughout need 1.1.1 at least.
+ */
+#if OPENSSL_VERSION_NUMBER < 0x10101000L
+#error "keuka requires OpenSSL 1.1.1 or later"
+#endif
+
 #endif /* KEUKA_SSL_H */
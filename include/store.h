@@ -0,0 +1,99 @@
+/**
+ * store.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_STORE_H
+#define KEUKA_STORE_H
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <openssl/sha.h>
+#include "common.h"
+#include "cert.h"
+#include "error.h"
+#include "mem.h"
+#include "probe.h"
+#include "ssl.h"
+#include "target.h"
+#include "utils.h"
+
+#define STORE_MAGIC "KEUKAST\1"
+#define STORE_MAGIC_LENGTH 8
+#define STORE_VERSION 1
+#define STORE_SLOTS 4096
+#define STORE_KEY_LENGTH 16
+#define STORE_METHOD_LENGTH 16
+#define STORE_CIPHER_LENGTH 64
+#define STORE_MAX_KEY (MAX_HOSTNAME_LENGTH * 2 + MAX_PORT_LENGTH + 2)
+
+/**
+ * Ways a result can differ from the one before it.
+ */
+enum {
+	STORE_NEW_HOST = 1,
+	STORE_NEW_CERT = 2,
+	STORE_NEW_ISSUER = 4,
+	STORE_NEW_CHAIN = 8,
+	STORE_DOWNGRADE = 16,
+	STORE_UPGRADE = 32,
+	STORE_NEW_CIPHER = 64,
+	STORE_UNREACHABLE = 128,
+	STORE_RECOVERED = 256,
+	NUM_STORE_CHANGES = 9
+};
+
+/**
+ * Last known result for a host:port:SNI. Slots are
+ * addressed by the first bytes of the SHA-256 of
+ * that key, a slot with no checked time is empty.
+ */
+typedef struct {
+	unsigned char key[STORE_KEY_LENGTH];
+	int64_t checked;
+	int64_t not_after;
+	uint32_t issuer;
+	uint16_t version;
+	uint16_t chainlen;
+	char method[STORE_METHOD_LENGTH];
+	char cipher[STORE_CIPHER_LENGTH];
+	unsigned char leaf[SHA256_DIGEST_LENGTH];
+	unsigned char chain[SHA256_DIGEST_LENGTH];
+} store_slot_t;
+
+typedef struct {
+	char magic[STORE_MAGIC_LENGTH];
+	uint32_t version;
+	uint32_t nslots;
+	uint64_t count;
+} store_header_t;
+
+/**
+ * Result store, mapped from a file that's locked
+ * for as long as it's open. Concurrent runs (e.g.
+ * overlapping cron jobs) fail to open it rather
+ * than wait on each other.
+ */
+typedef struct {
+	int fd;
+	int readonly;
+	size_t size;
+	store_header_t *header;
+	store_slot_t *slots;
+} store_t;
+
+store_t *store_open(const char *, int);
+void store_close(store_t *);
+int store_same(store_t *, const char *);
+void store_key(unsigned char *, const target_t *, int);
+store_slot_t *store_find(store_t *, const unsigned char *);
+store_slot_t *store_put(store_t *, const unsigned char *);
+void store_fill(store_slot_t *, SSL *);
+int store_diff(const store_slot_t *, const store_slot_t *);
+const char *store_change_name(int);
+
+#endif /* KEUKA_STORE_H */
@@ -0,0 +1,93 @@
+/**
+ * sweep.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_SWEEP_H
+#define KEUKA_SWEEP_H
+
+#include <openssl/x509v3.h>
+#include "common.h"
+#include "argv.h"
+#include "buf.h"
+#include "cert.h"
+#include "clock.h"
+#include "error.h"
+#include "event.h"
+#include "format.h"
+#include "mem.h"
+#include "probe.h"
+#include "resolve.h"
+#include "sock.h"
+#include "ssl.h"
+#include "target.h"
+#include "utils.h"
+
+#define SWEEP_INITIAL_NAMES 256
+#define SWEEP_INITIAL_BUCKETS 256
+
+typedef struct sweep sweep_t;
+typedef struct sweep_name sweep_name_t;
+
+/**
+ * Names that got back the same leaf certificate,
+ * or (if there's no subject) failed the same way.
+ * Certificate groups are also hashed by digest.
+ */
+typedef struct sweep_group {
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	char fingerprint[CERT_FINGERPRINT_LENGTH + NULL_BYTE];
+	char *subject;
+	probe_error_t error;
+	int count;
+	int order;
+	sweep_name_t *names;
+	struct sweep_group *next;
+	struct sweep_group *bucket_next;
+} sweep_group_t;
+
+/**
+ * Server name probed, and what it got back. Names
+ * the leaf certificate isn't valid for are flagged.
+ */
+struct sweep_name {
+	sweep_t *sweep;
+	char *name;
+	sweep_group_t *group;
+	int mismatch;
+	sweep_name_t *next;
+};
+
+/**
+ * Drives a probe for every server name in a list
+ * concurrently, from a single event loop, all of
+ * them against the one address given.
+ */
+struct sweep {
+	settings_t *settings;
+	target_list_t *list;
+	BIO *bp;
+	SSL_CTX *ctx;
+	ev_loop_t *loop;
+	buf_t *buf;
+	resolve_addr_t addr;
+	int port;
+	sweep_name_t **names;
+	int nnames;
+	int size;
+	sweep_group_t *groups;
+	sweep_group_t **buckets;
+	sweep_group_t *errors[NUM_PROBE_ERRORS];
+	int nbuckets;
+	int ngroups;
+	int certs;
+	int inflight;
+	int limit;
+	int eof;
+	long failed;
+};
+
+int sweep_run(settings_t *, target_list_t *, BIO *);
+
+#endif /* KEUKA_SWEEP_H */
@@ -0,0 +1,43 @@
+/**
+ * target.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_TARGET_H
+#define KEUKA_TARGET_H
+
+#include <arpa/inet.h>
+#include "common.h"
+#include "argv.h"
+#include "mem.h"
+#include "utils.h"
+
+#define DEFAULT_PORT 443
+#define MAX_TARGET_LINE 1024
+
+typedef struct {
+	char name[MAX_URL_LENGTH];
+	char host[MAX_HOSTNAME_LENGTH + NULL_BYTE];
+	int port;
+} target_t;
+
+/**
+ * Source of targets, either a single
+ * hostname or a newline-delimited list.
+ */
+typedef struct {
+	FILE *fp;
+	int owned;
+	long line;
+	long invalid;
+	const char *single;
+} target_list_t;
+
+int target_parse(target_t *, const char *);
+target_list_t *target_open(const char *);
+target_list_t *target_single(const char *);
+int target_next(target_list_t *, target_t *);
+void target_close(target_list_t *);
+
+#endif /* KEUKA_TARGET_H */
@@ -0,0 +1,100 @@
+/**
+ * throttle.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_THROTTLE_H
+#define KEUKA_THROTTLE_H
+
+#include "common.h"
+#include "clock.h"
+#include "error.h"
+#include "event.h"
+#include "mem.h"
+#include "probe.h"
+#include "resolve.h"
+#include "utils.h"
+
+#define THROTTLE_BUCKETS 1024
+
+/**
+ * Prefix lengths destinations are grouped by,
+ * in bits, for IPv4 and IPv6 addresses.
+ */
+#define THROTTLE_PREFIX_INET 24
+#define THROTTLE_PREFIX_INET6 64
+
+/**
+ * Tokens the bucket holds at most, as a fraction
+ * (1/THROTTLE_BURST) of a second's worth at --rate.
+ */
+#define THROTTLE_BURST 10
+
+/**
+ * Probes in flight to an address, or to the
+ * prefix (of bits length) it falls under.
+ */
+typedef struct throttle_dest {
+	int family;
+	int bits;
+	unsigned char addr[16];
+	int count;
+	struct throttle_dest *next;
+} throttle_dest_t;
+
+/**
+ * Probe known to the throttle, either held back,
+ * waiting its turn to connect to addr, or holding
+ * a place with the destinations it went ahead to.
+ */
+typedef struct throttle_entry {
+	probe_t *probe;
+	resolve_addr_t addr;
+	int held;
+	throttle_dest_t *ip;
+	throttle_dest_t *prefix;
+	struct throttle_entry *prev;
+	struct throttle_entry *next;
+} throttle_entry_t;
+
+/**
+ * Decides when each probe of a scan may connect, so
+ * no more than per_ip (or per_prefix) probes are in
+ * flight to the same address (or prefix) at once,
+ * and no more than rate start per second, from a
+ * token bucket. Under --adaptive, the number of
+ * probes in flight is a window that grows by one
+ * per window of successes, and halves when connects
+ * or handshakes fail (at most about once a window,
+ * as only probes started since the last cut count),
+ * staying between 1 and limit.
+ */
+typedef struct {
+	ev_loop_t *loop;
+	int limit;
+	int per_ip;
+	int per_prefix;
+	int rate;
+	int adaptive;
+	double window;
+	uint64_t cut;
+	long cuts;
+	double tokens;
+	double burst;
+	uint64_t refilled;
+	ev_timer_t timer;
+	throttle_entry_t *head;
+	throttle_entry_t *tail;
+	int nheld;
+	throttle_dest_t *buckets[THROTTLE_BUCKETS];
+} throttle_t;
+
+throttle_t *throttle_new(ev_loop_t *, int, int, int, int, int);
+void throttle_free(throttle_t *);
+int throttle_room(throttle_t *, int);
+int throttle_admit(throttle_t *, probe_t *, const resolve_addr_t *);
+void throttle_pump(throttle_t *);
+void throttle_done(throttle_t *, probe_t *);
+
+#endif /* KEUKA_THROTTLE_H */
@@ -0,0 +1,33 @@
+/**
+ * trace.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_TRACE_H
+#define KEUKA_TRACE_H
+
+#include <pthread.h>
+#include "common.h"
+#include "buf.h"
+#include "clock.h"
+#include "error.h"
+#include "mem.h"
+#include "utils.h"
+
+/**
+ * Events recorded by one thread, appended to without
+ * locking, and linked into the list of every thread's
+ * buffer, to be written out together at the end.
+ */
+typedef struct trace_buf {
+	buf_t *buf;
+	int tid;
+	struct trace_buf *next;
+} trace_buf_t;
+
+int trace_open(const char *);
+void trace_event(const char *, const char *, uint64_t, uint64_t, const char *);
+void trace_close(void);
+
+#endif /* KEUKA_TRACE_H */
@@ -0,0 +1,60 @@
+/**
+ * verify.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_VERIFY_H
+#define KEUKA_VERIFY_H
+
+#include <pthread.h>
+#include <openssl/sha.h>
+#include <openssl/x509v3.h>
+#include "common.h"
+#include "cert.h"
+#include "error.h"
+#include "mem.h"
+#include "ssl.h"
+#include "utils.h"
+
+#define VERIFY_CACHE_SIZE 1024
+
+/**
+ * Width of the time buckets verification outcomes
+ * are cached for, in seconds. A chain seen again in
+ * a later bucket is verified again, so expiry (of
+ * the chain or the trust store) is noticed.
+ */
+#define VERIFY_BUCKET 3600
+
+/**
+ * Outcome of verifying a chain, keyed by SHA-256 of
+ * the digests of its certificates, in order, and the
+ * time bucket it was verified in.
+ */
+typedef struct verify_entry {
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	int64_t bucket;
+	int result;
+	struct verify_entry *next;
+} verify_entry_t;
+
+/**
+ * Trust store loaded once and shared by every probe,
+ * with the outcomes of chains verified against it.
+ * The store is safe to verify against from several
+ * threads, the cache is guarded by the lock.
+ */
+typedef struct {
+	X509_STORE *store;
+	verify_entry_t **buckets;
+	size_t size;
+	size_t count;
+	pthread_mutex_t lock;
+} verify_t;
+
+verify_t *verify_new(const char *);
+void verify_free(verify_t *);
+int verify_chain(verify_t *, STACK_OF(X509) *, const char *);
+
+#endif /* KEUKA_VERIFY_H */
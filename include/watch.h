@@ -0,0 +1,66 @@
+/**
+ * watch.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_WATCH_H
+#define KEUKA_WATCH_H
+
+#include "common.h"
+#include "clock.h"
+#include "error.h"
+#include "event.h"
+#include "mem.h"
+#include "store.h"
+#include "target.h"
+#include "utils.h"
+#include "wheel.h"
+
+#define WATCH_MIN_INTERVAL 60
+#define WATCH_MAX_INTERVAL 86400
+#define WATCH_EXPIRED_INTERVAL 900
+#define WATCH_RETRY_INTERVAL 60
+#define WATCH_EXPIRY_DIVISOR 8
+#define WATCH_JITTER_DIVISOR 8
+
+typedef struct watch watch_t;
+
+/**
+ * A target under --watch, with the last result
+ * it's compared to and its timer on the wheel.
+ */
+typedef struct watch_entry {
+	target_t target;
+	watch_t *watch;
+	store_slot_t last;
+	int known;
+	int failures;
+	int64_t stable;
+	wheel_timer_t timer;
+	struct watch_entry *next;
+} watch_entry_t;
+
+/**
+ * Schedule of checks for every target, kept on a
+ * timing wheel that's advanced once a second by a
+ * timer on the event loop. Targets that come due
+ * are queued until there's room to probe them.
+ */
+struct watch {
+	wheel_t wheel;
+	ev_loop_t *loop;
+	ev_timer_t tick;
+	uint64_t origin;
+	watch_entry_t *entries;
+	long count;
+	watch_entry_t *head;
+	watch_entry_t *tail;
+};
+
+watch_t *watch_new(ev_loop_t *, target_list_t *, store_t *, int);
+void watch_free(watch_t *);
+watch_entry_t *watch_next(watch_t *);
+int watch_done(watch_t *, watch_entry_t *, const store_slot_t *);
+
+#endif /* KEUKA_WATCH_H */
@@ -0,0 +1,56 @@
+/**
+ * wheel.h
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#ifndef KEUKA_WHEEL_H
+#define KEUKA_WHEEL_H
+
+#include <stdint.h>
+#include "common.h"
+#include "utils.h"
+
+#define WHEEL_BITS 8
+#define WHEEL_SIZE (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SIZE - 1)
+#define WHEEL_LEVELS 4
+
+typedef struct wheel_timer wheel_timer_t;
+
+typedef void (*wheel_cb_t)(wheel_timer_t *);
+
+/**
+ * A timer on the wheel, due at an absolute tick.
+ * Timers are owned (usually embedded) by the caller,
+ * and linked into the slot they're due in, so adding
+ * and removing one is O(1), however many are pending.
+ */
+struct wheel_timer {
+	wheel_timer_t *next;
+	wheel_timer_t *prev;
+	uint64_t expires;
+	wheel_cb_t cb;
+	void *arg;
+};
+
+/**
+ * Hierarchical timing wheel. Level 0 has a slot per
+ * tick, each level above has a slot per revolution
+ * of the one below, and timers are cascaded down a
+ * level whenever the one below wraps around.
+ */
+typedef struct {
+	uint64_t now;
+	long count;
+	wheel_timer_t slots[WHEEL_LEVELS][WHEEL_SIZE];
+} wheel_t;
+
+void wheel_init(wheel_t *, uint64_t);
+void wheel_timer_set(wheel_timer_t *, wheel_cb_t, void *);
+void wheel_add(wheel_t *, wheel_timer_t *, uint64_t);
+void wheel_del(wheel_t *, wheel_timer_t *);
+int wheel_pending(wheel_timer_t *);
+void wheel_advance(wheel_t *, uint64_t);
+
+#endif /* KEUKA_WHEEL_H */
@@ -9,27 +9,39 @@
 static method_t methods[] = {
 	{
 		"SSLv2",
-		OPT_SSLV2
+		OPT_SSLV2,
+		SSL2_VERSION,
+		"SSLv2"
 	},
 	{
 		"SSLv3",
-		OPT_SSLV3
+		OPT_SSLV3,
+		SSL3_VERSION,
+		"SSLv3"
 	},
 	{
 		"TLSv1",
-		OPT_TLSV1
+		OPT_TLSV1,
+		TLS1_VERSION,
+		"TLSv1"
 	},
 	{
 		"TLSv1_1",
-		OPT_TLSV1_1
+		OPT_TLSV1_1,
+		TLS1_1_VERSION,
+		"TLSv1.1"
 	},
 	{
 		"TLSv1_2",
-		OPT_TLSV1_2
+		OPT_TLSV1_2,
+		TLS1_2_VERSION,
+		"TLSv1.2"
 	},
 	{
 		"TLSv1_3",
-		OPT_TLSV1_3
+		OPT_TLSV1_3,
+		TLS1_3_VERSION,
+		"TLSv1.3"
 	},
 };
 
@@ -94,6 +106,176 @@ static option_t options[] = {
 		"-V",
 		"Show certificate Not Before/Not After validity range."
 	},
+	{
+		"--timing",
+		"-T",
+		"Show per-phase latency breakdown.",
+	},
+	{
+		"--targets FILE",
+		"-t",
+		"Probe each host[:port] in FILE (- for stdin).",
+	},
+	{
+		"--concurrency N",
+		"-j",
+		"Maximum number of probes in flight.",
+	},
+	{
+		"--resolver ADDR",
+		"-R",
+		"Send DNS queries to ADDR[:PORT].",
+	},
+	{
+		"--address",
+		"-a",
+		"Show address connection was made to.",
+	},
+	{
+		"--connect-timeout MS",
+		"-o",
+		"Give up connecting after MS milliseconds.",
+	},
+	{
+		"--handshake-timeout MS",
+		"-H",
+		"Give up on handshake after MS milliseconds.",
+	},
+	{
+		"--deadline MS",
+		"-D",
+		"Give up on each host after MS milliseconds.",
+	},
+	{
+		"--resume N",
+		"-u",
+		"Follow full handshake with N resumed handshakes.",
+	},
+	{
+		"--count N",
+		"-n",
+		"Probe each host N times and show latency percentiles.",
+	},
+	{
+		"--interval MS",
+		"-I",
+		"Wait MS milliseconds between repeated probes.",
+	},
+	{
+		"--load",
+		"-L",
+		"Open handshakes from every core and report throughput.",
+	},
+	{
+		"--rate N",
+		"-p",
+		"Open at most N handshakes per second.",
+	},
+	{
+		"--duration S",
+		"-d",
+		"Run --load for S seconds.",
+	},
+	{
+		"--format FMT",
+		"-f",
+		"Output format: text (default), ndjson or bin.",
+	},
+	{
+		"--decode FILE",
+		"-x",
+		"Render results saved with --format bin.",
+	},
+	{
+		"--cache FILE",
+		"-k",
+		"Keep last result per host in FILE.",
+	},
+	{
+		"--cache-ttl S",
+		"-K",
+		"Skip hosts with a cached result under S seconds old.",
+	},
+	{
+		"--since SNAPSHOT",
+		"-w",
+		"Only report hosts that changed since SNAPSHOT.",
+	},
+	{
+		"--watch",
+		"-W",
+		"Keep rechecking hosts, reporting changes.",
+	},
+	{
+		"--arena",
+		"-M",
+		"Allocate each probe's memory from an arena.",
+	},
+	{
+		"--mem-stats",
+		"-G",
+		"Show allocations per probe and per call site.",
+	},
+	{
+		"--enumerate",
+		"-e",
+		"Enumerate accepted protocol versions and ciphers.",
+	},
+	{
+		"--verify",
+		"-y",
+		"Verify certificate chain and hostname.",
+	},
+	{
+		"--ca-file FILE",
+		"-Y",
+		"Trust certificates in FILE (implies --verify).",
+	},
+	{
+		"--cert-only",
+		"-O",
+		"Stop each handshake once the chain is received.",
+	},
+	{
+		"--metrics-file FILE",
+		"-F",
+		"Write Prometheus metrics to FILE periodically.",
+	},
+	{
+		"--metrics-port PORT",
+		"-P",
+		"Serve Prometheus metrics on localhost PORT.",
+	},
+	{
+		"--trace FILE",
+		"-J",
+		"Write a Chrome trace of probe phases to FILE.",
+	},
+	{
+		"--sni-list FILE",
+		"-l",
+		"Probe each server name in FILE at --connect ADDR.",
+	},
+	{
+		"--connect ADDR",
+		"-E",
+		"Connect to ADDR[:PORT] instead of resolving hosts.",
+	},
+	{
+		"--per-ip N",
+		"-B",
+		"Keep at most N probes in flight to each (first) address.",
+	},
+	{
+		"--per-prefix N",
+		"-Q",
+		"Keep at most N probes in flight to each (first) /24 or /64.",
+	},
+	{
+		"--adaptive",
+		"-U",
+		"Back off concurrency as connects and handshakes fail.",
+	},
 	{
 		"--help",
 		"-h",
@@ -127,6 +309,34 @@ int get_bitmask_from_key (char *key) {
 	return NOT_FOUND;
 }
 
+/**
+ * Get method at index, oldest first,
+ * or NULL if index is out of range.
+ */
+method_t *get_method (int index) {
+	if (index < 0 || index >= NUM_METHODS) {
+		return NULL;
+	}
+
+	return &methods[index];
+}
+
+/**
+ * Get method for protocol version (e.g.
+ * TLS1_2_VERSION), or NULL if unknown.
+ */
+method_t *get_method_from_version (int version) {
+	int index;
+
+	for (index = 0; index < NUM_METHODS; index += 1) {
+		if (methods[index].version == version) {
+			return &methods[index];
+		}
+	}
+
+	return NULL;
+}
+
 /**
  * Print usage information.
  */
@@ -135,7 +345,8 @@ void usage (void) {
 
 	fprintf(
 		stdout,
-		"Usage: keuka [OPTIONS] [--] hostname\n\nOPTIONS:\n"
+		"Usage: keuka [OPTIONS] [--] hostname\n"
+		"       keuka [OPTIONS] --targets FILE\n\nOPTIONS:\n"
 	);
 
 	for (index = 0; index < NUM_OPTIONS; index += 1) {
@@ -0,0 +1,155 @@
+/**
+ * buf.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "buf.h"
+
+/**
+ * Make room for at least extra more bytes.
+ */
+static void buf_reserve (buf_t *buf, size_t extra) {
+	size_t size = buf->size;
+
+	if (buf->len + extra <= size) {
+		return;
+	}
+
+	while (buf->len + extra > size) {
+		size *= 2;
+	}
+
+	RESIZE(buf->data, (long) size);
+	buf->size = size;
+}
+
+buf_t *buf_new (size_t size) {
+	buf_t *buf;
+
+	NEW0(buf);
+	buf->size = size ? size : BUF_INITIAL_SIZE;
+	buf->data = ALLOC((long) buf->size);
+
+	return buf;
+}
+
+void buf_free (buf_t *buf) {
+	if (is_null(buf)) {
+		return;
+	}
+
+	FREE(buf->data);
+	FREE(buf);
+}
+
+void buf_reset (buf_t *buf) {
+	buf->len = 0;
+}
+
+void buf_append (buf_t *buf, const char *data, size_t len) {
+	buf_reserve(buf, len);
+	memcpy(buf->data + buf->len, data, len);
+	buf->len += len;
+}
+
+void buf_puts (buf_t *buf, const char *str) {
+	buf_append(buf, str, strlen(str));
+}
+
+void buf_printf (buf_t *buf, const char *fmt, ...) {
+	int len;
+	va_list args;
+
+	va_start(args, fmt);
+	len = vsnprintf(buf->data + buf->len, buf->size - buf->len, fmt, args);
+	va_end(args);
+
+	if (len < 0) {
+		return;
+	}
+
+	/**
+	 * Didn't fit, so grow and format again.
+	 */
+	if ((size_t) len >= buf->size - buf->len) {
+		buf_reserve(buf, (size_t) len + NULL_BYTE);
+
+		va_start(args, fmt);
+		vsnprintf(buf->data + buf->len, buf->size - buf->len, fmt, args);
+		va_end(args);
+	}
+
+	buf->len += (size_t) len;
+}
+
+/**
+ * Append str as a quoted JSON string, escaping
+ * quotes, backslashes and control characters.
+ */
+void buf_json (buf_t *buf, const char *str, size_t len) {
+	size_t index, start;
+	unsigned char c;
+
+	buf_append(buf, "\"", 1);
+
+	for (index = 0, start = 0; index < len; index += 1) {
+		c = (unsigned char) str[index];
+
+		if (c >= 0x20 && c != '"' && c != '\\') {
+			continue;
+		}
+
+		buf_append(buf, str + start, index - start);
+		start = index + 1;
+
+		switch (c) {
+			case '"':
+				buf_append(buf, "\\\"", 2);
+				break;
+			case '\\':
+				buf_append(buf, "\\\\", 2);
+				break;
+			case '\n':
+				buf_append(buf, "\\n", 2);
+				break;
+			case '\r':
+				buf_append(buf, "\\r", 2);
+				break;
+			case '\t':
+				buf_append(buf, "\\t", 2);
+				break;
+			default:
+				buf_printf(buf, "\\u%04x", c);
+				break;
+		}
+	}
+
+	buf_append(buf, str + start, len - start);
+	buf_append(buf, "\"", 1);
+}
+
+/**
+ * Write contents of buffer to fd, with a single
+ * write(2) unless the kernel takes a short one.
+ */
+int buf_write (buf_t *buf, int fd) {
+	size_t offset = 0;
+	ssize_t count;
+
+	while (offset < buf->len) {
+		count = write(fd, buf->data + offset, buf->len - offset);
+
+		if (is_error(count, -1)) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			return -1;
+		}
+
+		offset += (size_t) count;
+	}
+
+	return 0;
+}
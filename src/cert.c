@@ -0,0 +1,318 @@
+/**
+ * cert.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "cert.h"
+
+/**
+ * Bucket digest falls in. Digests are uniformly
+ * distributed already, so they hash themselves.
+ */
+static size_t cert_bucket (const cert_cache_t *cache, const unsigned char *digest) {
+	uint64_t hash;
+
+	memcpy(&hash, digest, sizeof(hash));
+
+	return (size_t) hash & (cache->size - 1);
+}
+
+static cert_entry_t *cert_find (const cert_cache_t *cache, const unsigned char *digest) {
+	cert_entry_t *entry;
+
+	for (entry = cache->buckets[cert_bucket(cache, digest)]; !is_null(entry); entry = entry->next) {
+		if (!memcmp(entry->digest, digest, SHA256_DIGEST_LENGTH)) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Double the number of buckets once there
+ * are more entries than buckets.
+ */
+static void cert_grow (cert_cache_t *cache) {
+	size_t index, size;
+	cert_entry_t **buckets, *entry, *next;
+
+	if (cache->count < cache->size) {
+		return;
+	}
+
+	buckets = cache->buckets;
+	size = cache->size;
+	cache->size = size * 2;
+	cache->buckets = CALLOC((long) cache->size, (long) sizeof(cert_entry_t *));
+
+	for (index = 0; index < size; index += 1) {
+		for (entry = buckets[index]; !is_null(entry); entry = next) {
+			next = entry->next;
+			entry->next = cache->buckets[cert_bucket(cache, entry->digest)];
+			cache->buckets[cert_bucket(cache, entry->digest)] = entry;
+		}
+	}
+
+	FREE(buckets);
+}
+
+/**
+ * Take entry out of the order of use.
+ */
+static void cert_unlink (cert_cache_t *cache, cert_entry_t *entry) {
+	if (is_null(entry->newer)) {
+		cache->newest = entry->older;
+	} else {
+		entry->newer->older = entry->older;
+	}
+
+	if (is_null(entry->older)) {
+		cache->oldest = entry->newer;
+	} else {
+		entry->older->newer = entry->newer;
+	}
+
+	entry->newer = NULL;
+	entry->older = NULL;
+}
+
+/**
+ * Put entry first in the order of use.
+ */
+static void cert_touch (cert_cache_t *cache, cert_entry_t *entry) {
+	if (cache->newest == entry) {
+		return;
+	}
+
+	if (!is_null(entry->newer) || !is_null(entry->older) || cache->oldest == entry) {
+		cert_unlink(cache, entry);
+	}
+
+	entry->older = cache->newest;
+
+	if (is_null(cache->newest)) {
+		cache->oldest = entry;
+	} else {
+		cache->newest->newer = entry;
+	}
+
+	cache->newest = entry;
+}
+
+static void cert_entry_free (cert_entry_t *entry) {
+	FREE(entry->full);
+	FREE(entry->ref);
+	FREE(entry);
+}
+
+/**
+ * Drop least recently used entries no report is
+ * waiting on, until the cache is within its limit.
+ * If every entry is pinned, it stays over for now.
+ */
+static void cert_evict (cert_cache_t *cache) {
+	cert_entry_t *entry, *next, **link;
+
+	for (entry = cache->oldest; !is_null(entry) && cache->count > cache->limit; entry = next) {
+		next = entry->newer;
+
+		if (entry->pins > 0) {
+			continue;
+		}
+
+		link = &cache->buckets[cert_bucket(cache, entry->digest)];
+
+		while (*link != entry) {
+			link = &(*link)->next;
+		}
+
+		*link = entry->next;
+		cert_unlink(cache, entry);
+		cert_entry_free(entry);
+		cache->count -= 1;
+	}
+}
+
+/**
+ * Fingerprint of a SHA-256 digest, in lowercase hex.
+ */
+void cert_hex (const unsigned char *digest, char *fingerprint) {
+	int index;
+
+	for (index = 0; index < SHA256_DIGEST_LENGTH; index += 1) {
+		snprintf(fingerprint + (index * 2), 3, "%02x", digest[index]);
+	}
+}
+
+/**
+ * SHA-256 digest of the DER encoding of crt,
+ * and its fingerprint, unless fingerprint is NULL.
+ */
+int cert_digest (X509 *crt, unsigned char *digest, char *fingerprint) {
+	if (!X509_digest(crt, EVP_sha256(), digest, NULL)) {
+		return -1;
+	}
+
+	if (!is_null(fingerprint)) {
+		cert_hex(digest, fingerprint);
+	}
+
+	return 0;
+}
+
+/**
+ * New cache. References to certificates already
+ * written out are rendered with ref_fmt, given
+ * the hex SHA-256 fingerprint.
+ */
+cert_cache_t *cert_cache_new (const char *ref_fmt) {
+	cert_cache_t *cache;
+
+	NEW0(cache);
+	cache->size = CERT_CACHE_SIZE;
+	cache->limit = CERT_CACHE_LIMIT;
+	cache->buckets = CALLOC((long) cache->size, (long) sizeof(cert_entry_t *));
+	cache->ref_fmt = ref_fmt;
+	pthread_mutex_init(&cache->lock, NULL);
+
+	return cache;
+}
+
+void cert_cache_free (cert_cache_t *cache) {
+	size_t index;
+	cert_entry_t *entry, *next;
+
+	if (is_null(cache)) {
+		return;
+	}
+
+	for (index = 0; index < cache->size; index += 1) {
+		for (entry = cache->buckets[index]; !is_null(entry); entry = next) {
+			next = entry->next;
+			cert_entry_free(entry);
+		}
+	}
+
+	pthread_mutex_destroy(&cache->lock);
+	FREE(cache->buckets);
+	FREE(cache);
+}
+
+/**
+ * Entry for crt, rendering it with render if it
+ * hasn't been seen before, pinned until released.
+ * Rendering is done outside the lock, so if two
+ * threads race on a new certificate, the loser's
+ * copy is dropped.
+ */
+cert_entry_t *cert_cache_get (cert_cache_t *cache, X509 *crt, cert_render_t render, void *arg) {
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	char fingerprint[CERT_FINGERPRINT_LENGTH + NULL_BYTE];
+	cert_entry_t *entry, *found;
+	buf_t *buf;
+
+	if (is_error(cert_digest(crt, digest, fingerprint), -1)) {
+		return NULL;
+	}
+
+	pthread_mutex_lock(&cache->lock);
+	entry = cert_find(cache, digest);
+
+	if (!is_null(entry)) {
+		entry->pins += 1;
+		cert_touch(cache, entry);
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+
+	if (!is_null(entry)) {
+		return entry;
+	}
+
+	NEW0(entry);
+	memcpy(entry->digest, digest, SHA256_DIGEST_LENGTH);
+	memcpy(entry->fingerprint, fingerprint, sizeof(fingerprint));
+
+	buf = buf_new(BUF_INITIAL_SIZE);
+	render(buf, crt, entry->fingerprint, arg);
+	entry->fulllen = buf->len;
+	entry->full = ALLOC((long) buf->len + NULL_BYTE);
+	memcpy(entry->full, buf->data, buf->len);
+
+	buf_reset(buf);
+	buf_printf(buf, cache->ref_fmt, entry->fingerprint);
+	entry->reflen = buf->len;
+	entry->ref = ALLOC((long) buf->len + NULL_BYTE);
+	memcpy(entry->ref, buf->data, buf->len);
+	buf_free(buf);
+
+	pthread_mutex_lock(&cache->lock);
+	found = cert_find(cache, digest);
+
+	if (is_null(found)) {
+		cert_grow(cache);
+		entry->next = cache->buckets[cert_bucket(cache, digest)];
+		cache->buckets[cert_bucket(cache, digest)] = entry;
+		cache->count += 1;
+		entry->pins = 1;
+		cert_touch(cache, entry);
+		cert_evict(cache);
+	} else {
+		found->pins += 1;
+		cert_touch(cache, found);
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+
+	if (!is_null(found)) {
+		cert_entry_free(entry);
+		return found;
+	}
+
+	return entry;
+}
+
+/**
+ * Append rendered report in data to out, putting each
+ * referenced certificate in place: in full the first
+ * time it's written out, by reference after that.
+ * Must be called under the output lock.
+ */
+void cert_cache_expand (const cert_refs_t *refs, const char *data, size_t len, buf_t *out) {
+	int index;
+	size_t offset = 0;
+	cert_entry_t *entry;
+
+	for (index = 0; index < refs->count; index += 1) {
+		entry = refs->entries[index];
+		buf_append(out, data + offset, refs->offsets[index] - offset);
+		offset = refs->offsets[index];
+
+		if (entry->emitted) {
+			buf_append(out, entry->ref, entry->reflen);
+		} else {
+			buf_append(out, entry->full, entry->fulllen);
+			entry->emitted = 1;
+		}
+	}
+
+	buf_append(out, data + offset, len - offset);
+}
+
+/**
+ * Unpin entries referred to by a report,
+ * once it has been written out.
+ */
+void cert_cache_release (cert_cache_t *cache, const cert_refs_t *refs) {
+	int index;
+
+	pthread_mutex_lock(&cache->lock);
+
+	for (index = 0; index < refs->count; index += 1) {
+		refs->entries[index]->pins -= 1;
+	}
+
+	pthread_mutex_unlock(&cache->lock);
+}
@@ -6,9 +6,97 @@
 
 #include "clock.h"
 
-double get_elapsed_ticks(clock_t start) {
-	double diff;
+static const char *phase_names[NUM_PHASES] = {
+	"resolve",
+	"connect",
+	"handshake",
+	"extract",
+};
 
-	diff = (double)(clock() - start);
-	return (diff / CLOCKS_PER_SEC);
+/**
+ * Current monotonic (wall-clock) time, in nanoseconds.
+ * Unlike clock(), this includes time spent blocked.
+ */
+uint64_t clock_now (void) {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ((uint64_t) ts.tv_sec * NSEC_PER_SEC) + (uint64_t) ts.tv_nsec;
+}
+
+/**
+ * Seconds elapsed since start (from clock_now).
+ */
+double get_elapsed_time (uint64_t start) {
+	return (double) (clock_now() - start) / NSEC_PER_SEC;
+}
+
+/**
+ * Sleep for the given number of nanoseconds.
+ */
+void clock_sleep (uint64_t nsec) {
+	struct timespec ts;
+
+	ts.tv_sec = (time_t) (nsec / NSEC_PER_SEC);
+	ts.tv_nsec = (long) (nsec % NSEC_PER_SEC);
+
+	while (nanosleep(&ts, &ts) != 0 && errno == EINTR) {
+		continue;
+	}
+}
+
+/**
+ * Reset timing, starting the clock now.
+ */
+void timing_init (timing_t *timing) {
+	int index;
+
+	timing->start = clock_now();
+
+	for (index = 0; index < NUM_PHASES; index += 1) {
+		timing->begin[index] = 0;
+		timing->end[index] = 0;
+	}
+}
+
+void timing_begin (timing_t *timing, phase_t phase) {
+	timing->begin[phase] = clock_now();
+	timing->end[phase] = 0;
+}
+
+void timing_end (timing_t *timing, phase_t phase) {
+	timing->end[phase] = clock_now();
+}
+
+/**
+ * Duration of phase in nanoseconds, or
+ * zero if the phase never completed.
+ */
+uint64_t timing_duration (const timing_t *timing, phase_t phase) {
+	if (!timing->begin[phase] || timing->end[phase] < timing->begin[phase]) {
+		return 0;
+	}
+
+	return timing->end[phase] - timing->begin[phase];
+}
+
+/**
+ * Time from start to the end of the last completed phase.
+ */
+uint64_t timing_total (const timing_t *timing) {
+	int index;
+	uint64_t last = timing->start;
+
+	for (index = 0; index < NUM_PHASES; index += 1) {
+		if (timing->end[index] > last) {
+			last = timing->end[index];
+		}
+	}
+
+	return last - timing->start;
+}
+
+const char *phase_name (phase_t phase) {
+	return phase_names[phase];
 }
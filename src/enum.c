@@ -0,0 +1,446 @@
+/**
+ * enum.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "enum.h"
+
+static void enum_note(probe_t *, int);
+
+/**
+ * Work out the cipher suites we can offer under each
+ * version, newest first, from the methods --method
+ * knows of. Those the linked OpenSSL can't offer
+ * (e.g. SSLv2) are left out. The context accepts
+ * anything (security level 0), since old and weak
+ * is exactly what's being looked for.
+ */
+static int enum_versions (enum_run_t *run) {
+	int index, count;
+	method_t *method;
+	SSL *ssl;
+	STACK_OF(SSL_CIPHER) *ciphers;
+	enum_version_t *version;
+
+	SSL_CTX_set_security_level(run->ctx, 0);
+
+	if (!SSL_CTX_set_cipher_list(run->ctx, "ALL:COMPLEMENTOFALL:@SECLEVEL=0")
+	    || !SSL_CTX_set_ciphersuites(run->ctx, ENUM_CIPHERSUITES)) {
+		return -1;
+	}
+
+	for (index = NUM_METHODS - 1; index >= 0; index -= 1) {
+		method = get_method(index);
+		ssl = SSL_new(run->ctx);
+
+		if (is_null(ssl)) {
+			return -1;
+		}
+
+		if (!SSL_set_min_proto_version(ssl, method->version)
+		    || !SSL_set_max_proto_version(ssl, method->version)) {
+			SSL_free(ssl);
+			continue;
+		}
+
+		ciphers = SSL_get1_supported_ciphers(ssl);
+		count = is_null(ciphers) ? 0 : sk_SSL_CIPHER_num(ciphers);
+
+		if (count > 0) {
+			version = &run->versions[run->nversions++];
+			version->version = method->version;
+			version->name = method->name;
+			version->nciphers = count;
+			version->ciphers = CALLOC(count, (long) sizeof(SSL_CIPHER *));
+
+			while (count-- > 0) {
+				version->ciphers[count] = sk_SSL_CIPHER_value(ciphers, count);
+			}
+		}
+
+		sk_SSL_CIPHER_free(ciphers);
+		SSL_free(ssl);
+	}
+
+	return (run->nversions > 0) ? 0 : -1;
+}
+
+/**
+ * Queue task for host. Suites of a version the server
+ * accepted go to the front, so hosts already underway
+ * finish (and are reported) before new ones start.
+ */
+static void enum_queue (enum_host_t *host, int version, int cipher, int front) {
+	enum_task_t *task;
+	enum_run_t *run = host->run;
+
+	NEW0(task);
+	task->host = host;
+	task->version = version;
+	task->cipher = cipher;
+	host->pending += 1;
+
+	if (front) {
+		task->next = run->head;
+		run->head = task;
+
+		if (is_null(run->tail)) {
+			run->tail = task;
+		}
+	} else {
+		if (is_null(run->tail)) {
+			run->head = task;
+		} else {
+			run->tail->next = task;
+		}
+
+		run->tail = task;
+	}
+}
+
+/**
+ * Start handshake for the task.
+ */
+static void enum_start (enum_run_t *run, enum_task_t *task) {
+	probe_t *probe;
+	enum_version_t *version = &run->versions[task->version];
+	settings_t *settings = run->settings;
+
+	probe = probe_new(&task->host->target, run->ctx, run->loop, run->resolver);
+	probe->no_sni = settings->no_sni;
+	probe->connect_timeout = settings->connect_timeout;
+	probe->handshake_timeout = settings->handshake_timeout;
+	probe->deadline = settings->deadline;
+	probe->version = version->version;
+	probe->hello_only = 1;
+	probe->notify = enum_note;
+	probe->arg = task;
+
+	if (task->cipher >= 0) {
+		probe->ciphers = SSL_CIPHER_get_name(version->ciphers[task->cipher]);
+	}
+
+	run->inflight += 1;
+	probe_start(probe);
+}
+
+/**
+ * Output what host accepted, as text.
+ */
+static void enum_text (enum_run_t *run, enum_host_t *host) {
+	int index, cipher, first;
+	enum_version_t *version;
+	settings_t *settings = run->settings;
+
+	if (!is_null(settings->targets)) {
+		BIO_printf(run->bp, "--- Host: %s\n", host->target.name);
+	}
+
+	if (!host->reached) {
+		BIO_printf(
+			run->bp,
+			"Error: Unable to enumerate %s (%s).\n",
+			host->target.name,
+			probe_error_name(host->error)
+		);
+	} else {
+		BIO_printf(run->bp, "--- Protocols:");
+
+		for (index = 0, first = 1; index < run->nversions; index += 1) {
+			if (host->accepted[index]) {
+				BIO_printf(run->bp, "%s %s", first ? "" : ",", run->versions[index].name);
+				first = 0;
+			}
+		}
+
+		BIO_printf(run->bp, "%s\n", first ? " none" : "");
+
+		for (index = 0; index < run->nversions; index += 1) {
+			version = &run->versions[index];
+
+			if (!host->accepted[index]) {
+				continue;
+			}
+
+			BIO_printf(run->bp, "--- %s Ciphers:\n", version->name);
+
+			for (cipher = 0; cipher < version->nciphers; cipher += 1) {
+				if (host->ciphers[index][cipher]) {
+					BIO_printf(run->bp, "%4s%s\n", "", SSL_CIPHER_get_name(version->ciphers[cipher]));
+				}
+			}
+		}
+	}
+
+	if (!settings->quiet) {
+		BIO_printf(
+			run->bp,
+			"--- Enumeration: %d handshakes in %fs\n",
+			host->handshakes,
+			get_elapsed_time(host->start)
+		);
+	}
+
+	if (!is_null(settings->targets) && !settings->quiet) {
+		BIO_printf(run->bp, "\n");
+	}
+}
+
+/**
+ * Output what host accepted, as a line of JSON.
+ */
+static void enum_json (enum_run_t *run, enum_host_t *host) {
+	int index, cipher, first;
+	const char *name;
+	enum_version_t *version;
+	buf_t *buf = run->buf;
+
+	buf_reset(buf);
+	buf_puts(buf, "{\"host\":");
+	buf_json(buf, host->target.host, strlen(host->target.host));
+	buf_printf(buf, ",\"port\":%d", host->target.port);
+
+	if (!host->reached) {
+		buf_printf(buf, ",\"status\":\"error\",\"error\":\"%s\"", probe_error_name(host->error));
+	} else {
+		buf_puts(buf, ",\"status\":\"ok\",\"protocols\":[");
+
+		for (index = 0, first = 1; index < run->nversions; index += 1) {
+			if (host->accepted[index]) {
+				buf_printf(buf, "%s\"%s\"", first ? "" : ",", run->versions[index].name);
+				first = 0;
+			}
+		}
+
+		buf_puts(buf, "],\"ciphers\":{");
+
+		for (index = 0, first = 1; index < run->nversions; index += 1) {
+			version = &run->versions[index];
+
+			if (!host->accepted[index]) {
+				continue;
+			}
+
+			buf_printf(buf, "%s\"%s\":[", first ? "" : ",", version->name);
+			first = 0;
+
+			for (cipher = 0, name = NULL; cipher < version->nciphers; cipher += 1) {
+				if (host->ciphers[index][cipher]) {
+					buf_printf(buf, "%s", is_null((void *) name) ? "" : ",");
+					name = SSL_CIPHER_get_name(version->ciphers[cipher]);
+					buf_json(buf, name, strlen(name));
+				}
+			}
+
+			buf_puts(buf, "]");
+		}
+
+		buf_puts(buf, "}");
+	}
+
+	buf_printf(
+		buf,
+		",\"handshakes\":%d,\"elapsed\":%.3f}\n",
+		host->handshakes,
+		(double) (clock_now() - host->start) / NSEC_PER_MSEC
+	);
+
+	buf_write(buf, STDOUT_FILENO);
+}
+
+/**
+ * Report host once nothing's left pending, and release it.
+ */
+static void enum_done (enum_run_t *run, enum_host_t *host) {
+	int index;
+
+	if (!host->reached) {
+		run->failed += 1;
+	}
+
+	if (run->settings->format == FORMAT_NDJSON) {
+		enum_json(run, host);
+	} else {
+		enum_text(run, host);
+	}
+
+	for (index = 0; index < run->nversions; index += 1) {
+		FREE(host->ciphers[index]);
+	}
+
+	run->hosts -= 1;
+	FREE(host);
+}
+
+/**
+ * Probe progress callback. A handshake counts as
+ * accepted if the server came back with a ServerHello
+ * for the version (and suite) offered. Once a version
+ * is accepted, each of its suites is tried on its own.
+ */
+static void enum_note (probe_t *probe, int note) {
+	int index, accepted;
+	enum_task_t *task = probe->arg;
+	enum_host_t *host = task->host;
+	enum_run_t *run = host->run;
+	enum_version_t *version = &run->versions[task->version];
+
+	if (note != PROBE_NOTE_COMPLETE) {
+		return;
+	}
+
+	host->handshakes += 1;
+	accepted = (probe->state == PROBE_DONE && probe->hello.version == version->version);
+
+	if (accepted && task->cipher >= 0) {
+		accepted = (probe->hello.cipher == (int) SSL_CIPHER_get_protocol_id(version->ciphers[task->cipher]));
+	}
+
+	/**
+	 * Failing the handshake still means the server
+	 * was reached, it just didn't like the offer.
+	 */
+	if (probe->state == PROBE_DONE || probe->error == PROBE_ERR_HANDSHAKE) {
+		host->reached = 1;
+	} else if (!host->error) {
+		host->error = probe->error;
+	}
+
+	if (accepted && task->cipher < 0) {
+		host->accepted[task->version] = 1;
+		host->ciphers[task->version] = CALLOC(version->nciphers, 1);
+
+		for (index = version->nciphers - 1; index >= 0; index -= 1) {
+			enum_queue(host, task->version, index, 1);
+		}
+	} else if (accepted) {
+		host->ciphers[task->version][task->cipher] = 1;
+	}
+
+	ERR_clear_error();
+	probe_free(probe);
+	FREE(task);
+
+	run->inflight -= 1;
+	host->pending -= 1;
+
+	if (host->pending == 0) {
+		enum_done(run, host);
+	}
+}
+
+/**
+ * Start handshakes until the in-flight limit is
+ * reached, taking on new targets as queued ones
+ * run out (but no more at once than the limit).
+ */
+static void enum_fill (enum_run_t *run) {
+	int index;
+	target_t target;
+	enum_host_t *host;
+	enum_task_t *task;
+
+	while (run->inflight < run->limit) {
+		task = run->head;
+
+		if (!is_null(task)) {
+			run->head = task->next;
+
+			if (is_null(run->head)) {
+				run->tail = NULL;
+			}
+
+			enum_start(run, task);
+			continue;
+		}
+
+		if (run->eof || run->hosts >= run->limit) {
+			break;
+		}
+
+		if (!target_next(run->list, &target)) {
+			run->eof = 1;
+			break;
+		}
+
+		NEW0(host);
+		host->run = run;
+		host->target = target;
+		host->start = clock_now();
+		run->hosts += 1;
+
+		for (index = 0; index < run->nversions; index += 1) {
+			enum_queue(host, index, -1, 0);
+		}
+	}
+}
+
+/**
+ * Determine every protocol version and cipher suite each
+ * target accepts. Every attempt is its own handshake, cut
+ * short once the ServerHello arrives, and attempts run
+ * concurrently, across targets and within each. Returns
+ * EXIT_FAILURE if any target couldn't be reached.
+ */
+int enum_run (settings_t *settings, target_list_t *list, BIO *bp) {
+	int index;
+	enum_run_t run;
+
+	memset(&run, 0, sizeof(run));
+	run.settings = settings;
+	run.list = list;
+	run.bp = bp;
+	run.limit = settings->concurrency;
+
+	sock_rlimit(run.limit);
+
+	run.ctx = SSL_CTX_new(SSLv23_client_method());
+
+	if (is_null(run.ctx) || is_error(enum_versions(&run), -1)) {
+		fprintf(stderr, "Error: Unable to establish SSL context.\n");
+		ERR_print_errors(bp);
+		SSL_CTX_free(run.ctx);
+		return EXIT_FAILURE;
+	}
+
+	run.loop = ev_new();
+
+	if (is_null(run.loop)) {
+		fprintf(stderr, "Error: Unable to create event loop.\n");
+		SSL_CTX_free(run.ctx);
+		return EXIT_FAILURE;
+	}
+
+	run.resolver = resolver_new(run.loop, settings->resolver);
+
+	if (is_null(run.resolver)) {
+		fprintf(stderr, "Error: Unable to use resolver %s.\n", settings->resolver ? settings->resolver : RESOLV_CONF);
+		ev_free(run.loop);
+		SSL_CTX_free(run.ctx);
+		return EXIT_FAILURE;
+	}
+
+	run.buf = buf_new(BUF_INITIAL_SIZE);
+
+	enum_fill(&run);
+
+	while (run.inflight > 0) {
+		if (is_error(ev_wait(run.loop, -1), -1)) {
+			break;
+		}
+
+		enum_fill(&run);
+	}
+
+	for (index = 0; index < run.nversions; index += 1) {
+		FREE(run.versions[index].ciphers);
+	}
+
+	buf_free(run.buf);
+	resolver_free(run.resolver);
+	ev_free(run.loop);
+	SSL_CTX_free(run.ctx);
+
+	return (run.failed > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,487 @@
+/**
+ * event.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "event.h"
+
+/**
+ * Readiness notification loop. Uses epoll on Linux,
+ * and falls back to poll everywhere else (e.g. macOS).
+ * Timers are kept in a binary min-heap on deadline.
+ */
+struct ev_loop {
+	int count;
+	int cursor;
+	int nready;
+	int ntimers;
+	int timer_cap;
+	ev_timer_t **timers;
+#ifdef __linux__
+	int epfd;
+	struct epoll_event ready[EV_MAX_EVENTS];
+#else
+	int cap;
+	struct pollfd *pfds;
+	ev_watch_t **watches;
+	ev_watch_t **ready;
+	int *revents;
+#endif
+};
+
+#ifdef __linux__
+static int to_native (int events) {
+	int native = 0;
+
+	if (events & EV_READ) {
+		native |= EPOLLIN;
+	}
+
+	if (events & EV_WRITE) {
+		native |= EPOLLOUT;
+	}
+
+	return native;
+}
+
+static int from_native (int native) {
+	int events = 0;
+
+	if (native & EPOLLIN) {
+		events |= EV_READ;
+	}
+
+	if (native & EPOLLOUT) {
+		events |= EV_WRITE;
+	}
+
+	if (native & (EPOLLERR | EPOLLHUP)) {
+		events |= (EV_ERROR | EV_READ | EV_WRITE);
+	}
+
+	return events;
+}
+#else
+static int to_native (int events) {
+	int native = 0;
+
+	if (events & EV_READ) {
+		native |= POLLIN;
+	}
+
+	if (events & EV_WRITE) {
+		native |= POLLOUT;
+	}
+
+	return native;
+}
+
+static int from_native (int native) {
+	int events = 0;
+
+	if (native & POLLIN) {
+		events |= EV_READ;
+	}
+
+	if (native & POLLOUT) {
+		events |= EV_WRITE;
+	}
+
+	if (native & (POLLERR | POLLHUP | POLLNVAL)) {
+		events |= (EV_ERROR | EV_READ | EV_WRITE);
+	}
+
+	return events;
+}
+#endif
+
+/**
+ * Create new event loop.
+ */
+ev_loop_t *ev_new (void) {
+	ev_loop_t *loop;
+
+	NEW0(loop);
+
+#ifdef __linux__
+	loop->epfd = epoll_create1(EPOLL_CLOEXEC);
+
+	if (is_error(loop->epfd, -1)) {
+		FREE(loop);
+		return NULL;
+	}
+#endif
+
+	return loop;
+}
+
+/**
+ * Release event loop. Registered watches are
+ * not closed, that is left to their owners.
+ */
+void ev_free (ev_loop_t *loop) {
+	if (is_null(loop)) {
+		return;
+	}
+
+	if (loop->timer_cap) {
+		FREE(loop->timers);
+	}
+
+#ifdef __linux__
+	close(loop->epfd);
+#else
+	if (loop->cap) {
+		FREE(loop->pfds);
+		FREE(loop->watches);
+		FREE(loop->ready);
+		FREE(loop->revents);
+	}
+#endif
+
+	FREE(loop);
+}
+
+/**
+ * Initialize watch for file descriptor.
+ */
+void ev_set (ev_watch_t *watch, int fd, ev_cb_t cb, void *arg) {
+	watch->fd = fd;
+	watch->events = 0;
+	watch->slot = NOT_FOUND;
+	watch->cb = cb;
+	watch->arg = arg;
+}
+
+/**
+ * Register watch for the given events.
+ */
+int ev_add (ev_loop_t *loop, ev_watch_t *watch, int events) {
+#ifdef __linux__
+	struct epoll_event ev;
+
+	ev.events = to_native(events);
+	ev.data.ptr = watch;
+
+	if (is_error(epoll_ctl(loop->epfd, EPOLL_CTL_ADD, watch->fd, &ev), -1)) {
+		return -1;
+	}
+
+	watch->slot = 0;
+#else
+	if (loop->count == loop->cap) {
+		loop->cap = loop->cap ? (loop->cap * 2) : 64;
+
+		if (is_null(loop->pfds)) {
+			loop->pfds = ALLOC(loop->cap * (long) sizeof(struct pollfd));
+			loop->watches = ALLOC(loop->cap * (long) sizeof(ev_watch_t *));
+			loop->ready = ALLOC(loop->cap * (long) sizeof(ev_watch_t *));
+			loop->revents = ALLOC(loop->cap * (long) sizeof(int));
+		} else {
+			RESIZE(loop->pfds, loop->cap * (long) sizeof(struct pollfd));
+			RESIZE(loop->watches, loop->cap * (long) sizeof(ev_watch_t *));
+			RESIZE(loop->ready, loop->cap * (long) sizeof(ev_watch_t *));
+			RESIZE(loop->revents, loop->cap * (long) sizeof(int));
+		}
+	}
+
+	watch->slot = loop->count;
+	loop->pfds[watch->slot].fd = watch->fd;
+	loop->pfds[watch->slot].events = to_native(events);
+	loop->pfds[watch->slot].revents = 0;
+	loop->watches[watch->slot] = watch;
+#endif
+
+	watch->events = events;
+	loop->count += 1;
+
+	return 0;
+}
+
+/**
+ * Change the set of events a watch is interested in.
+ */
+int ev_mod (ev_loop_t *loop, ev_watch_t *watch, int events) {
+#ifdef __linux__
+	struct epoll_event ev;
+#endif
+
+	if (watch->events == events) {
+		return 0;
+	}
+
+#ifdef __linux__
+	ev.events = to_native(events);
+	ev.data.ptr = watch;
+
+	if (is_error(epoll_ctl(loop->epfd, EPOLL_CTL_MOD, watch->fd, &ev), -1)) {
+		return -1;
+	}
+#else
+	loop->pfds[watch->slot].events = to_native(events);
+#endif
+
+	watch->events = events;
+
+	return 0;
+}
+
+/**
+ * Remove watch from loop. Any readiness already
+ * collected for the watch in the current batch
+ * is discarded, so it is safe to free the watch
+ * from within another watch's callback.
+ */
+int ev_del (ev_loop_t *loop, ev_watch_t *watch) {
+	int index;
+#ifndef __linux__
+	int last;
+#endif
+
+	if (is_error(watch->slot, NOT_FOUND)) {
+		return 0;
+	}
+
+#ifdef __linux__
+	epoll_ctl(loop->epfd, EPOLL_CTL_DEL, watch->fd, NULL);
+
+	for (index = loop->cursor; index < loop->nready; index += 1) {
+		if (loop->ready[index].data.ptr == watch) {
+			loop->ready[index].data.ptr = NULL;
+		}
+	}
+#else
+	last = (loop->count - 1);
+
+	if (watch->slot != last) {
+		loop->pfds[watch->slot] = loop->pfds[last];
+		loop->watches[watch->slot] = loop->watches[last];
+		loop->watches[watch->slot]->slot = watch->slot;
+	}
+
+	for (index = loop->cursor; index < loop->nready; index += 1) {
+		if (loop->ready[index] == watch) {
+			loop->ready[index] = NULL;
+		}
+	}
+#endif
+
+	watch->slot = NOT_FOUND;
+	watch->events = 0;
+	loop->count -= 1;
+
+	return 0;
+}
+
+/**
+ * Number of watches currently registered.
+ */
+int ev_count (ev_loop_t *loop) {
+	return loop->count;
+}
+
+/**
+ * Swap heap entries, keeping slots current.
+ */
+static void timer_swap (ev_loop_t *loop, int a, int b) {
+	ev_timer_t *tmp = loop->timers[a];
+
+	loop->timers[a] = loop->timers[b];
+	loop->timers[b] = tmp;
+	loop->timers[a]->slot = a;
+	loop->timers[b]->slot = b;
+}
+
+static void timer_up (ev_loop_t *loop, int slot) {
+	int parent;
+
+	while (slot > 0) {
+		parent = (slot - 1) / 2;
+
+		if (loop->timers[parent]->when <= loop->timers[slot]->when) {
+			break;
+		}
+
+		timer_swap(loop, parent, slot);
+		slot = parent;
+	}
+}
+
+static void timer_down (ev_loop_t *loop, int slot) {
+	int child;
+
+	while ((child = (slot * 2) + 1) < loop->ntimers) {
+		if (child + 1 < loop->ntimers && loop->timers[child + 1]->when < loop->timers[child]->when) {
+			child += 1;
+		}
+
+		if (loop->timers[slot]->when <= loop->timers[child]->when) {
+			break;
+		}
+
+		timer_swap(loop, slot, child);
+		slot = child;
+	}
+}
+
+/**
+ * Initialize timer with callback.
+ */
+void ev_timer_set (ev_timer_t *timer, ev_timer_cb_t cb, void *arg) {
+	timer->when = 0;
+	timer->slot = NOT_FOUND;
+	timer->cb = cb;
+	timer->arg = arg;
+}
+
+/**
+ * Arm timer to fire after delay nanoseconds,
+ * re-arming it if it was already pending.
+ */
+void ev_timer_start (ev_loop_t *loop, ev_timer_t *timer, uint64_t delay) {
+	ev_timer_stop(loop, timer);
+
+	if (loop->ntimers == loop->timer_cap) {
+		loop->timer_cap = loop->timer_cap ? (loop->timer_cap * 2) : 64;
+
+		if (is_null(loop->timers)) {
+			loop->timers = ALLOC(loop->timer_cap * (long) sizeof(ev_timer_t *));
+		} else {
+			RESIZE(loop->timers, loop->timer_cap * (long) sizeof(ev_timer_t *));
+		}
+	}
+
+	timer->when = clock_now() + delay;
+	timer->slot = loop->ntimers++;
+	loop->timers[timer->slot] = timer;
+	timer_up(loop, timer->slot);
+}
+
+/**
+ * Disarm timer, if pending.
+ */
+void ev_timer_stop (ev_loop_t *loop, ev_timer_t *timer) {
+	int slot, last;
+
+	if (is_error(timer->slot, NOT_FOUND)) {
+		return;
+	}
+
+	slot = timer->slot;
+	last = --loop->ntimers;
+	timer->slot = NOT_FOUND;
+
+	if (slot != last) {
+		loop->timers[slot] = loop->timers[last];
+		loop->timers[slot]->slot = slot;
+		timer_down(loop, slot);
+		timer_up(loop, slot);
+	}
+}
+
+/**
+ * Determine if timer is pending.
+ */
+int ev_timer_active (ev_timer_t *timer) {
+	return !is_error(timer->slot, NOT_FOUND);
+}
+
+/**
+ * Fire all timers whose deadline has passed.
+ */
+static void ev_timers (ev_loop_t *loop) {
+	uint64_t now;
+	ev_timer_t *timer;
+
+	now = clock_now();
+
+	while (loop->ntimers > 0 && loop->timers[0]->when <= now) {
+		timer = loop->timers[0];
+		ev_timer_stop(loop, timer);
+		timer->cb(timer);
+	}
+}
+
+/**
+ * Clamp timeout (in milliseconds) to the next timer deadline.
+ */
+static int ev_timeout (ev_loop_t *loop, int timeout) {
+	uint64_t now, when;
+	int wait;
+
+	if (loop->ntimers == 0) {
+		return timeout;
+	}
+
+	now = clock_now();
+	when = loop->timers[0]->when;
+	wait = (when <= now) ? 0 : (int) (((when - now) + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC);
+
+	return (timeout < 0 || wait < timeout) ? wait : timeout;
+}
+
+/**
+ * Wait up to timeout milliseconds (-1 blocks) for
+ * readiness, and dispatch callbacks for all ready
+ * watches, then for all expired timers. Returns
+ * the number of ready watches.
+ */
+int ev_wait (ev_loop_t *loop, int timeout) {
+	ev_watch_t *watch;
+#ifdef __linux__
+	int nready;
+
+	timeout = ev_timeout(loop, timeout);
+	nready = epoll_wait(loop->epfd, loop->ready, EV_MAX_EVENTS, timeout);
+
+	if (is_error(nready, -1)) {
+		return (errno == EINTR) ? 0 : -1;
+	}
+
+	loop->nready = nready;
+
+	for (loop->cursor = 0; loop->cursor < loop->nready; ) {
+		struct epoll_event *ev = &loop->ready[loop->cursor++];
+		watch = ev->data.ptr;
+
+		if (!is_null(watch)) {
+			watch->cb(watch, from_native(ev->events));
+		}
+	}
+#else
+	int index, nready;
+
+	timeout = ev_timeout(loop, timeout);
+	nready = poll(loop->pfds, loop->count, timeout);
+
+	if (is_error(nready, -1)) {
+		return (errno == EINTR) ? 0 : -1;
+	}
+
+	loop->nready = 0;
+
+	for (index = 0; index < loop->count && loop->nready < nready; index += 1) {
+		if (loop->pfds[index].revents) {
+			loop->ready[loop->nready] = loop->watches[index];
+			loop->revents[loop->nready] = from_native(loop->pfds[index].revents);
+			loop->nready += 1;
+		}
+	}
+
+	for (loop->cursor = 0; loop->cursor < loop->nready; ) {
+		index = loop->cursor++;
+		watch = loop->ready[index];
+
+		if (!is_null(watch)) {
+			watch->cb(watch, loop->revents[index]);
+		}
+	}
+#endif
+
+	loop->cursor = 0;
+	loop->nready = 0;
+	ev_timers(loop);
+
+	return nready;
+}
@@ -0,0 +1,176 @@
+/**
+ * hist.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "hist.h"
+
+/**
+ * Index of the bucket value falls in.
+ */
+static int hist_index (uint64_t value) {
+	int msb, shift;
+
+	if (value < HIST_SUB_COUNT) {
+		return (int) value;
+	}
+
+	msb = 63 - __builtin_clzll(value);
+	shift = msb - (HIST_SUB_BITS - 1);
+
+	return HIST_SUB_COUNT
+	     + ((shift - 1) * HIST_HALF_COUNT)
+	     + (int) ((value >> shift) - HIST_HALF_COUNT);
+}
+
+/**
+ * Highest value that falls in the bucket at index.
+ */
+static uint64_t hist_value (int index) {
+	int shift;
+	uint64_t base;
+
+	if (index < HIST_SUB_COUNT) {
+		return (uint64_t) index;
+	}
+
+	shift = ((index - HIST_SUB_COUNT) / HIST_HALF_COUNT) + 1;
+	base = (uint64_t) (((index - HIST_SUB_COUNT) % HIST_HALF_COUNT) + HIST_HALF_COUNT);
+
+	return ((base + 1) << shift) - 1;
+}
+
+/**
+ * Create new, empty histogram.
+ */
+hist_t *hist_new (void) {
+	hist_t *hist;
+
+	NEW0(hist);
+	hist_reset(hist);
+
+	return hist;
+}
+
+/**
+ * Release histogram.
+ */
+void hist_free (hist_t *hist) {
+	if (is_null(hist)) {
+		return;
+	}
+
+	FREE(hist);
+}
+
+/**
+ * Discard all recorded values.
+ */
+void hist_reset (hist_t *hist) {
+	memset(hist, 0, sizeof(*hist));
+	hist->min = HIST_MAX_VALUE;
+}
+
+/**
+ * Record value, clamped to HIST_MAX_VALUE.
+ */
+void hist_record (hist_t *hist, uint64_t value) {
+	if (value > HIST_MAX_VALUE) {
+		value = HIST_MAX_VALUE;
+	}
+
+	hist->counts[hist_index(value)] += 1;
+	hist->total += 1;
+	hist->sum += value;
+
+	if (value < hist->min) {
+		hist->min = value;
+	}
+
+	if (value > hist->max) {
+		hist->max = value;
+	}
+}
+
+/**
+ * Add all values recorded in src to dst.
+ */
+void hist_merge (hist_t *dst, const hist_t *src) {
+	int index;
+
+	for (index = 0; index < HIST_NUM_COUNTS; index += 1) {
+		dst->counts[index] += src->counts[index];
+	}
+
+	dst->total += src->total;
+	dst->sum += src->sum;
+
+	if (src->min < dst->min) {
+		dst->min = src->min;
+	}
+
+	if (src->max > dst->max) {
+		dst->max = src->max;
+	}
+}
+
+/**
+ * Value at or below which percentile (0-100) of the recorded
+ * values fall, rounded up to the end of its bucket, but never
+ * above the largest value actually recorded.
+ */
+uint64_t hist_percentile (const hist_t *hist, double percentile) {
+	int index;
+	uint64_t rank, seen, value;
+
+	if (hist->total == 0) {
+		return 0;
+	}
+
+	rank = (uint64_t) ((percentile / 100.0) * (double) hist->total + 0.5);
+
+	if (rank < 1) {
+		rank = 1;
+	}
+
+	seen = 0;
+
+	for (index = 0; index < HIST_NUM_COUNTS; index += 1) {
+		seen += hist->counts[index];
+
+		if (seen >= rank) {
+			value = hist_value(index);
+			return (value > hist->max) ? hist->max : value;
+		}
+	}
+
+	return hist->max;
+}
+
+/**
+ * Mean of the recorded values.
+ */
+uint64_t hist_mean (const hist_t *hist) {
+	return hist->total ? (hist->sum / hist->total) : 0;
+}
+
+/**
+ * Number of recorded values at or below value, to the
+ * precision of the buckets: a bucket counts if its
+ * highest value is at or below value.
+ */
+uint64_t hist_count (const hist_t *hist, uint64_t value) {
+	int index;
+	uint64_t seen;
+
+	if (value >= hist->max) {
+		return hist->total;
+	}
+
+	for (index = 0, seen = 0; index < HIST_NUM_COUNTS && hist_value(index) <= value; index += 1) {
+		seen += hist->counts[index];
+	}
+
+	return seen;
+}
@@ -0,0 +1,391 @@
+/**
+ * load.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "load.h"
+
+/**
+ * Probe progress callback, tally the result.
+ */
+static void load_note (probe_t *probe, int note) {
+	int index;
+	worker_t *worker = probe->arg;
+
+	if (note != PROBE_NOTE_COMPLETE) {
+		return;
+	}
+
+	pthread_mutex_lock(&worker->lock);
+
+	if (probe->state == PROBE_DONE) {
+		worker->ok += 1;
+		hist_record(worker->hist, timing_total(&probe->timing));
+	} else {
+		worker->failed += 1;
+	}
+
+	pthread_mutex_unlock(&worker->lock);
+	ERR_clear_error();
+
+	for (index = 0; index < worker->limit; index += 1) {
+		if (worker->probes[index] == probe) {
+			worker->probes[index] = NULL;
+			break;
+		}
+	}
+
+	worker->inflight -= 1;
+	probe_free(probe);
+}
+
+/**
+ * Start a probe in a free slot.
+ */
+static void load_start (worker_t *worker) {
+	int index;
+	probe_t *probe;
+	settings_t *settings = worker->load->settings;
+
+	for (index = 0; index < worker->limit; index += 1) {
+		if (is_null(worker->probes[index])) {
+			break;
+		}
+	}
+
+	probe = probe_new(&worker->load->target, worker->ctx, worker->loop, worker->resolver);
+	probe->no_sni = settings->no_sni;
+	probe->connect_timeout = settings->connect_timeout;
+	probe->handshake_timeout = settings->handshake_timeout;
+	probe->deadline = settings->deadline;
+	probe->notify = load_note;
+	probe->arg = worker;
+
+	worker->probes[index] = probe;
+	worker->inflight += 1;
+	probe_start(probe);
+}
+
+/**
+ * Start as many probes as the in-flight limit
+ * and, if --rate was given, the schedule allow.
+ */
+static void load_fill (worker_t *worker) {
+	while (worker->inflight < worker->limit) {
+		if (worker->period) {
+			if (worker->next > clock_now()) {
+				break;
+			}
+
+			worker->next += worker->period;
+		}
+
+		load_start(worker);
+	}
+}
+
+/**
+ * Milliseconds until the next scheduled start.
+ */
+static int load_timeout (worker_t *worker) {
+	uint64_t now, wait;
+
+	if (!worker->period || worker->inflight >= worker->limit) {
+		return LOAD_POLL_INTERVAL;
+	}
+
+	now = clock_now();
+
+	if (worker->next <= now) {
+		return 0;
+	}
+
+	wait = (worker->next - now + NSEC_PER_MSEC - 1) / NSEC_PER_MSEC;
+
+	return (wait < LOAD_POLL_INTERVAL) ? (int) wait : LOAD_POLL_INTERVAL;
+}
+
+/**
+ * Worker thread, runs until told to stop.
+ */
+static void *load_worker (void *arg) {
+	int index;
+	uint64_t until;
+	worker_t *worker = arg;
+	load_t *load = worker->load;
+
+	worker->next = clock_now();
+
+	while (!__atomic_load_n(&load->stop, __ATOMIC_ACQUIRE)) {
+		load_fill(worker);
+
+		if (is_error(ev_wait(worker->loop, load_timeout(worker)), -1)) {
+			break;
+		}
+	}
+
+	/**
+	 * Give probes in flight a moment
+	 * to finish, then abandon the rest.
+	 */
+	until = clock_now() + ((uint64_t) LOAD_DRAIN_TIMEOUT * NSEC_PER_MSEC);
+
+	while (worker->inflight > 0 && clock_now() < until) {
+		if (is_error(ev_wait(worker->loop, LOAD_POLL_INTERVAL), -1)) {
+			break;
+		}
+	}
+
+	for (index = 0; index < worker->limit; index += 1) {
+		if (!is_null(worker->probes[index])) {
+			probe_free(worker->probes[index]);
+			worker->probes[index] = NULL;
+		}
+	}
+
+	ERR_clear_error();
+
+	return NULL;
+}
+
+/**
+ * Collect and reset results of all workers.
+ */
+static void load_collect (load_t *load, hist_t *hist, long *ok, long *failed) {
+	int index;
+	worker_t *worker;
+
+	*ok = 0;
+	*failed = 0;
+
+	for (index = 0; index < load->nworkers; index += 1) {
+		worker = &load->workers[index];
+
+		pthread_mutex_lock(&worker->lock);
+		hist_merge(hist, worker->hist);
+		hist_reset(worker->hist);
+		*ok += worker->ok;
+		*failed += worker->failed;
+		worker->ok = 0;
+		worker->failed = 0;
+		pthread_mutex_unlock(&worker->lock);
+	}
+}
+
+/**
+ * Output latency percentiles of hist.
+ */
+static void load_percentiles (BIO *bp, const hist_t *hist) {
+	BIO_printf(
+		bp,
+		"p50=%.3fms p90=%.3fms p99=%.3fms max=%.3fms",
+		(double) hist_percentile(hist, 50.0) / NSEC_PER_MSEC,
+		(double) hist_percentile(hist, 90.0) / NSEC_PER_MSEC,
+		(double) hist_percentile(hist, 99.0) / NSEC_PER_MSEC,
+		(double) hist->max / NSEC_PER_MSEC
+	);
+}
+
+/**
+ * Set up worker, returns -1 on failure.
+ */
+static int load_worker_init (load_t *load, worker_t *worker, int limit, uint64_t period) {
+	worker->load = load;
+	worker->limit = limit;
+	worker->period = period;
+	worker->ctx = SSL_CTX_new(SSLv23_client_method());
+	worker->loop = ev_new();
+
+	if (is_null(worker->ctx) || is_null(worker->loop)) {
+		return -1;
+	}
+
+	worker->resolver = resolver_new(worker->loop, load->settings->resolver);
+
+	if (is_null(worker->resolver)) {
+		return -1;
+	}
+
+	worker->probes = CALLOC(limit, (long) sizeof(probe_t *));
+	worker->hist = hist_new();
+	pthread_mutex_init(&worker->lock, NULL);
+
+	return 0;
+}
+
+/**
+ * Release worker resources.
+ */
+static void load_worker_free (worker_t *worker) {
+	if (!is_null(worker->hist)) {
+		pthread_mutex_destroy(&worker->lock);
+		hist_free(worker->hist);
+		FREE(worker->probes);
+	}
+
+	resolver_free(worker->resolver);
+	ev_free(worker->loop);
+	SSL_CTX_free(worker->ctx);
+}
+
+/**
+ * Open handshakes against target from one thread per core,
+ * for --duration seconds, at --rate handshakes per second
+ * (or as fast as possible), and report throughput, error
+ * rate and latency every second. Returns EXIT_FAILURE if
+ * no handshake succeeded.
+ */
+int load_run (settings_t *settings, const target_t *target, BIO *bp) {
+	int index, limit, started;
+	long ok, failed, total_ok, total_failed;
+	uint64_t start, end, tick, now, period;
+	double elapsed;
+	hist_t *hist, *overall;
+	load_t load;
+
+	memset(&load, 0, sizeof(load));
+	load.settings = settings;
+	load.target = *target;
+	load.bp = bp;
+	load.nworkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (load.nworkers < 1) {
+		load.nworkers = 1;
+	}
+
+	limit = (settings->concurrency + load.nworkers - 1) / load.nworkers;
+	period = settings->rate ? ((NSEC_PER_SEC * (uint64_t) load.nworkers) / (uint64_t) settings->rate) : 0;
+	sock_rlimit(limit * load.nworkers);
+
+	load.workers = CALLOC(load.nworkers, (long) sizeof(worker_t));
+	started = 0;
+
+	for (index = 0; index < load.nworkers; index += 1) {
+		if (is_error(load_worker_init(&load, &load.workers[index], limit, period), -1)) {
+			fprintf(stderr, "Error: Unable to set up worker thread.\n");
+			goto on_error;
+		}
+	}
+
+	BIO_printf(
+		bp,
+		"--- Load: %s, %d %s, %d in flight, ",
+		target->name,
+		load.nworkers,
+		(load.nworkers == 1) ? "thread" : "threads",
+		limit * load.nworkers
+	);
+
+	if (settings->rate) {
+		BIO_printf(bp, "%d handshakes/s", settings->rate);
+	} else {
+		BIO_printf(bp, "max rate");
+	}
+
+	BIO_printf(bp, " for %ds\n", settings->duration);
+	BIO_flush(bp);
+
+	start = clock_now();
+	end = start + ((uint64_t) settings->duration * NSEC_PER_SEC);
+
+	for (index = 0; index < load.nworkers; index += 1) {
+		if (pthread_create(&load.workers[index].thread, NULL, load_worker, &load.workers[index]) != 0) {
+			fprintf(stderr, "Error: Unable to start worker thread.\n");
+			break;
+		}
+
+		started += 1;
+	}
+
+	hist = hist_new();
+	overall = hist_new();
+	total_ok = 0;
+	total_failed = 0;
+	tick = start;
+
+	while (started > 0 && (now = clock_now()) < end) {
+		tick += (uint64_t) LOAD_REPORT_INTERVAL * NSEC_PER_MSEC;
+
+		if (tick > end) {
+			tick = end;
+		}
+
+		if (tick > now) {
+			clock_sleep(tick - now);
+		}
+
+		load_collect(&load, hist, &ok, &failed);
+		total_ok += ok;
+		total_failed += failed;
+		hist_merge(overall, hist);
+
+		if (!settings->quiet) {
+			elapsed = (double) (clock_now() - start) / NSEC_PER_SEC;
+
+			BIO_printf(
+				bp,
+				"%s [%fs] %ld handshakes, %ld failed (%.2f%%), ",
+				KEUKA_INBOUND_INDICATOR,
+				elapsed,
+				ok,
+				failed,
+				(ok + failed) ? (100.0 * failed / (ok + failed)) : 0.0
+			);
+			load_percentiles(bp, hist);
+			BIO_printf(bp, "\n");
+			BIO_flush(bp);
+		}
+
+		hist_reset(hist);
+	}
+
+	__atomic_store_n(&load.stop, 1, __ATOMIC_RELEASE);
+
+	for (index = 0; index < started; index += 1) {
+		pthread_join(load.workers[index].thread, NULL);
+	}
+
+	elapsed = (double) (clock_now() - start) / NSEC_PER_SEC;
+
+	/**
+	 * Pick up whatever finished while draining.
+	 */
+	load_collect(&load, hist, &ok, &failed);
+	total_ok += ok;
+	total_failed += failed;
+	hist_merge(overall, hist);
+
+	BIO_printf(
+		bp,
+		"--- Handshakes: %ld in %.3fs (%.1f/s), %ld failed (%.2f%%)\n",
+		total_ok,
+		elapsed,
+		total_ok / elapsed,
+		total_failed,
+		(total_ok + total_failed) ? (100.0 * total_failed / (total_ok + total_failed)) : 0.0
+	);
+	BIO_printf(bp, "--- Latency: ");
+	load_percentiles(bp, overall);
+	BIO_printf(bp, "\n");
+
+	hist_free(hist);
+	hist_free(overall);
+
+	for (index = 0; index < load.nworkers; index += 1) {
+		load_worker_free(&load.workers[index]);
+	}
+
+	FREE(load.workers);
+
+	return (total_ok > 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+on_error:
+	for (index = 0; index < load.nworkers; index += 1) {
+		load_worker_free(&load.workers[index]);
+	}
+
+	FREE(load.workers);
+
+	return EXIT_FAILURE;
+}
@@ -13,46 +13,34 @@
  * keuka --issuer --method --signature-algorithm -- amazon.com
  * keuka -ACim github.com
  * keuka -qCA www.ieee.org
+ * keuka -qm --concurrency 256 --targets hosts.txt
+ * keuka --format bin --targets hosts.txt > results.bin
+ * keuka -csi --decode results.bin
+ * keuka -qm --watch --cache state.db --targets hosts.txt
+ * keuka --enumerate --concurrency 64 example.com
+ * keuka -q --verify --ca-file ca-bundle.pem --targets hosts.txt
+ * keuka -q --watch --metrics-port 9464 --targets hosts.txt
+ * keuka -q --trace trace.json --targets hosts.txt
+ * keuka --cert-only --sni-list names.txt --connect 192.0.2.10
+ * keuka -q --per-prefix 8 --rate 200 --adaptive --targets hosts.txt
  */
 
 int main (int argc, char **argv) {
-	clock_t start;
-	size_t crt_index, sig_bytes;
-	int last_index, penult_index, sig_type_err,
-	    opt_value, short_opt_index, long_opt_index;
-	int bits, chain, cipher, issuer, method,
-	    no_sni, pad_fmt, pad_tfmt, quiet;
-	int serial, server, raw, sig_algo,
-	    subject, validity;
-	int attach, status;
+	int last_index, penult_index, opt_value,
+	    short_opt_index, long_opt_index, status;
 	const char *hostname = NULL;
-	const char *protocol = "https";
-	char port[MAX_PORT_LENGTH],
-	     url[MAX_URL_LENGTH];
-	const SSL_METHOD *ssl_method = NULL;
-	ASN1_INTEGER *asn1_serial = NULL;
-	const ASN1_BIT_STRING *asn1_sig = NULL;
-	const X509_ALGOR *sig_type = NULL;
-	STACK_OF(X509) *fullchain = NULL;
+	settings_t settings;
+	target_t target;
+	target_list_t *list = NULL;
 	BIO *bp = NULL;
-	X509 *crt = NULL,
-	     *tcrt = NULL;
-	X509_NAME *crtname = NULL,
-	          *tcrtname = NULL;
-	EVP_PKEY *pubkey = NULL,
-	         *tpubkey = NULL;
-	SSL_CTX *ctx = NULL;
-	SSL *ssl = NULL;
-	const SSL_CIPHER *ssl_cipher = NULL;
-
-	server = 0;
+
 	last_index = (argc - 1);
 	penult_index = (last_index - 1);
 
 	/**
 	 * Add padding after progress output, if applicable.
 	 */
-	pad_fmt = (argc > 2 && argv[penult_index] != OPT_LSEP);
+	settings.pad_fmt = (argc > 2 && argv[penult_index] != OPT_LSEP);
 
 	/**
 	 * OPTIONS
@@ -69,6 +57,40 @@ int main (int argc, char **argv) {
 	 * -A, --signature-algorithm    Show signature algorithm.
 	 * -s, --subject                Show certificate subject.
 	 * -V, --validity               Show certificate Not Before/Not After validity range.
+	 * -T, --timing                 Show per-phase latency breakdown.
+	 * -t, --targets FILE           Probe each host[:port] in FILE (- for stdin).
+	 * -j, --concurrency N          Maximum number of probes in flight.
+	 * -R, --resolver ADDR          Send DNS queries to ADDR[:PORT].
+	 * -a, --address                Show address connection was made to.
+	 * -o, --connect-timeout MS     Give up connecting after MS milliseconds.
+	 * -H, --handshake-timeout MS   Give up on handshake after MS milliseconds.
+	 * -D, --deadline MS            Give up on each host after MS milliseconds.
+	 * -u, --resume N               Follow full handshake with N resumed handshakes.
+	 * -n, --count N                Probe each host N times and show latency percentiles.
+	 * -I, --interval MS            Wait MS milliseconds between repeated probes.
+	 * -L, --load                   Open handshakes from every core and report throughput.
+	 * -p, --rate N                 Open at most N handshakes per second.
+	 * -d, --duration S             Run --load for S seconds.
+	 * -f, --format FMT             Output format: text (default), ndjson or bin.
+	 * -x, --decode FILE            Render results saved with --format bin.
+	 * -k, --cache FILE             Keep last result per host in FILE.
+	 * -K, --cache-ttl S            Skip hosts with a cached result under S seconds old.
+	 * -w, --since SNAPSHOT         Only report hosts that changed since SNAPSHOT.
+	 * -W, --watch                  Keep rechecking hosts, reporting changes.
+	 * -M, --arena                  Allocate each probe's memory from an arena.
+	 * -G, --mem-stats              Show allocations per probe and per call site.
+	 * -e, --enumerate              Enumerate accepted protocol versions and ciphers.
+	 * -y, --verify                 Verify certificate chain and hostname.
+	 * -Y, --ca-file FILE           Trust certificates in FILE (implies --verify).
+	 * -O, --cert-only              Stop each handshake once the chain is received.
+	 * -F, --metrics-file FILE      Write Prometheus metrics to FILE periodically.
+	 * -P, --metrics-port PORT      Serve Prometheus metrics on localhost PORT.
+	 * -J, --trace FILE             Write a Chrome trace of probe phases to FILE.
+	 * -l, --sni-list FILE          Probe each server name in FILE at --connect ADDR.
+	 * -E, --connect ADDR           Connect to ADDR[:PORT] instead of resolving hosts.
+	 * -B, --per-ip N               Keep at most N probes in flight to each (first) address.
+	 * -Q, --per-prefix N           Keep at most N probes in flight to each (first) /24 or /64.
+	 * -U, --adaptive               Back off concurrency as connects and handshakes fail.
 	 * -h, --help                   Show help information and usage examples.
 	 * -v, --version                Show version information.
 	 */
@@ -76,20 +98,54 @@ int main (int argc, char **argv) {
 	/**
 	 * Initialize defaults.
 	 */
-	bits = 0;
-	chain = 0;
-	cipher = 0;
-	issuer = 0;
-	method = 0;
-	no_sni = 0;
+	settings.bits = 0;
+	settings.chain = 0;
+	settings.cipher = 0;
+	settings.issuer = 0;
+	settings.method = 0;
+	settings.no_sni = 0;
 	short_opt_index = 0;
 	long_opt_index = 0;
-	quiet = 0;
-	raw = 0;
-	serial = 0;
-	sig_algo = 0;
-	subject = 0;
-	validity = 0;
+	settings.quiet = 0;
+	settings.raw = 0;
+	settings.serial = 0;
+	settings.sig_algo = 0;
+	settings.subject = 0;
+	settings.validity = 0;
+	settings.timing = 0;
+	settings.concurrency = DEFAULT_CONCURRENCY;
+	settings.targets = NULL;
+	settings.resolver = NULL;
+	settings.address = 0;
+	settings.connect_timeout = 0;
+	settings.handshake_timeout = 0;
+	settings.deadline = 0;
+	settings.resume = 0;
+	settings.count = 1;
+	settings.interval = 0;
+	settings.load = 0;
+	settings.rate = 0;
+	settings.duration = DEFAULT_DURATION;
+	settings.format = FORMAT_TEXT;
+	settings.decode = NULL;
+	settings.cache = NULL;
+	settings.cache_ttl = 0;
+	settings.since = NULL;
+	settings.watch = 0;
+	settings.arena = 0;
+	settings.mem_stats = 0;
+	settings.enumerate = 0;
+	settings.verify = 0;
+	settings.ca_file = NULL;
+	settings.cert_only = 0;
+	settings.metrics_file = NULL;
+	settings.metrics_port = 0;
+	settings.trace = NULL;
+	settings.sni_list = NULL;
+	settings.connect = NULL;
+	settings.per_ip = 0;
+	settings.per_prefix = 0;
+	settings.adaptive = 0;
 
 	static struct option long_options[] = {
 		{ "bits", no_argument, 0, 'b' },
@@ -104,15 +160,50 @@ int main (int argc, char **argv) {
 		{ "signature-algorithm", no_argument, 0, 'A' },
 		{ "subject", no_argument, 0, 's' },
 		{ "validity", no_argument, 0, 'V' },
+		{ "timing", no_argument, 0, 'T' },
+		{ "targets", required_argument, 0, 't' },
+		{ "concurrency", required_argument, 0, 'j' },
+		{ "resolver", required_argument, 0, 'R' },
+		{ "address", no_argument, 0, 'a' },
+		{ "connect-timeout", required_argument, 0, 'o' },
+		{ "handshake-timeout", required_argument, 0, 'H' },
+		{ "deadline", required_argument, 0, 'D' },
+		{ "resume", required_argument, 0, 'u' },
+		{ "count", required_argument, 0, 'n' },
+		{ "interval", required_argument, 0, 'I' },
+		{ "load", no_argument, 0, 'L' },
+		{ "rate", required_argument, 0, 'p' },
+		{ "duration", required_argument, 0, 'd' },
+		{ "format", required_argument, 0, 'f' },
+		{ "decode", required_argument, 0, 'x' },
+		{ "cache", required_argument, 0, 'k' },
+		{ "cache-ttl", required_argument, 0, 'K' },
+		{ "since", required_argument, 0, 'w' },
+		{ "watch", no_argument, 0, 'W' },
+		{ "arena", no_argument, 0, 'M' },
+		{ "mem-stats", no_argument, 0, 'G' },
+		{ "enumerate", no_argument, 0, 'e' },
+		{ "verify", no_argument, 0, 'y' },
+		{ "ca-file", required_argument, 0, 'Y' },
+		{ "cert-only", no_argument, 0, 'O' },
+		{ "metrics-file", required_argument, 0, 'F' },
+		{ "metrics-port", required_argument, 0, 'P' },
+		{ "trace", required_argument, 0, 'J' },
+		{ "sni-list", required_argument, 0, 'l' },
+		{ "connect", required_argument, 0, 'E' },
+		{ "per-ip", required_argument, 0, 'B' },
+		{ "per-prefix", required_argument, 0, 'Q' },
+		{ "adaptive", no_argument, 0, 'U' },
 		{ "help", no_argument, 0, 'h' },
 		{ "version", no_argument, 0, 'v' },
+		{ 0, 0, 0, 0 },
 	};
 
 	do {
 		opt_value = getopt_long(
 			argc,
 			argv,
-			"bcCimNqrSAsVhv",
+			"bcCimNqrSAsVTt:j:R:ao:H:D:u:n:I:Lp:d:f:x:k:K:w:WMGeyY:OF:P:J:l:E:B:Q:Uhv",
 			long_options,
 			&long_opt_index
 		);
@@ -127,85 +218,422 @@ int main (int argc, char **argv) {
 			 * public key length, in bits.
 			 */
 			case 'b':
-				bits = 1;
+				settings.bits = 1;
 				continue;
 			/**
 			 * If --chain option was given, output
 			 * the entire peer certificate chain.
 			 */
 			case 'c':
-				chain = 1;
+				settings.chain = 1;
 				continue;
 			/**
 			 * If --cipher option was given, output
 			 * the cipher used for the exchange.
 			 */
 			case 'C':
-				cipher = 1;
+				settings.cipher = 1;
 				continue;
 			/**
 			 * If --issuer option was given, output
 			 * issuer information for certificate.
 			 */
 			case 'i':
-				issuer = 1;
+				settings.issuer = 1;
 				continue;
 			/**
 			 * If --method option was given, output
 			 * version of method used for handshake.
 			 */
 			case 'm':
-				method = 1;
+				settings.method = 1;
 				continue;
 			/**
 			 * If --no-sni option was given, disable
 			 * establishing connection, handshake.
 			 */
 			case 'N':
-				no_sni = 1;
+				settings.no_sni = 1;
 				continue;
 			/**
 			 * If --quiet option was given, suppress
 			 * timing and progress-related output.
 			 */
 			case 'q':
-				quiet = 1;
-				pad_fmt = 0;
+				settings.quiet = 1;
+				settings.pad_fmt = 0;
 				continue;
 			/**
 			 * If --raw option was given, output
 			 * raw certificate contents to stdout.
 			 */
 			case 'r':
-				raw = 1;
+				settings.raw = 1;
 				continue;
 			/**
 			 * If --serial option was given, output
 			 * serial number for the certificate(s).
 			 */
 			case 'S':
-				serial = 1;
+				settings.serial = 1;
 				continue;
 			/**
 			 * If --signature-algorithm option was given,
 			 * output signature algorithm used for certificate(s).
 			 */
 			case 'A':
-				sig_algo = 1;
+				settings.sig_algo = 1;
 				continue;
 			/**
 			 * If --subject option was given, output
 			 * the certificate(s) subject information.
 			 */
 			case 's':
-				subject = 1;
+				settings.subject = 1;
 				continue;
 			/**
 			 * If --validity option was given, output
 			 * Not Before/Not After validity time range.
 			 */
 			case 'V':
-				validity = 1;
+				settings.validity = 1;
+				continue;
+			/**
+			 * If --timing option was given, output
+			 * wall-clock latency of each probe phase.
+			 */
+			case 'T':
+				settings.timing = 1;
+				continue;
+			/**
+			 * If --targets option was given, probe
+			 * each host[:port] listed in the file.
+			 */
+			case 't':
+				settings.targets = optarg;
+				continue;
+			/**
+			 * If --concurrency option was given, limit
+			 * the number of probes in flight at once.
+			 */
+			case 'j':
+				if (!is_numeric(optarg) || atoi(optarg) < 1 || atoi(optarg) > MAX_CONCURRENCY) {
+					fprintf(stderr, "Error: Invalid concurrency %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				settings.concurrency = atoi(optarg);
+				continue;
+			/**
+			 * If --resolver option was given, send DNS
+			 * queries to the given nameserver address.
+			 */
+			case 'R':
+				settings.resolver = optarg;
+				continue;
+			/**
+			 * If --address option was given, output
+			 * the address that won the connection race.
+			 */
+			case 'a':
+				settings.address = 1;
+				continue;
+			/**
+			 * If --connect-timeout option was given, abandon
+			 * the connection if not established in time.
+			 */
+			case 'o':
+				if (!is_numeric(optarg) || atoi(optarg) < 1 || atoi(optarg) > MAX_TIMEOUT) {
+					fprintf(stderr, "Error: Invalid connect timeout %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				settings.connect_timeout = atoi(optarg);
+				continue;
+			/**
+			 * If --handshake-timeout option was given, abort
+			 * the handshake if not complete in time.
+			 */
+			case 'H':
+				if (!is_numeric(optarg) || atoi(optarg) < 1 || atoi(optarg) > MAX_TIMEOUT) {
+					fprintf(stderr, "Error: Invalid handshake timeout %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				settings.handshake_timeout = atoi(optarg);
+				continue;
+			/**
+			 * If --deadline option was given, cap the total
+			 * time spent on each host, lookup included.
+			 */
+			case 'D':
+				if (!is_numeric(optarg) || atoi(optarg) < 1 || atoi(optarg) > MAX_TIMEOUT) {
+					fprintf(stderr, "Error: Invalid deadline %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				settings.deadline = atoi(optarg);
+				continue;
+			/**
+			 * If --resume option was given, reconnect N times
+			 * offering the session from the previous handshake.
+			 */
+			case 'u':
+				if (!is_numeric(optarg) || atoi(optarg) < 1 || atoi(optarg) > MAX_RESUME) {
+					fprintf(stderr, "Error: Invalid resume count %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				settings.resume = atoi(optarg);
+				continue;
+			/**
+			 * If --count option was given, repeat the probe
+			 * and aggregate latency of each phase.
+			 */
+			case 'n':
+				if (!is_numeric(optarg) || atoi(optarg) < 1 || atoi(optarg) > MAX_COUNT) {
+					fprintf(stderr, "Error: Invalid count %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				settings.count = atoi(optarg);
+				continue;
+			/**
+			 * If --interval option was given, pause
+			 * between repeated probes of each host.
+			 */
+			case 'I':
+				if (!is_numeric(optarg) || atoi(optarg) > MAX_TIMEOUT) {
+					fprintf(stderr, "Error: Invalid interval %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				settings.interval = atoi(optarg);
+				continue;
+			/**
+			 * If --load option was given, generate sustained
+			 * handshake load against the host from every core.
+			 */
+			case 'L':
+				settings.load = 1;
+				continue;
+			/**
+			 * If --rate option was given, pace new
+			 * handshakes to N per second overall.
+			 */
+			case 'p':
+				if (!is_numeric(optarg) || atoi(optarg) < 1 || atoi(optarg) > MAX_RATE) {
+					fprintf(stderr, "Error: Invalid rate %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				settings.rate = atoi(optarg);
+				continue;
+			/**
+			 * If --duration option was given, generate
+			 * load for the given number of seconds.
+			 */
+			case 'd':
+				if (!is_numeric(optarg) || atoi(optarg) < 1 || atoi(optarg) > MAX_DURATION) {
+					fprintf(stderr, "Error: Invalid duration %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				settings.duration = atoi(optarg);
+				continue;
+			/**
+			 * If --format option was given, select how
+			 * reports are written out.
+			 */
+			case 'f':
+				if (!compare(optarg, "text")) {
+					settings.format = FORMAT_TEXT;
+				} else if (!compare(optarg, "ndjson")) {
+					settings.format = FORMAT_NDJSON;
+				} else if (!compare(optarg, "bin")) {
+					settings.format = FORMAT_BIN;
+				} else {
+					fprintf(stderr, "Error: Invalid format %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				continue;
+			/**
+			 * If --decode option was given, read results
+			 * from FILE instead of probing hosts.
+			 */
+			case 'x':
+				settings.decode = optarg;
+
+				continue;
+			/**
+			 * If --cache option was given, keep the last
+			 * result of each host in the store at FILE.
+			 */
+			case 'k':
+				settings.cache = optarg;
+
+				continue;
+			/**
+			 * If --cache-ttl option was given, reuse cached
+			 * results younger than the given number of seconds.
+			 */
+			case 'K':
+				if (!is_numeric(optarg) || atoi(optarg) < 1 || atoi(optarg) > MAX_CACHE_TTL) {
+					fprintf(stderr, "Error: Invalid cache TTL %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				settings.cache_ttl = atoi(optarg);
+
+				continue;
+			/**
+			 * If --since option was given, compare results to
+			 * those kept by an earlier run with --cache.
+			 */
+			case 'w':
+				settings.since = optarg;
+
+				continue;
+			/**
+			 * If --watch option was given, keep checking each
+			 * host on a schedule of its own, until interrupted.
+			 */
+			case 'W':
+				settings.watch = 1;
+
+				continue;
+			/**
+			 * If --arena option was given, allocate memory for
+			 * each probe (OpenSSL's included) from an arena.
+			 */
+			case 'M':
+				settings.arena = 1;
+
+				continue;
+			/**
+			 * If --mem-stats option was given, account for memory
+			 * allocated per probe and call site, OpenSSL's included.
+			 */
+			case 'G':
+				settings.mem_stats = 1;
+
+				continue;
+			/**
+			 * If --enumerate option was given, determine every
+			 * protocol version and cipher suite accepted.
+			 */
+			case 'e':
+				settings.enumerate = 1;
+
+				continue;
+			/**
+			 * If --verify option was given, verify each chain
+			 * against the trust store, and the hostname.
+			 */
+			case 'y':
+				settings.verify = 1;
+
+				continue;
+			/**
+			 * If --ca-file option was given, load the trust
+			 * store for --verify from FILE, not the default.
+			 */
+			case 'Y':
+				settings.ca_file = optarg;
+				settings.verify = 1;
+
+				continue;
+			/**
+			 * If --cert-only option was given, stop each handshake
+			 * as soon as the server's chain has been received.
+			 */
+			case 'O':
+				settings.cert_only = 1;
+
+				continue;
+			/**
+			 * If --metrics-file option was given, keep FILE up
+			 * to date with metrics, in Prometheus text format.
+			 */
+			case 'F':
+				settings.metrics_file = optarg;
+
+				continue;
+			/**
+			 * If --metrics-port option was given, serve metrics
+			 * over HTTP on PORT, on the loopback address.
+			 */
+			case 'P':
+				if (!is_numeric(optarg) || atoi(optarg) < 1 || atoi(optarg) > 65535) {
+					fprintf(stderr, "Error: Invalid metrics port %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				settings.metrics_port = atoi(optarg);
+
+				continue;
+			/**
+			 * If --trace option was given, record the phases of
+			 * each probe, and write them to FILE when done.
+			 */
+			case 'J':
+				settings.trace = optarg;
+
+				continue;
+			/**
+			 * If --sni-list option was given, probe each server
+			 * name in FILE against the address given with
+			 * --connect, grouping names by certificate.
+			 */
+			case 'l':
+				settings.sni_list = optarg;
+
+				continue;
+			/**
+			 * If --connect option was given, connect to the
+			 * address ADDR[:PORT] rather than looking up hosts.
+			 */
+			case 'E':
+				settings.connect = optarg;
+
+				continue;
+			/**
+			 * If --per-ip option was given, hold probes back
+			 * so at most N are in flight to each address. A
+			 * probe counts against the first address it tries.
+			 */
+			case 'B':
+				if (!is_numeric(optarg) || atoi(optarg) < 1 || atoi(optarg) > MAX_CONCURRENCY) {
+					fprintf(stderr, "Error: Invalid per-address limit %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				settings.per_ip = atoi(optarg);
+
+				continue;
+			/**
+			 * If --per-prefix option was given, hold probes back so
+			 * at most N are in flight to each /24 (or IPv6 /64), by
+			 * the first address each probe tries.
+			 */
+			case 'Q':
+				if (!is_numeric(optarg) || atoi(optarg) < 1 || atoi(optarg) > MAX_CONCURRENCY) {
+					fprintf(stderr, "Error: Invalid per-prefix limit %s.\n", optarg);
+					exit(EXIT_FAILURE);
+				}
+
+				settings.per_prefix = atoi(optarg);
+
+				continue;
+			/**
+			 * If --adaptive option was given, halve the number of
+			 * probes in flight as connects or handshakes fail, and
+			 * grow it back gradually as they succeed.
+			 */
+			case 'U':
+				settings.adaptive = 1;
+
 				continue;
 			/**
 			 * If --help option was given, output
@@ -229,576 +657,233 @@ int main (int argc, char **argv) {
 		}
 	} while (1);
 
-	/**
-	 * If no arguments were given,
-	 * complain to stderr and exit.
-	 */
-	if (last_index < 1) {
-		fprintf(stderr, "Error: Hostname not specified.\n");
+	if (settings.load && !is_null(settings.targets)) {
+		fprintf(stderr, "Error: --load takes a single hostname, not --targets.\n");
 		exit(EXIT_FAILURE);
 	}
 
-	/**
-	 * Limit length of hostname given as an argument.
-	 */
-	if (length(argv[last_index]) > MAX_HOSTNAME_LENGTH) {
-		fprintf(stderr, "Error: Hostname exceeds maximum length of 256 characters.\n");
+	if (settings.load && settings.format != FORMAT_TEXT) {
+		fprintf(stderr, "Error: --format cannot be combined with --load.\n");
 		exit(EXIT_FAILURE);
 	}
 
-	/**
-	 * The last element in argv should be the peer hostname.
-	 */
-	hostname = argv[last_index];
-
-	/**
-	 * Assemble URL for request.
-	 */
-	copy(url, protocol);
-	concat(url, "://");
-	concat(url, hostname);
-
-	/**
-	 * Run OpenSSL initialization tasks.
-	 */
-	SSL_load_error_strings();
-	ERR_load_crypto_strings();
-	OpenSSL_add_all_algorithms();
-	OpenSSL_add_all_digests();
-	SSL_library_init();
-
-	/**
-	 * Start execution clock.
-	 */
-	start = clock();
-
-	/**
-	 * Initialize new BIO.
-	 */
-	bp = BIO_new_fp(stdout, BIO_NOCLOSE);
-
-	/**
-	 * Method for peer connection.
-	 */
-	ssl_method = SSLv23_client_method();
-
-	if (!quiet) {
-		BIO_printf(
-			bp,
-			"%s [%fs] Establishing SSL context.\n",
-			KEUKA_NEUTRAL_INDICATOR,
-			get_elapsed_ticks(start)
-		);
+	if (!is_null(settings.decode) && settings.format == FORMAT_BIN) {
+		fprintf(stderr, "Error: --decode renders text or ndjson, not bin.\n");
+		exit(EXIT_FAILURE);
 	}
 
-	/**
-	 * Establish new SSL context.
-	 */
-	ctx = SSL_CTX_new(ssl_method);
-
-	if (is_null(ctx)) {
-		/**
-		 * Display error in progress format, unless given --quiet.
-		 */
-		if (!quiet) {
-			BIO_printf(
-				bp,
-				"%s [%fs] Error: Unable to establish SSL context.\n",
-				KEUKA_NEUTRAL_INDICATOR,
-				get_elapsed_ticks(start)
-			);
-		} else {
-			BIO_printf(bp, "Error: Unable to establish SSL context.\n");
-		}
-
-		goto on_error;
+	if (settings.cache_ttl && is_null(settings.cache)) {
+		fprintf(stderr, "Error: --cache-ttl requires --cache.\n");
+		exit(EXIT_FAILURE);
 	}
 
-	if (!quiet) {
-		BIO_printf(
-			bp,
-			"%s [%fs] SSL context established.\n",
-			KEUKA_NEUTRAL_INDICATOR,
-			get_elapsed_ticks(start)
-		);
+	if (!is_null(settings.since) && (settings.count > 1 || settings.resume)) {
+		fprintf(stderr, "Error: --since cannot be combined with --count or --resume.\n");
+		exit(EXIT_FAILURE);
 	}
 
-	/**
-	 * Make TCP socket connection.
-	 */
-	server = mksock(url, bp);
-
-	if (!quiet) {
-		BIO_printf(
-			bp,
-			"%s [%fs] Establishing connection to %s.\n",
-			KEUKA_OUTBOUND_INDICATOR,
-			get_elapsed_ticks(start),
-			hostname
-		);
+	if (settings.watch && (settings.load || !is_null(settings.decode) || !is_null(settings.since))) {
+		fprintf(stderr, "Error: --watch cannot be combined with --load, --decode or --since.\n");
+		exit(EXIT_FAILURE);
 	}
 
-	/**
-	 * Exit if there was an issue establishing a connection.
-	 */
-	if (is_error(server, -1)) {
-		/**
-		 * Display error in progress format, unless given --quiet.
-		 */
-		if (!quiet) {
-			BIO_printf(
-				bp,
-				"%s [%fs] Error: Unable to resolve hostname %s.\n",
-				KEUKA_INBOUND_INDICATOR,
-				get_elapsed_ticks(start),
-				hostname
-			);
-		} else {
-			BIO_printf(bp, "Error: Unable to resolve hostname %s.\n", hostname);
-		}
-
+	if (settings.watch && (settings.count > 1 || settings.resume || settings.cache_ttl)) {
+		fprintf(stderr, "Error: --watch cannot be combined with --count, --resume or --cache-ttl.\n");
 		exit(EXIT_FAILURE);
 	}
 
-	if (!quiet) {
-		BIO_printf(
-			bp,
-			"%s [%fs] Connection established.\n",
-			KEUKA_INBOUND_INDICATOR,
-			get_elapsed_ticks(start)
-		);
+	if (settings.enumerate && (settings.load || settings.watch || !is_null(settings.decode) || settings.format == FORMAT_BIN)) {
+		fprintf(stderr, "Error: --enumerate cannot be combined with --load, --watch, --decode or --format bin.\n");
+		exit(EXIT_FAILURE);
 	}
 
-	/**
-	 * Establish connection, set state in client mode.
-	 */
-	ssl = SSL_new(ctx);
-	SSL_set_connect_state(ssl);
-
-	/**
-	 * Disable SNI support if --no-sni was given.
-	 */
-	if (!no_sni) {
-		SSL_set_tlsext_host_name(ssl, hostname);
+	if (settings.enumerate && (settings.count > 1 || settings.resume || !is_null(settings.since) || !is_null(settings.cache))) {
+		fprintf(stderr, "Error: --enumerate cannot be combined with --count, --resume, --since or --cache.\n");
+		exit(EXIT_FAILURE);
 	}
 
-	if (!quiet) {
-		BIO_printf(
-			bp,
-			"%s [%fs] Attaching SSL session to socket.\n",
-			KEUKA_NEUTRAL_INDICATOR,
-			get_elapsed_ticks(start)
-		);
+	if (settings.verify && (settings.load || settings.enumerate || !is_null(settings.decode) || settings.format == FORMAT_BIN)) {
+		fprintf(stderr, "Error: --verify cannot be combined with --load, --enumerate, --decode or --format bin.\n");
+		exit(EXIT_FAILURE);
 	}
 
-	attach = SSL_set_fd(ssl, server);
-
-	/**
-	 * Attach the SSL session to the TCP socket.
-	 */
-	if (is_error(attach, -1)) {
-		/**
-		 * Display error in progress format, unless given --quiet.
-		 */
-		if (!quiet) {
-			BIO_printf(
-				bp,
-				"%s [%fs] Error: Unable to attach SSL session to socket.\n",
-				KEUKA_NEUTRAL_INDICATOR,
-				get_elapsed_ticks(start)
-			);
-		} else {
-			BIO_printf(bp, "Error: Unable to attach SSL session to socket.\n");
-		}
+	if (settings.cert_only && (settings.load || settings.enumerate || settings.resume)) {
+		fprintf(stderr, "Error: --cert-only cannot be combined with --load, --enumerate or --resume.\n");
+		exit(EXIT_FAILURE);
+	}
 
-		goto on_error;
+	if ((!is_null(settings.metrics_file) || settings.metrics_port) && (settings.load || settings.enumerate || !is_null(settings.decode))) {
+		fprintf(stderr, "Error: --metrics-file and --metrics-port cannot be combined with --load, --enumerate or --decode.\n");
+		exit(EXIT_FAILURE);
 	}
 
-	if (!quiet) {
-		BIO_printf(
-			bp,
-			"%s [%fs] SSL session attached, handshake initiated.\n",
-			KEUKA_OUTBOUND_INDICATOR,
-			get_elapsed_ticks(start)
-		);
+	if (!is_null(settings.trace) && (settings.load || settings.enumerate || !is_null(settings.decode))) {
+		fprintf(stderr, "Error: --trace cannot be combined with --load, --enumerate or --decode.\n");
+		exit(EXIT_FAILURE);
 	}
 
-	status = SSL_connect(ssl);
+	if (!is_null(settings.sni_list) && is_null(settings.connect)) {
+		fprintf(stderr, "Error: --sni-list requires --connect.\n");
+		exit(EXIT_FAILURE);
+	}
 
-	/**
-	 * Bridge the connection.
-	 */
-	if (status != 1) {
-		/**
-		 * Display error in progress format, unless given --quiet.
-		 */
-		if (!quiet) {
-			BIO_printf(
-				bp,
-				"%s [%fs] Error: Could not build SSL session with %s. Handshake aborted.\n",
-				KEUKA_NEUTRAL_INDICATOR,
-				get_elapsed_ticks(start),
-				url
-			);
-		} else {
-			BIO_printf(
-				bp,
-				"Error: Could not build SSL session with %s. Handshake aborted.\n",
-				url
-			);
-		}
+	if (!is_null(settings.sni_list) && (!is_null(settings.targets) || settings.load || settings.watch || settings.enumerate || !is_null(settings.decode))) {
+		fprintf(stderr, "Error: --sni-list cannot be combined with --targets, --load, --watch, --enumerate or --decode.\n");
+		exit(EXIT_FAILURE);
+	}
 
-		goto on_error;
+	if (!is_null(settings.sni_list) && (settings.count > 1 || settings.resume || settings.verify || settings.no_sni || !is_null(settings.since) || !is_null(settings.cache))) {
+		fprintf(stderr, "Error: --sni-list cannot be combined with --count, --resume, --verify, --no-sni, --since or --cache.\n");
+		exit(EXIT_FAILURE);
 	}
 
-	ssl_cipher = SSL_get_current_cipher(ssl);
+	if (!is_null(settings.sni_list) && (settings.format == FORMAT_BIN || !is_null(settings.metrics_file) || settings.metrics_port || !is_null(settings.trace))) {
+		fprintf(stderr, "Error: --sni-list cannot be combined with --format bin, --metrics-file, --metrics-port or --trace.\n");
+		exit(EXIT_FAILURE);
+	}
 
-	if (!quiet) {
-		BIO_printf(
-			bp,
-			"%s [%fs] %s negotiated, handshake complete.\n",
-			KEUKA_INBOUND_INDICATOR,
-			get_elapsed_ticks(start),
-			SSL_CIPHER_get_version(ssl_cipher)
-		);
+	if (!is_null(settings.connect) && (settings.load || settings.enumerate || !is_null(settings.decode))) {
+		fprintf(stderr, "Error: --connect cannot be combined with --load, --enumerate or --decode.\n");
+		exit(EXIT_FAILURE);
+	}
 
-		if (pad_fmt) {
-			BIO_printf(bp, "\n");
-		}
+	if ((settings.per_ip || settings.per_prefix || settings.adaptive) && (settings.load || settings.enumerate || !is_null(settings.sni_list) || !is_null(settings.decode))) {
+		fprintf(stderr, "Error: --per-ip, --per-prefix and --adaptive cannot be combined with --load, --enumerate, --sni-list or --decode.\n");
+		exit(EXIT_FAILURE);
 	}
 
-	/**
-	 * Print cipher used if --cipher was given.
-	 */
-	if (cipher) {
-		BIO_printf(
-			bp,
-			"--- Cipher: %s\n",
-			SSL_CIPHER_get_name(ssl_cipher)
-		);
+	if (settings.count > 1 && settings.resume) {
+		fprintf(stderr, "Error: --count cannot be combined with --resume.\n");
+		exit(EXIT_FAILURE);
 	}
 
 	/**
-	 * If --method option was given, output
-	 * version of method used for handshake.
+	 * Arenas (and allocation accounting) have to be in
+	 * place before OpenSSL (or anything else) allocates.
 	 */
-	if (method) {
-		BIO_printf(
-			bp,
-			"--- Method: %s\n",
-			SSL_get_version(ssl)
-		);
+	if ((settings.arena || settings.mem_stats)
+	    && is_error(Mem_arena_init((settings.arena ? MEM_ARENAS : 0) | (settings.mem_stats ? MEM_STATS : 0)), -1)) {
+		fprintf(stderr, "Error: Unable to set up arenas.\n");
+		exit(EXIT_FAILURE);
 	}
 
-	/**
-	 * Print full chain if --chain was given.
-	 */
-	if (chain) {
+	if (!is_null(settings.decode)) {
 		/**
-		 * Get peer certificate chain.
+		 * Nothing to probe, results are read back.
 		 */
-		fullchain = SSL_get_peer_cert_chain(ssl);
-
-		if (is_null(fullchain)) {
-			BIO_printf(
-				bp,
-				"Error: Could not get certificate chain from %s.\n",
-				url
-			);
-			goto on_error;
-		}
-
-		BIO_printf(bp, "--- Certificate Chain:\n");
+		list = NULL;
+	} else if (!is_null(settings.sni_list)) {
+		list = target_open(settings.sni_list);
 
+		if (is_null(list)) {
+			fprintf(stderr, "Error: Unable to open server name list %s.\n", settings.sni_list);
+			exit(EXIT_FAILURE);
+		}
+	} else if (is_null(settings.targets)) {
 		/**
-		 * Output certificate chain.
+		 * If no arguments were given,
+		 * complain to stderr and exit.
 		 */
-		for (
-			crt_index = 0;
-			crt_index < sk_X509_num(fullchain);
-			crt_index += 1
-		) {
-			pad_tfmt = 0;
-			tcrt = sk_X509_value(fullchain, crt_index);
-			tcrtname = X509_get_subject_name(tcrt);
-			tpubkey = X509_get_pubkey(tcrt);
-
-			BIO_printf(
-				bp,
-				"%5d: ",
-				(int) crt_index
-			);
-
-			/**
-			 * If --subject option was given, output certificate subject information.
-			 */
-			if (subject) {
-				BIO_printf(bp, "--- Subject: ");
-				X509_NAME_print_ex(
-					bp,
-					tcrtname,
-					0,
-					XN_FLAG_SEP_CPLUS_SPC
-				);
-				pad_tfmt = 1;
-			}
-
-			/**
-			 * If --issuer option was given, output certificate issuer information.
-			 */
-			if (issuer) {
-				if (pad_tfmt) {
-					BIO_printf(bp, "%s%7s", "\n", "");
-				} else {
-					pad_tfmt = 1;
-				}
-
-				BIO_printf(bp, "--- Issuer: ");
-				X509_NAME_print_ex(
-					bp,
-					X509_get_issuer_name(tcrt),
-					0,
-					XN_FLAG_SEP_CPLUS_SPC
-				);
-			}
-
-			if (bits) {
-				if (pad_tfmt) {
-					BIO_printf(bp, "%s%7s", "\n", "");
-				} else {
-					pad_tfmt = 1;
-				}
-
-				BIO_printf(
-					bp,
-					"--- Bits: %d",
-					EVP_PKEY_bits(tpubkey)
-				);
-			}
-
-			/**
-			 * If --serial option was given, output ASN1 serial.
-			 */
-			if (serial) {
-				if (pad_tfmt) {
-					BIO_printf(bp, "%s%7s", "\n", "");
-				} else {
-					pad_tfmt = 1;
-				}
-
-				BIO_printf(bp, "--- Serial: ");
-				i2a_ASN1_INTEGER(
-					bp,
-					X509_get_serialNumber(tcrt)
-				);
-			}
-
-			/**
-			 * If --signature-algorithm option was given,
-			 * output signature algorithm for certificate(s).
-			 */
-			if (sig_algo) {
-				if (pad_tfmt) {
-					BIO_printf(bp, "%s%7s", "\n", "");
-				} else {
-					pad_tfmt = 1;
-				}
-
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-				X509_get0_signature(&asn1_sig, &sig_type, tcrt);
-#else
-				sig_type = tcrt->sig_alg;
-				asn1_sig = tcrt->signature;
-#endif
-
-				BIO_printf(bp, "--- Signature Algorithm: ");
-				sig_type_err = i2a_ASN1_OBJECT(bp, sig_type->algorithm);
-
-				if (is_error(sig_type_err, -1) || is_error(sig_type_err, 0)) {
-					BIO_printf(bp, "Could not get signature algorithm.");
-				}
-			}
-
-			/**
-			 * If --validity option was given, output the
-			 * range of Not Before/Not After timestamps.
-			 */
-			if (validity) {
-				if (pad_tfmt) {
-					BIO_printf(bp, "%s%7s", "\n", "");
-				} else {
-					pad_tfmt = 1;
-				}
-
-				BIO_printf(bp, "--- Validity:\n");
-				BIO_printf(bp, "%11s%s", "", "--- Not Before: ");
-				ASN1_TIME_print(bp, X509_get_notBefore(tcrt));
-				BIO_printf(bp, "\n");
-				BIO_printf(bp, "%11s%s", "", "--- Not After: ");
-				ASN1_TIME_print(bp, X509_get_notAfter(tcrt));
-			}
-
-			if (!pad_tfmt) {
-				BIO_printf(bp, "[redacted]");
-			}
-
-			BIO_printf(bp, "\n");
+		if (optind > last_index) {
+			fprintf(stderr, "Error: Hostname not specified.\n");
+			exit(EXIT_FAILURE);
 		}
 
 		/**
-		 * Output raw certificate contents if --raw option was specified.
+		 * Limit length of hostname given as an argument.
 		 */
-		if (raw) {
-			BIO_printf(bp, "\n");
-			PEM_write_bio_PUBKEY(bp, tpubkey);
-			BIO_printf(bp, "\n");
-
-			for (
-				crt_index = 0;
-				crt_index < sk_X509_num(fullchain);
-				crt_index += 1
-			) {
-				PEM_write_bio_X509(
-					bp,
-					sk_X509_value(fullchain, crt_index)
-				);
-				BIO_printf(bp, "\n");
-			}
+		if (length(argv[last_index]) > MAX_HOSTNAME_LENGTH) {
+			fprintf(stderr, "Error: Hostname exceeds maximum length of 256 characters.\n");
+			exit(EXIT_FAILURE);
 		}
-	} else {
+
 		/**
-		 * Get peer certificate.
+		 * The last element in argv should be the peer hostname.
 		 */
-		crt = SSL_get_peer_certificate(ssl);
-
-		if (is_null(crt)) {
-			BIO_printf(
-				bp,
-				"Error: Could not get certificate from %s.\n",
-				url
-			);
-			goto on_error;
+		hostname = argv[last_index];
+		list = target_single(hostname);
+	} else {
+		list = target_open(settings.targets);
+
+		if (is_null(list)) {
+			fprintf(stderr, "Error: Unable to open targets file %s.\n", settings.targets);
+			exit(EXIT_FAILURE);
 		}
+	}
+
+	/**
+	 * Events are kept in memory until the end,
+	 * but the file should be writable up front.
+	 */
+	if (!is_null(settings.trace) && is_error(trace_open(settings.trace), -1)) {
+		fprintf(stderr, "Error: Unable to open trace file %s.\n", settings.trace);
+		exit(EXIT_FAILURE);
+	}
 
-		crtname = X509_get_subject_name(crt);
-		pubkey = X509_get_pubkey(crt);
+	/**
+	 * Run OpenSSL initialization tasks.
+	 */
+	SSL_load_error_strings();
+	ERR_load_crypto_strings();
+	OpenSSL_add_all_algorithms();
+	OpenSSL_add_all_digests();
+	SSL_library_init();
 
-		/**
-		 * If --subject option was given, output certificate subject information.
-		 */
-		if (subject) {
-			BIO_printf(bp, "--- Subject: ");
-			X509_NAME_print_ex(
-				bp,
-				crtname,
-				0,
-				XN_FLAG_SEP_COMMA_PLUS
-			);
-			BIO_printf(bp, "\n");
-		}
+	/**
+	 * Initialize new BIO.
+	 */
+	bp = BIO_new_fp(stdout, BIO_NOCLOSE);
 
+	if (!is_null(settings.decode)) {
 		/**
-		 * If --issuer option was given, output certificate issuer information.
+		 * Render results saved by an earlier run.
 		 */
-		if (issuer) {
-			BIO_printf(bp, "--- Issuer: ");
-			X509_NAME_print_ex(
-				bp,
-				X509_get_issuer_name(crt),
-				0,
-				XN_FLAG_SEP_CPLUS_SPC
-			);
-			BIO_printf(bp, "\n");
-		}
-
-		if (bits) {
-			BIO_printf(
-				bp,
-				"%s%d\n", "--- Bits: ",
-				EVP_PKEY_bits(pubkey)
-			);
-		}
-
+		status = record_decode(&settings, settings.decode, bp);
+	} else if (settings.load) {
 		/**
-		 * If --serial option was given, output ASN1 serial.
+		 * Generate handshake load against target.
 		 */
-		if (serial) {
-			BIO_printf(bp, "--- Serial: ");
-			i2a_ASN1_INTEGER(
-				bp,
-				X509_get_serialNumber(crt)
-			);
-			BIO_printf(bp, "\n");
-		}
-
+		status = target_next(list, &target)
+		       ? load_run(&settings, &target, bp)
+		       : EXIT_FAILURE;
+	} else if (!is_null(settings.sni_list)) {
 		/**
-		 * If --signature-algorithm option was given,
-		 * output signature algorithm for certificate(s).
+		 * Probe each server name at the one address.
 		 */
-		if (sig_algo) {
-#if OPENSSL_VERSION_NUMBER >= 0x10100000L
-			X509_get0_signature(&asn1_sig, &sig_type, crt);
-#else
-			sig_type = crt->sig_alg;
-			asn1_sig = crt->signature;
-#endif
-
-			BIO_printf(bp, "--- Signature Algorithm: ");
-			sig_type_err = i2a_ASN1_OBJECT(bp, sig_type->algorithm);
-			BIO_printf(bp, "\n");
-
-			if (is_error(sig_type_err, -1) || is_error(sig_type_err, 0)) {
-				BIO_printf(bp, "Error: Could not get signature algorithm.\n");
-			}
-		}
-
+		status = sweep_run(&settings, list, bp);
+	} else if (settings.enumerate) {
 		/**
-		 * If --validity option was given, output the
-		 * range of Not Before/Not After timestamps.
+		 * Try each version and cipher suite on target(s).
 		 */
-		if (validity) {
-			BIO_printf(bp, "%s", "--- Validity:\n");
-			BIO_printf(bp, "%4s%s", "", "--- Not Before: ");
-			ASN1_TIME_print(bp, X509_get_notBefore(crt));
-			BIO_printf(bp, "\n");
-			BIO_printf(bp, "%4s%s", "", "--- Not After: ");
-			ASN1_TIME_print(bp, X509_get_notAfter(crt));
-			BIO_printf(bp, "\n");
-		}
-
+		status = enum_run(&settings, list, bp);
+	} else {
 		/**
-		 * Output raw certificate contents if --raw option was specified.
+		 * Probe target(s), reporting as each completes.
 		 */
-		if (raw) {
-			BIO_printf(bp, "\n");
-			PEM_write_bio_PUBKEY(bp, pubkey);
-			BIO_printf(bp, "\n");
-			PEM_write_bio_X509(bp, crt);
-			BIO_printf(bp, "\n");
-		}
+		status = scan_run(&settings, list, bp);
 	}
 
-	EVP_PKEY_free(pubkey);
-	BIO_free(bp);
-	SSL_free(ssl);
-	close(server);
-	X509_free(crt);
-	X509_free(tcrt);
-	SSL_CTX_free(ctx);
-	ERR_free_strings();
-
-	return EXIT_SUCCESS;
+	/**
+	 * Targets that couldn't be parsed count as failures,
+	 * whether the only one given or lines of --targets.
+	 */
+	if (!is_null(list) && list->invalid > 0) {
+		status = EXIT_FAILURE;
+	}
 
-on_error:
-	ERR_print_errors(bp);
-	EVP_PKEY_free(pubkey);
+	trace_close();
+	target_close(list);
 	BIO_free(bp);
-	SSL_free(ssl);
-	close(server);
-	X509_free(crt);
-	X509_free(tcrt);
-	SSL_CTX_free(ctx);
 	ERR_free_strings();
 
-	return EXIT_FAILURE;
+	/**
+	 * With OpenSSL's own state torn down, whatever
+	 * is still live at this point was leaked.
+	 */
+	if (settings.mem_stats) {
+		OPENSSL_cleanup();
+		Mem_stats_print(stderr);
+	}
+
+	return status;
 }
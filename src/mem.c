@@ -6,15 +6,376 @@
 
 #include "mem.h"
 
+#define MEM_ROUND(n) (((n) + MEM_ALIGN - 1) & ~((size_t) MEM_ALIGN - 1))
+#define MEM_CHUNK_HEADER MEM_ROUND(sizeof(mem_chunk_t))
+#define MEM_HEADER MEM_ROUND(sizeof(mem_header_t))
+
 const Except_T Mem_Failed = {
 	"Allocation Failed"
 };
 
+/**
+ * Whether allocations carry a header, whether they
+ * may be bumped out of an arena, and whether they're
+ * accounted to their call site. Set once, at startup.
+ */
+static int mem_headers = 0;
+static int mem_arenas = 0;
+static int mem_stats = 0;
+
+/**
+ * Arena allocations on this thread go to, if any.
+ */
+static __thread mem_arena_t *mem_current = NULL;
+
+static pthread_mutex_t mem_lock = PTHREAD_MUTEX_INITIALIZER;
+static mem_chunk_t *mem_spares = NULL;
+static int mem_nspares = 0;
+
+static pthread_mutex_t mem_site_lock = PTHREAD_MUTEX_INITIALIZER;
+static mem_site_t mem_sites[MEM_SITES];
+static mem_tally_t mem_total;
+
+/**
+ * Account allocation of nbytes to tally.
+ */
+static void mem_tally_add (mem_tally_t *tally, size_t nbytes) {
+	tally->allocs += 1;
+	tally->bytes += (long) nbytes;
+	tally->live += (long) nbytes;
+
+	if (tally->live > tally->peak) {
+		tally->peak = tally->live;
+	}
+}
+
+/**
+ * Account release of nbytes to tally.
+ */
+static void mem_tally_sub (mem_tally_t *tally, size_t nbytes) {
+	tally->frees += 1;
+	tally->live -= (long) nbytes;
+}
+
+/**
+ * Find (or add) call site, by the address of its file
+ * name and its line. Once the table is full, the rest
+ * are lumped in with the last slot. Called with the
+ * site lock held.
+ */
+static mem_site_t *mem_site (const char *file, int line) {
+	size_t index, probes;
+	mem_site_t *site;
+
+	if (is_null((void *) file)) {
+		file = "?";
+	}
+
+	index = (((uintptr_t) file >> 4) ^ ((size_t) line * 2654435761U)) % MEM_SITES;
+
+	for (probes = 0; probes < MEM_SITES - 1; probes += 1) {
+		site = &mem_sites[index];
+
+		if (is_null((void *) site->file)) {
+			site->file = file;
+			site->line = line;
+			return site;
+		}
+
+		if (site->file == file && site->line == line) {
+			return site;
+		}
+
+		index = (index + 1) % MEM_SITES;
+	}
+
+	return &mem_sites[MEM_SITES - 1];
+}
+
+/**
+ * Drop a reference to arena, releasing it with the last.
+ */
+static void mem_arena_put (mem_arena_t *arena) {
+	if (__atomic_sub_fetch(&arena->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+		free(arena);
+	}
+}
+
+/**
+ * Account new allocation to its call site, and to
+ * the current arena (i.e. probe), if --mem-stats.
+ */
+static void mem_track (mem_header_t *header, const char *file, int line) {
+	long live;
+	mem_arena_t *arena = mem_current;
+
+	header->arena = NULL;
+	header->site = NULL;
+
+	if (!mem_stats) {
+		return;
+	}
+
+	pthread_mutex_lock(&mem_site_lock);
+	header->site = mem_site(file, line);
+	mem_tally_add(&header->site->tally, header->size);
+	mem_tally_add(&mem_total, header->size);
+	pthread_mutex_unlock(&mem_site_lock);
+
+	if (!is_null(arena)) {
+		header->arena = arena;
+		__atomic_add_fetch(&arena->refs, 1, __ATOMIC_RELAXED);
+		arena->tally.allocs += 1;
+		arena->tally.bytes += (long) header->size;
+		live = __atomic_add_fetch(&arena->tally.live, (long) header->size, __ATOMIC_RELAXED);
+
+		if (live > arena->tally.peak) {
+			arena->tally.peak = live;
+		}
+	}
+}
+
+/**
+ * Account release of allocation. Allocations may
+ * be freed on any thread, so the arena's count is
+ * updated atomically.
+ */
+static void mem_untrack (mem_header_t *header) {
+	mem_arena_t *arena = header->arena;
+
+	if (is_null(header->site)) {
+		return;
+	}
+
+	pthread_mutex_lock(&mem_site_lock);
+	mem_tally_sub(&header->site->tally, header->size);
+	mem_tally_sub(&mem_total, header->size);
+	pthread_mutex_unlock(&mem_site_lock);
+
+	if (!is_null(arena)) {
+		__atomic_add_fetch(&arena->tally.frees, 1, __ATOMIC_RELAXED);
+		__atomic_sub_fetch(&arena->tally.live, (long) header->size, __ATOMIC_RELAXED);
+		mem_arena_put(arena);
+	}
+}
+
+/**
+ * Order sites by bytes still live, then peak.
+ */
+static int mem_site_compare (const void *a, const void *b) {
+	const mem_site_t *x = *(const mem_site_t * const *) a,
+	                 *y = *(const mem_site_t * const *) b;
+
+	if (x->tally.live != y->tally.live) {
+		return (x->tally.live < y->tally.live) ? 1 : -1;
+	}
+
+	if (x->tally.peak != y->tally.peak) {
+		return (x->tally.peak < y->tally.peak) ? 1 : -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Take a chunk off the spares, or make a new one.
+ */
+static mem_chunk_t *mem_chunk_get (mem_arena_t *arena) {
+	mem_chunk_t *chunk;
+
+	pthread_mutex_lock(&mem_lock);
+	chunk = mem_spares;
+
+	if (!is_null(chunk)) {
+		mem_spares = chunk->next;
+		mem_nspares -= 1;
+	}
+
+	pthread_mutex_unlock(&mem_lock);
+
+	if (is_null(chunk)) {
+		chunk = malloc(MEM_CHUNK_SIZE);
+
+		if (is_null(chunk)) {
+			return NULL;
+		}
+	}
+
+	chunk->next = arena->chunks;
+	chunk->arena = arena;
+	chunk->live = 1;
+	chunk->used = MEM_CHUNK_HEADER;
+	arena->chunks = chunk;
+
+	return chunk;
+}
+
+/**
+ * Put chunk with nothing left in it back on the spares.
+ */
+static void mem_chunk_put (mem_chunk_t *chunk) {
+	pthread_mutex_lock(&mem_lock);
+
+	if (mem_nspares < MEM_ARENA_SPARES) {
+		chunk->next = mem_spares;
+		mem_spares = chunk;
+		mem_nspares += 1;
+		chunk = NULL;
+	}
+
+	pthread_mutex_unlock(&mem_lock);
+
+	free(chunk);
+}
+
+/**
+ * Allocate nbytes, bumped out of the current arena if
+ * there is one and it's small enough, from malloc if
+ * not. Either way, it's preceded by a header.
+ */
+static void *mem_get (size_t nbytes, const char *file, int line) {
+	size_t total;
+	mem_chunk_t *chunk;
+	mem_header_t *header;
+	mem_arena_t *arena = mem_current;
+
+	if (mem_arenas && !is_null(arena) && nbytes <= MEM_ARENA_MAX_ALLOC) {
+		total = MEM_HEADER + MEM_ROUND(nbytes);
+		chunk = arena->chunks;
+
+		if (is_null(chunk) || chunk->used + total > MEM_CHUNK_SIZE) {
+			chunk = mem_chunk_get(arena);
+		}
+
+		if (!is_null(chunk)) {
+			header = (mem_header_t *) ((char *) chunk + chunk->used);
+			header->chunk = chunk;
+			header->size = nbytes;
+			chunk->used += total;
+			__atomic_add_fetch(&chunk->live, 1, __ATOMIC_RELAXED);
+			mem_track(header, file, line);
+
+			return (char *) header + MEM_HEADER;
+		}
+	}
+
+	header = malloc(MEM_HEADER + nbytes);
+
+	if (is_null(header)) {
+		return NULL;
+	}
+
+	header->chunk = NULL;
+	header->size = nbytes;
+	mem_track(header, file, line);
+
+	return (char *) header + MEM_HEADER;
+}
+
+/**
+ * Release allocation made by mem_get. Memory from an
+ * arena isn't reused on its own, but if the chunk it
+ * came from is the one the arena is bumping out of,
+ * and this was the last allocation in it (or the chunk
+ * is now empty), the space is taken back right away,
+ * so short-lived buffers don't use up the arena.
+ */
+static void mem_put (void *ptr) {
+	mem_chunk_t *chunk;
+	mem_header_t *header;
+
+	header = (mem_header_t *) ((char *) ptr - MEM_HEADER);
+	chunk = header->chunk;
+	mem_untrack(header);
+
+	if (is_null(chunk)) {
+		free(header);
+		return;
+	}
+
+	if (__atomic_sub_fetch(&chunk->live, 1, __ATOMIC_ACQ_REL) == 0) {
+		mem_chunk_put(chunk);
+		return;
+	}
+
+	if (is_null(mem_current) || chunk->arena != mem_current || mem_current->chunks != chunk) {
+		return;
+	}
+
+	if (__atomic_load_n(&chunk->live, __ATOMIC_ACQUIRE) == 1) {
+		chunk->used = MEM_CHUNK_HEADER;
+	} else if ((char *) header + MEM_HEADER + MEM_ROUND(header->size) == (char *) chunk + chunk->used) {
+		chunk->used = (size_t) ((char *) header - (char *) chunk);
+	}
+}
+
+/**
+ * Resize allocation made by mem_get.
+ */
+static void *mem_reget (void *ptr, size_t nbytes, const char *file, int line) {
+	void *copy;
+	mem_header_t *header;
+
+	header = (mem_header_t *) ((char *) ptr - MEM_HEADER);
+
+	if (is_null(header->chunk) && (!mem_arenas || is_null(mem_current))) {
+		mem_untrack(header);
+		header = realloc(header, MEM_HEADER + nbytes);
+
+		if (is_null(header)) {
+			return NULL;
+		}
+
+		header->size = nbytes;
+		mem_track(header, file, line);
+
+		return (char *) header + MEM_HEADER;
+	}
+
+	copy = mem_get(nbytes, file, line);
+
+	if (is_null(copy)) {
+		return NULL;
+	}
+
+	memcpy(copy, ptr, (header->size < nbytes) ? header->size : nbytes);
+	mem_put(ptr);
+
+	return copy;
+}
+
+/**
+ * Allocation hooks for OpenSSL, so the objects it
+ * makes during a handshake land in the probe's arena.
+ */
+static void *mem_crypto_malloc (size_t num, const char *file, int line) {
+	return (num == 0) ? NULL : mem_get(num, file, line);
+}
+
+static void *mem_crypto_realloc (void *ptr, size_t num, const char *file, int line) {
+	if (is_null(ptr)) {
+		return mem_crypto_malloc(num, file, line);
+	}
+
+	if (num == 0) {
+		mem_put(ptr);
+		return NULL;
+	}
+
+	return mem_reget(ptr, num, file, line);
+}
+
+static void mem_crypto_free (void *ptr, const char *file, int line) {
+	if (!is_null(ptr)) {
+		mem_put(ptr);
+	}
+}
+
 void *Mem_alloc (long nbytes, const char *file, int line) {
 	void *ptr;
 
 	assert(nbytes > 0);
-	ptr = malloc(nbytes);
+	ptr = mem_headers ? mem_get(nbytes, file, line) : malloc(nbytes);
 
 	if (is_null(ptr)) {
 		if (is_null(file)) {
@@ -32,7 +393,16 @@ void *Mem_calloc (long count, long nbytes, const char *file, int line) {
 
 	assert(count > 0);
 	assert(nbytes > 0);
-	ptr = calloc(count, nbytes);
+
+	if (mem_headers) {
+		ptr = mem_get((size_t) count * nbytes, file, line);
+
+		if (!is_null(ptr)) {
+			memset(ptr, 0, (size_t) count * nbytes);
+		}
+	} else {
+		ptr = calloc(count, nbytes);
+	}
 
 	if (is_null(ptr)) {
 		if (is_null(file)) {
@@ -47,14 +417,18 @@ void *Mem_calloc (long count, long nbytes, const char *file, int line) {
 
 void Mem_free (void *ptr, const char *file, int line) {
 	if (ptr) {
-		free(ptr);
+		if (mem_headers) {
+			mem_put(ptr);
+		} else {
+			free(ptr);
+		}
 	}
 }
 
 void *Mem_resize (void *ptr, long nbytes, const char *file, int line) {
 	assert(ptr);
 	assert(nbytes > 0);
-	ptr = realloc(ptr, nbytes);
+	ptr = mem_headers ? mem_reget(ptr, nbytes, file, line) : realloc(ptr, nbytes);
 
 	if (is_null(ptr)) {
 		if (is_null(file)) {
@@ -66,3 +440,139 @@ void *Mem_resize (void *ptr, long nbytes, const char *file, int line) {
 
 	return ptr;
 }
+
+/**
+ * Enable arenas and/or stats (per flags), and route
+ * OpenSSL's allocations through them. Must be called
+ * before anything is allocated, by either. Returns -1
+ * if OpenSSL has allocated already.
+ */
+int Mem_arena_init (int flags) {
+	if (!CRYPTO_set_mem_functions(mem_crypto_malloc, mem_crypto_realloc, mem_crypto_free)) {
+		return -1;
+	}
+
+	mem_headers = 1;
+	mem_arenas = !!(flags & MEM_ARENAS);
+	mem_stats = !!(flags & MEM_STATS);
+
+	return 0;
+}
+
+/**
+ * Create new arena, or NULL if neither
+ * arenas nor stats are enabled.
+ */
+mem_arena_t *Mem_arena_new (void) {
+	mem_arena_t *arena;
+
+	if (!mem_headers) {
+		return NULL;
+	}
+
+	arena = calloc(1, sizeof(*arena));
+
+	if (is_null(arena)) {
+		return NULL;
+	}
+
+	arena->refs = 1;
+
+	return arena;
+}
+
+/**
+ * Release arena. Chunks with nothing left in them go
+ * back to the spares at once. Those with allocations
+ * that outlive the arena (e.g. a session handed on to
+ * the next round) follow when the last is freed.
+ */
+void Mem_arena_free (mem_arena_t *arena) {
+	mem_chunk_t *chunk, *next;
+
+	if (is_null(arena)) {
+		return;
+	}
+
+	for (chunk = arena->chunks; !is_null(chunk); chunk = next) {
+		next = chunk->next;
+		chunk->arena = NULL;
+
+		if (__atomic_sub_fetch(&chunk->live, 1, __ATOMIC_ACQ_REL) == 0) {
+			mem_chunk_put(chunk);
+		}
+	}
+
+	arena->chunks = NULL;
+	mem_arena_put(arena);
+}
+
+/**
+ * Make arena current on this thread, until left.
+ * Returns the arena that was current before.
+ */
+mem_arena_t *Mem_arena_enter (mem_arena_t *arena) {
+	mem_arena_t *previous = mem_current;
+
+	mem_current = arena;
+
+	return previous;
+}
+
+/**
+ * Go back to the arena that was current before.
+ */
+void Mem_arena_leave (mem_arena_t *previous) {
+	mem_current = previous;
+}
+
+/**
+ * Print allocation totals for the run, followed by
+ * the call sites with the most bytes still live (or
+ * the highest peak, when nothing is), if --mem-stats.
+ */
+void Mem_stats_print (FILE *fp) {
+	int index, count;
+	mem_site_t *sites[MEM_SITES], *site;
+
+	if (!mem_stats) {
+		return;
+	}
+
+	pthread_mutex_lock(&mem_site_lock);
+
+	for (index = 0, count = 0; index < MEM_SITES; index += 1) {
+		if (!is_null((void *) mem_sites[index].file)) {
+			sites[count++] = &mem_sites[index];
+		}
+	}
+
+	qsort(sites, (size_t) count, sizeof(sites[0]), mem_site_compare);
+
+	fprintf(
+		fp,
+		"--- Memory: %ld allocations, %ld freed, %ld bytes, peak %ld bytes live, %ld bytes still live\n",
+		mem_total.allocs,
+		mem_total.frees,
+		mem_total.bytes,
+		mem_total.peak,
+		mem_total.live
+	);
+
+	for (index = 0; index < count && index < MEM_TOP_SITES; index += 1) {
+		site = sites[index];
+
+		fprintf(
+			fp,
+			"%4slive=%-9ld peak=%-9ld allocs=%-8ld %s:%d\n",
+			"",
+			site->tally.live,
+			site->tally.peak,
+			site->tally.allocs,
+			site->file,
+			site->line
+		);
+	}
+
+	pthread_mutex_unlock(&mem_site_lock);
+}
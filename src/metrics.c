@@ -0,0 +1,412 @@
+/**
+ * metrics.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "metrics.h"
+
+/**
+ * Upper bounds of the latency histogram buckets,
+ * in seconds, as exposed. The last is +Inf.
+ */
+static const double metrics_bounds[] = {
+	0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10,
+};
+
+/**
+ * Count one more probe under name, in labels. Names
+ * past the last that fits are counted as "other".
+ */
+static void metrics_label (metrics_label_t *labels, int *count, const char *name) {
+	int index;
+
+	for (index = 0; index < *count; index += 1) {
+		if (!strcmp(labels[index].name, name)) {
+			labels[index].count += 1;
+			return;
+		}
+	}
+
+	if (*count >= METRICS_MAX_LABELS - 1) {
+		name = "other";
+
+		for (index = 0; index < *count; index += 1) {
+			if (!strcmp(labels[index].name, name)) {
+				labels[index].count += 1;
+				return;
+			}
+		}
+	}
+
+	if (*count < METRICS_MAX_LABELS) {
+		snprintf(labels[*count].name, METRICS_MAX_LABEL, "%s", name);
+		labels[*count].count = 1;
+		*count += 1;
+	}
+}
+
+static void metrics_counter (buf_t *buf, const char *name, const char *help, uint64_t value) {
+	buf_printf(buf, "# HELP %s %s\n# TYPE %s counter\n%s %llu\n", name, help, name, name, (unsigned long long) value);
+}
+
+static void metrics_labels (buf_t *buf, const char *name, const char *help, const char *key, const metrics_label_t *labels, int count) {
+	int index;
+
+	buf_printf(buf, "# HELP %s %s\n# TYPE %s counter\n", name, help, name);
+
+	for (index = 0; index < count; index += 1) {
+		buf_printf(buf, "%s{%s=\"%s\"} %llu\n", name, key, labels[index].name, (unsigned long long) labels[index].count);
+	}
+}
+
+/**
+ * Histogram samples, with phase as a label, if given.
+ */
+static void metrics_hist (buf_t *buf, const char *name, const char *phase, const hist_t *hist) {
+	int index;
+	char label[32];
+
+	label[0] = '\0';
+
+	if (!is_null((void *) phase)) {
+		snprintf(label, sizeof(label), "phase=\"%s\",", phase);
+	}
+
+	for (index = 0; index < (int) (sizeof(metrics_bounds) / sizeof(metrics_bounds[0])); index += 1) {
+		buf_printf(
+			buf,
+			"%s_bucket{%sle=\"%g\"} %llu\n",
+			name,
+			label,
+			metrics_bounds[index],
+			(unsigned long long) hist_count(hist, (uint64_t) (metrics_bounds[index] * NSEC_PER_SEC))
+		);
+	}
+
+	buf_printf(buf, "%s_bucket{%sle=\"+Inf\"} %llu\n", name, label, (unsigned long long) hist->total);
+
+	/**
+	 * Drop the trailing comma, for the sum and count.
+	 */
+	if (label[0]) {
+		label[strlen(label) - 1] = '\0';
+	}
+
+	buf_printf(
+		buf,
+		"%s_sum%s%s%s %f\n%s_count%s%s%s %llu\n",
+		name,
+		label[0] ? "{" : "",
+		label,
+		label[0] ? "}" : "",
+		(double) hist->sum / NSEC_PER_SEC,
+		name,
+		label[0] ? "{" : "",
+		label,
+		label[0] ? "}" : "",
+		(unsigned long long) hist->total
+	);
+}
+
+/**
+ * Render every metric into the buffer.
+ */
+static void metrics_render (metrics_t *metrics) {
+	int phase, error;
+	buf_t *buf = metrics->buf;
+
+	buf_reset(buf);
+	metrics_counter(buf, "keuka_probes_started_total", "Probes started.", metrics->started);
+	metrics_counter(buf, "keuka_probes_completed_total", "Probes completed, successfully or not.", metrics->completed);
+	metrics_counter(buf, "keuka_probes_cached_total", "Targets reported from the cache, in place of a probe.", metrics->cached);
+
+	buf_puts(
+		buf,
+		"# HELP keuka_probes_failed_total Probes failed, by the phase they failed in, and why.\n"
+		"# TYPE keuka_probes_failed_total counter\n"
+	);
+
+	for (phase = 0; phase < NUM_PHASES; phase += 1) {
+		for (error = PROBE_OK + 1; error < NUM_PROBE_ERRORS; error += 1) {
+			if (metrics->failed[phase][error]) {
+				buf_printf(
+					buf,
+					"keuka_probes_failed_total{phase=\"%s\",error=\"%s\"} %llu\n",
+					phase_name(phase),
+					probe_error_name(error),
+					(unsigned long long) metrics->failed[phase][error]
+				);
+			}
+		}
+	}
+
+	buf_printf(
+		buf,
+		"# HELP keuka_probes_in_flight Probes started, but not yet completed.\n"
+		"# TYPE keuka_probes_in_flight gauge\n"
+		"keuka_probes_in_flight %llu\n",
+		(unsigned long long) (metrics->started - metrics->completed)
+	);
+
+	metrics_counter(buf, "keuka_bytes_read_total", "Bytes read from peers over TLS sessions.", metrics->bytes_read);
+	metrics_counter(buf, "keuka_bytes_written_total", "Bytes written to peers over TLS sessions.", metrics->bytes_written);
+
+	buf_puts(
+		buf,
+		"# HELP keuka_phase_duration_seconds Duration of each phase probes got through, up to the handshake.\n"
+		"# TYPE keuka_phase_duration_seconds histogram\n"
+	);
+
+	for (phase = 0; phase < PHASE_EXTRACT; phase += 1) {
+		metrics_hist(buf, "keuka_phase_duration_seconds", phase_name(phase), metrics->latency[phase]);
+	}
+
+	buf_puts(
+		buf,
+		"# HELP keuka_probe_duration_seconds Total duration of successful probes.\n"
+		"# TYPE keuka_probe_duration_seconds histogram\n"
+	);
+
+	metrics_hist(buf, "keuka_probe_duration_seconds", NULL, metrics->latency[NUM_PHASES]);
+	metrics_labels(buf, "keuka_protocols_total", "Successful probes, by negotiated protocol.", "protocol", metrics->protocols, metrics->nprotocols);
+	metrics_labels(buf, "keuka_ciphers_total", "Successful probes, by negotiated cipher suite.", "cipher", metrics->ciphers, metrics->nciphers);
+}
+
+/**
+ * Write metrics out to the file, replacing it in
+ * one go, so it's never read half written.
+ */
+static void metrics_write (metrics_t *metrics) {
+	int fd;
+	char path[PATH_MAX];
+
+	if (is_null((void *) metrics->path)) {
+		return;
+	}
+
+	snprintf(path, sizeof(path), "%s.tmp", metrics->path);
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	if (is_error(fd, -1)) {
+		return;
+	}
+
+	metrics_render(metrics);
+
+	if (is_error(buf_write(metrics->buf, fd), -1)) {
+		close(fd);
+		unlink(path);
+		return;
+	}
+
+	close(fd);
+	rename(path, metrics->path);
+}
+
+/**
+ * Timer callback, rewrite the file periodically.
+ */
+static void metrics_tick (ev_timer_t *timer) {
+	metrics_t *metrics = timer->arg;
+
+	metrics_write(metrics);
+	ev_timer_start(metrics->loop, &metrics->timer, METRICS_INTERVAL * NSEC_PER_SEC);
+}
+
+static void metrics_close (metrics_client_t *client) {
+	metrics_client_t **link;
+	metrics_t *metrics = client->metrics;
+
+	for (link = &metrics->clients; *link != client; link = &(*link)->next) {
+		continue;
+	}
+
+	*link = client->next;
+	ev_del(metrics->loop, &client->watch);
+	close(client->watch.fd);
+	FREE(client);
+}
+
+/**
+ * Readiness callback for a scrape. The reply is small
+ * enough to go out with a single write on a new socket.
+ */
+static void metrics_reply (ev_watch_t *watch, int events) {
+	ssize_t status;
+	char request[METRICS_MAX_REQUEST];
+	char header[128];
+	metrics_client_t *client = watch->arg;
+	metrics_t *metrics = client->metrics;
+
+	status = recv(watch->fd, request, sizeof(request), 0);
+
+	if (is_error(status, -1) && (errno == EAGAIN || errno == EINTR)) {
+		return;
+	}
+
+	if (status > 0) {
+		metrics_render(metrics);
+		snprintf(
+			header,
+			sizeof(header),
+			"HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %lu\r\n\r\n",
+			(unsigned long) metrics->buf->len
+		);
+
+		if (send(watch->fd, header, strlen(header), MSG_NOSIGNAL) > 0) {
+			send(watch->fd, metrics->buf->data, metrics->buf->len, MSG_NOSIGNAL);
+		}
+
+		shutdown(watch->fd, SHUT_WR);
+	}
+
+	metrics_close(client);
+}
+
+/**
+ * Readiness callback for the metrics port.
+ */
+static void metrics_accept (ev_watch_t *watch, int events) {
+	int fd, flags;
+	metrics_client_t *client;
+	metrics_t *metrics = watch->arg;
+
+	while (!is_error(fd = accept(watch->fd, NULL, NULL), -1)) {
+		flags = fcntl(fd, F_GETFL, 0);
+
+		if (is_error(flags, -1) || is_error(fcntl(fd, F_SETFL, flags | O_NONBLOCK), -1)) {
+			close(fd);
+			continue;
+		}
+
+		NEW0(client);
+		client->metrics = metrics;
+		client->next = metrics->clients;
+		metrics->clients = client;
+		ev_set(&client->watch, fd, metrics_reply, client);
+
+		if (is_error(ev_add(metrics->loop, &client->watch, EV_READ), -1)) {
+			metrics_close(client);
+		}
+	}
+}
+
+/**
+ * New metrics, written to path (if given) and served
+ * on port (if not 0). Returns NULL if the port can't
+ * be listened on.
+ */
+metrics_t *metrics_new (ev_loop_t *loop, const char *path, int port) {
+	int index;
+	metrics_t *metrics;
+
+	NEW0(metrics);
+	metrics->loop = loop;
+	metrics->path = path;
+	metrics->fd = -1;
+	metrics->buf = buf_new(BUF_INITIAL_SIZE);
+	ev_timer_set(&metrics->timer, metrics_tick, metrics);
+
+	for (index = 0; index <= NUM_PHASES; index += 1) {
+		metrics->latency[index] = hist_new();
+	}
+
+	if (port) {
+		metrics->fd = sock_listen(port);
+		ev_set(&metrics->watch, metrics->fd, metrics_accept, metrics);
+
+		if (is_error(metrics->fd, -1) || is_error(ev_add(loop, &metrics->watch, EV_READ), -1)) {
+			metrics_free(metrics);
+			return NULL;
+		}
+	}
+
+	if (!is_null((void *) path)) {
+		ev_timer_start(loop, &metrics->timer, METRICS_INTERVAL * NSEC_PER_SEC);
+	}
+
+	return metrics;
+}
+
+/**
+ * Write the file a last time, then stop serving.
+ */
+void metrics_free (metrics_t *metrics) {
+	int index;
+
+	if (is_null(metrics)) {
+		return;
+	}
+
+	metrics_write(metrics);
+
+	if (ev_timer_active(&metrics->timer)) {
+		ev_timer_stop(metrics->loop, &metrics->timer);
+	}
+
+	while (!is_null(metrics->clients)) {
+		metrics_close(metrics->clients);
+	}
+
+	if (!is_error(metrics->fd, -1)) {
+		if (!is_error(metrics->watch.slot, NOT_FOUND)) {
+			ev_del(metrics->loop, &metrics->watch);
+		}
+
+		close(metrics->fd);
+	}
+
+	for (index = 0; index <= NUM_PHASES; index += 1) {
+		hist_free(metrics->latency[index]);
+	}
+
+	buf_free(metrics->buf);
+	FREE(metrics);
+}
+
+void metrics_started (metrics_t *metrics) {
+	metrics->started += 1;
+}
+
+void metrics_cached (metrics_t *metrics) {
+	metrics->cached += 1;
+}
+
+/**
+ * Account for a finished probe. Failures are put
+ * down to the last phase the probe had begun.
+ */
+void metrics_done (metrics_t *metrics, const probe_t *probe) {
+	int phase, failed;
+	BIO *rbio, *wbio;
+
+	metrics->completed += 1;
+	failed = PHASE_RESOLVE;
+
+	for (phase = 0; phase < NUM_PHASES; phase += 1) {
+		if (probe->timing.begin[phase]) {
+			failed = phase;
+		}
+
+		if (probe->timing.end[phase]) {
+			hist_record(metrics->latency[phase], timing_duration(&probe->timing, phase));
+		}
+	}
+
+	if (!is_null(probe->ssl)) {
+		rbio = SSL_get_rbio(probe->ssl);
+		wbio = SSL_get_wbio(probe->ssl);
+		metrics->bytes_read += is_null(rbio) ? 0 : BIO_number_read(rbio);
+		metrics->bytes_written += is_null(wbio) ? 0 : BIO_number_written(wbio);
+	}
+
+	if (probe->state != PROBE_DONE) {
+		metrics->failed[failed][probe->error] += 1;
+		return;
+	}
+
+	hist_record(metrics->latency[NUM_PHASES], timing_total(&probe->timing));
+	metrics_label(metrics->protocols, &metrics->nprotocols, SSL_get_version(probe->ssl));
+	metrics_label(metrics->ciphers, &metrics->nciphers, SSL_CIPHER_get_name(probe_cipher(probe->ssl)));
+}
@@ -0,0 +1,247 @@
+/**
+ * pool.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "pool.h"
+
+/**
+ * Add task to the bottom of deque.
+ */
+static void deque_push (pool_deque_t *deque, pool_fn_t fn, void *arg) {
+	int index;
+	pool_task_t *tasks;
+
+	pthread_mutex_lock(&deque->lock);
+
+	if (deque->count == deque->cap) {
+		tasks = CALLOC(deque->cap * 2, (long) sizeof(pool_task_t));
+
+		for (index = 0; index < deque->count; index += 1) {
+			tasks[index] = deque->tasks[(deque->head + index) % deque->cap];
+		}
+
+		FREE(deque->tasks);
+		deque->tasks = tasks;
+		deque->head = 0;
+		deque->cap *= 2;
+	}
+
+	index = (deque->head + deque->count) % deque->cap;
+	deque->tasks[index].fn = fn;
+	deque->tasks[index].arg = arg;
+	deque->count += 1;
+
+	pthread_mutex_unlock(&deque->lock);
+}
+
+/**
+ * Take task from the bottom (own work) or the
+ * top (stolen work) of deque. Returns 1 if a
+ * task was taken, 0 if the deque was empty.
+ */
+static int deque_take (pool_deque_t *deque, pool_task_t *task, int steal) {
+	int index;
+
+	pthread_mutex_lock(&deque->lock);
+
+	if (deque->count == 0) {
+		pthread_mutex_unlock(&deque->lock);
+		return 0;
+	}
+
+	if (steal) {
+		index = deque->head;
+		deque->head = (deque->head + 1) % deque->cap;
+	} else {
+		index = (deque->head + deque->count - 1) % deque->cap;
+	}
+
+	*task = deque->tasks[index];
+	deque->count -= 1;
+
+	pthread_mutex_unlock(&deque->lock);
+
+	return 1;
+}
+
+/**
+ * Find a task for worker, from its own deque
+ * first, then from a random victim onwards.
+ */
+static int pool_take (pool_worker_t *worker, pool_task_t *task) {
+	int index, victim;
+	pool_t *pool = worker->pool;
+
+	if (deque_take(&worker->deque, task, 0)) {
+		goto on_taken;
+	}
+
+	victim = (int) (rand_r(&worker->seed) % (unsigned int) pool->nworkers);
+
+	for (index = 0; index < pool->nworkers; index += 1) {
+		if ((victim + index) % pool->nworkers == worker->id) {
+			continue;
+		}
+
+		if (deque_take(&pool->workers[(victim + index) % pool->nworkers].deque, task, 1)) {
+			goto on_taken;
+		}
+	}
+
+	return 0;
+
+on_taken:
+	pthread_mutex_lock(&pool->lock);
+	pool->queued -= 1;
+	pthread_mutex_unlock(&pool->lock);
+
+	return 1;
+}
+
+/**
+ * Worker thread, runs tasks until the pool is released.
+ */
+static void *pool_worker (void *arg) {
+	pool_task_t task;
+	pool_worker_t *worker = arg;
+	pool_t *pool = worker->pool;
+
+	for (;;) {
+		if (pool_take(worker, &task)) {
+			task.fn(task.arg);
+
+			pthread_mutex_lock(&pool->lock);
+			pool->pending -= 1;
+			pthread_cond_broadcast(&pool->idle);
+			pthread_mutex_unlock(&pool->lock);
+			continue;
+		}
+
+		pthread_mutex_lock(&pool->lock);
+
+		while (pool->queued == 0 && !pool->stop) {
+			pthread_cond_wait(&pool->wake, &pool->lock);
+		}
+
+		if (pool->queued == 0 && pool->stop) {
+			pthread_mutex_unlock(&pool->lock);
+			break;
+		}
+
+		pthread_mutex_unlock(&pool->lock);
+	}
+
+	return NULL;
+}
+
+/**
+ * Create pool of nworkers threads. At most max tasks may
+ * be pending at once, past that pool_submit will block.
+ */
+pool_t *pool_new (int nworkers, int max) {
+	int index;
+	pool_t *pool;
+	pool_worker_t *worker;
+
+	NEW0(pool);
+	pool->nworkers = (nworkers < 1) ? 1 : nworkers;
+	pool->max = (max < 1) ? 1 : max;
+	pool->workers = CALLOC(pool->nworkers, (long) sizeof(pool_worker_t));
+	pthread_mutex_init(&pool->lock, NULL);
+	pthread_cond_init(&pool->wake, NULL);
+	pthread_cond_init(&pool->idle, NULL);
+
+	for (index = 0; index < pool->nworkers; index += 1) {
+		worker = &pool->workers[index];
+		worker->pool = pool;
+		worker->id = index;
+		worker->seed = (unsigned int) index + 1;
+		worker->deque.cap = POOL_DEQUE_SIZE;
+		worker->deque.tasks = CALLOC(POOL_DEQUE_SIZE, (long) sizeof(pool_task_t));
+		pthread_mutex_init(&worker->deque.lock, NULL);
+	}
+
+	/**
+	 * Workers that failed to start have their deques
+	 * emptied by the others, so make do with fewer.
+	 */
+	for (index = 0; index < pool->nworkers; index += 1) {
+		if (pthread_create(&pool->workers[index].thread, NULL, pool_worker, &pool->workers[index]) != 0) {
+			break;
+		}
+
+		pool->started += 1;
+	}
+
+	if (pool->started == 0) {
+		pool_free(pool);
+		return NULL;
+	}
+
+	return pool;
+}
+
+/**
+ * Queue task, to run fn(arg) on one of the workers.
+ */
+void pool_submit (pool_t *pool, pool_fn_t fn, void *arg) {
+	pthread_mutex_lock(&pool->lock);
+
+	while (pool->pending >= pool->max) {
+		pthread_cond_wait(&pool->idle, &pool->lock);
+	}
+
+	pool->pending += 1;
+	pool->next = (pool->next + 1) % pool->nworkers;
+	deque_push(&pool->workers[pool->next].deque, fn, arg);
+	pool->queued += 1;
+	pthread_cond_signal(&pool->wake);
+
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Block until every submitted task has run.
+ */
+void pool_wait (pool_t *pool) {
+	pthread_mutex_lock(&pool->lock);
+
+	while (pool->pending > 0) {
+		pthread_cond_wait(&pool->idle, &pool->lock);
+	}
+
+	pthread_mutex_unlock(&pool->lock);
+}
+
+/**
+ * Run remaining tasks, then stop and release pool.
+ */
+void pool_free (pool_t *pool) {
+	int index;
+
+	if (is_null(pool)) {
+		return;
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	pool->stop = 1;
+	pthread_cond_broadcast(&pool->wake);
+	pthread_mutex_unlock(&pool->lock);
+
+	for (index = 0; index < pool->started; index += 1) {
+		pthread_join(pool->workers[index].thread, NULL);
+	}
+
+	for (index = 0; index < pool->nworkers; index += 1) {
+		pthread_mutex_destroy(&pool->workers[index].deque.lock);
+		FREE(pool->workers[index].deque.tasks);
+	}
+
+	pthread_cond_destroy(&pool->idle);
+	pthread_cond_destroy(&pool->wake);
+	pthread_mutex_destroy(&pool->lock);
+	FREE(pool->workers);
+	FREE(pool);
+}
@@ -0,0 +1,870 @@
+/**
+ * probe.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "probe.h"
+
+static void probe_event(ev_watch_t *, int);
+static void probe_resolved6(void *, int, const resolve_result_t *);
+static void probe_resolved4(void *, int, const resolve_result_t *);
+static void probe_cancel(probe_t *);
+static void attempt_close(attempt_t *, attempt_status_t);
+
+static const char *probe_errors[NUM_PROBE_ERRORS] = {
+	"ok",
+	"resolve",
+	"connect",
+	"attach",
+	"handshake",
+	"connect_timeout",
+	"handshake_timeout",
+	"deadline",
+};
+
+/**
+ * Notify owner of progress, if anyone is listening.
+ */
+static void probe_note (probe_t *probe, int note) {
+	if (!is_null(probe->notify)) {
+		probe->notify(probe, note);
+	}
+}
+
+/**
+ * Arm timer to fire after timeout milliseconds.
+ * A timeout of zero means no limit.
+ */
+static void probe_arm (probe_t *probe, ev_timer_t *timer, int timeout) {
+	ev_timer_stop(probe->loop, timer);
+
+	if (timeout > 0) {
+		ev_timer_start(probe->loop, timer, (uint64_t) timeout * NSEC_PER_MSEC);
+	}
+}
+
+/**
+ * Mark probe as finished and hand it back to its owner.
+ * The owner is free to release the probe at this point.
+ */
+static void probe_finish (probe_t *probe, probe_error_t error) {
+	int index;
+
+	/**
+	 * Close out the phase in progress, so failures
+	 * still report how long was spent before giving up.
+	 */
+	for (index = 0; index < NUM_PHASES; index += 1) {
+		if (probe->timing.begin[index] && !probe->timing.end[index]) {
+			timing_end(&probe->timing, index);
+		}
+	}
+
+	if (!is_error(probe->watch.slot, NOT_FOUND)) {
+		ev_del(probe->loop, &probe->watch);
+	}
+
+	/**
+	 * A probe may finish on a timeout with lookups
+	 * and attempts still outstanding, stop them all.
+	 */
+	probe_cancel(probe);
+
+	for (index = 0; index < probe->nattempts; index += 1) {
+		attempt_close(&probe->attempts[index], ATTEMPT_CANCELLED);
+	}
+
+	ev_timer_stop(probe->loop, &probe->timer);
+	ev_timer_stop(probe->loop, &probe->expiry);
+	ev_timer_stop(probe->loop, &probe->overdue);
+
+	probe->error = error;
+	probe->state = (error == PROBE_OK) ? PROBE_DONE : PROBE_FAILED;
+	probe_note(probe, PROBE_NOTE_COMPLETE);
+}
+
+/**
+ * Read from the session until the server's TLS 1.3
+ * session ticket has been processed, which happens
+ * only after the handshake itself has completed.
+ */
+static void probe_ticket (probe_t *probe) {
+	int status, error;
+	char buf[1];
+	mem_arena_t *previous;
+
+	previous = Mem_arena_enter(probe->arena);
+	ERR_clear_error();
+	status = SSL_read(probe->ssl, buf, sizeof(buf));
+	error = (status > 0) ? SSL_ERROR_NONE : SSL_get_error(probe->ssl, status);
+	Mem_arena_leave(previous);
+
+	if (!is_null(probe->ticket) || status > 0) {
+		probe_finish(probe, PROBE_OK);
+		return;
+	}
+
+	switch (error) {
+		case SSL_ERROR_WANT_READ:
+			ev_mod(probe->loop, &probe->watch, EV_READ);
+			break;
+		case SSL_ERROR_WANT_WRITE:
+			ev_mod(probe->loop, &probe->watch, EV_WRITE);
+			break;
+		default:
+			/**
+			 * The handshake succeeded, the server
+			 * just didn't hand out a ticket.
+			 */
+			ERR_clear_error();
+			probe_finish(probe, PROBE_OK);
+			break;
+	}
+}
+
+/**
+ * Read version and cipher suite from a ServerHello
+ * message. TLS 1.3 (and a HelloRetryRequest) puts
+ * the version in the supported_versions extension,
+ * the legacy version field is that of TLS 1.2.
+ */
+static void probe_parse_hello (hello_t *hello, const unsigned char *msg, size_t len) {
+	size_t offset, end, extlen;
+	int type;
+
+	/**
+	 * Type (1), length (3), version (2), random (32).
+	 */
+	if (len < 39) {
+		return;
+	}
+
+	offset = 38 + 1 + msg[38];
+
+	if (offset + 3 > len) {
+		return;
+	}
+
+	hello->version = (msg[4] << 8) | msg[5];
+	hello->cipher = (msg[offset] << 8) | msg[offset + 1];
+	offset += 3;
+
+	if (offset + 2 > len) {
+		return;
+	}
+
+	end = offset + 2 + (size_t) ((msg[offset] << 8) | msg[offset + 1]);
+	offset += 2;
+
+	while (offset + 4 <= end && end <= len) {
+		type = (msg[offset] << 8) | msg[offset + 1];
+		extlen = (size_t) ((msg[offset + 2] << 8) | msg[offset + 3]);
+		offset += 4;
+
+		if (type == TLSEXT_TYPE_supported_versions && extlen == 2 && offset + 2 <= end) {
+			hello->version = (msg[offset] << 8) | msg[offset + 1];
+		}
+
+		offset += extlen;
+	}
+}
+
+/**
+ * Message callback, catches the ServerHello when
+ * the probe is only after what the server picks.
+ */
+static void probe_hello (int write_p, int version, int content_type, const void *buf, size_t len, SSL *ssl, void *arg) {
+	probe_t *probe = arg;
+	const unsigned char *msg = buf;
+
+	if (write_p || content_type != SSL3_RT_HANDSHAKE || len < 1 || msg[0] != SSL3_MT_SERVER_HELLO) {
+		return;
+	}
+
+	if (probe->hello.version == 0) {
+		probe_parse_hello(&probe->hello, msg, len);
+	}
+}
+
+/**
+ * Advance the handshake as far as the socket allows.
+ * OpenSSL allocates from the probe's arena meanwhile,
+ * which is left before the probe can be finished (and
+ * the arena released along with it).
+ */
+static void probe_handshake (probe_t *probe) {
+	int status, error;
+	mem_arena_t *previous;
+
+	previous = Mem_arena_enter(probe->arena);
+	ERR_clear_error();
+	status = SSL_connect(probe->ssl);
+	error = (status == 1) ? SSL_ERROR_NONE : SSL_get_error(probe->ssl, status);
+	Mem_arena_leave(previous);
+
+	/**
+	 * Go no further than the ServerHello (or the server's
+	 * chain), if that's all that was wanted. The rest of
+	 * the handshake (and any alert over the version, or
+	 * the chain we refused) makes no difference.
+	 */
+	if ((probe->hello_only && probe->hello.version) || probe->captured) {
+		ERR_clear_error();
+		probe_finish(probe, PROBE_OK);
+		return;
+	}
+
+	if (status == 1) {
+		timing_end(&probe->timing, PHASE_HANDSHAKE);
+
+		if (probe->resume && is_null(probe->ticket) && SSL_version(probe->ssl) >= TLS1_3_VERSION) {
+			probe->state = PROBE_TICKET;
+			probe_arm(probe, &probe->expiry, TICKET_TIMEOUT);
+			probe_ticket(probe);
+			return;
+		}
+
+		probe_finish(probe, PROBE_OK);
+		return;
+	}
+
+	switch (error) {
+		case SSL_ERROR_WANT_READ:
+			ev_mod(probe->loop, &probe->watch, EV_READ);
+			break;
+		case SSL_ERROR_WANT_WRITE:
+			ev_mod(probe->loop, &probe->watch, EV_WRITE);
+			break;
+		default:
+			probe_finish(probe, PROBE_ERR_HANDSHAKE);
+			break;
+	}
+}
+
+/**
+ * Connection established, attach SSL session
+ * to the socket and initiate the handshake.
+ */
+static void probe_attach (probe_t *probe) {
+	int attached = 0;
+	mem_arena_t *previous;
+
+	timing_end(&probe->timing, PHASE_CONNECT);
+	probe->state = PROBE_HANDSHAKE;
+	probe_note(probe, PROBE_NOTE_CONNECTED);
+	timing_begin(&probe->timing, PHASE_HANDSHAKE);
+	probe_arm(probe, &probe->expiry, probe->handshake_timeout);
+
+	probe_note(probe, PROBE_NOTE_ATTACH);
+	previous = Mem_arena_enter(probe->arena);
+
+	/**
+	 * Establish connection, set state in client mode.
+	 */
+	probe->ssl = SSL_new(probe->ctx);
+
+	if (!is_null(probe->ssl)) {
+		SSL_set_connect_state(probe->ssl);
+		SSL_set_app_data(probe->ssl, probe);
+
+		/**
+		 * Offer session from the previous round, if any.
+		 */
+		if (!is_null(probe->session)) {
+			SSL_set_session(probe->ssl, probe->session);
+		}
+
+		/**
+		 * Disable SNI support if --no-sni was given.
+		 */
+		if (!probe->no_sni) {
+			SSL_set_tlsext_host_name(probe->ssl, probe->target.host);
+		}
+
+		/**
+		 * Offer only the given version and cipher
+		 * suites, when enumerating what's accepted.
+		 */
+		if (probe->version) {
+			SSL_set_min_proto_version(probe->ssl, probe->version);
+			SSL_set_max_proto_version(probe->ssl, probe->version);
+		}
+
+		if (!is_null((void *) probe->ciphers)) {
+			if (probe->version == TLS1_3_VERSION) {
+				SSL_set_ciphersuites(probe->ssl, probe->ciphers);
+			} else {
+				SSL_set_cipher_list(probe->ssl, probe->ciphers);
+			}
+		}
+
+		if (probe->hello_only) {
+			SSL_set_msg_callback(probe->ssl, probe_hello);
+			SSL_set_msg_callback_arg(probe->ssl, probe);
+		}
+
+		/**
+		 * Have the chain refused once it's been received
+		 * (see probe_certificate), if that's all we need.
+		 */
+		if (probe->cert_only) {
+			SSL_set_verify(probe->ssl, SSL_VERIFY_PEER, NULL);
+		}
+
+		attached = (SSL_set_fd(probe->ssl, probe->fd) == 1);
+	}
+
+	Mem_arena_leave(previous);
+
+	if (!attached) {
+		probe_finish(probe, PROBE_ERR_ATTACH);
+		return;
+	}
+
+	probe_note(probe, PROBE_NOTE_HANDSHAKE);
+	probe_handshake(probe);
+}
+
+/**
+ * Readiness callback for the probe socket.
+ */
+static void probe_event (ev_watch_t *watch, int events) {
+	probe_t *probe = watch->arg;
+
+	switch (probe->state) {
+		case PROBE_HANDSHAKE:
+			probe_handshake(probe);
+			break;
+		case PROBE_TICKET:
+			probe_ticket(probe);
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * Close attempt socket, and record how it ended.
+ */
+static void attempt_close (attempt_t *attempt, attempt_status_t status) {
+	probe_t *probe = attempt->probe;
+
+	if (!is_error(attempt->watch.slot, NOT_FOUND)) {
+		ev_del(probe->loop, &attempt->watch);
+	}
+
+	if (!is_error(attempt->fd, -1)) {
+		close(attempt->fd);
+		attempt->fd = -1;
+	}
+
+	if (attempt->status == ATTEMPT_PENDING) {
+		attempt->end = clock_now();
+		attempt->status = status;
+		probe->active -= 1;
+	}
+}
+
+/**
+ * Stop any lookups still outstanding for probe.
+ */
+static void probe_cancel (probe_t *probe) {
+	if (probe->lookups & (1 << FAMILY_INET6)) {
+		resolver_cancel(probe->resolver, probe->target.host, AF_INET6, probe_resolved6, probe);
+	}
+
+	if (probe->lookups & (1 << FAMILY_INET)) {
+		resolver_cancel(probe->resolver, probe->target.host, AF_INET, probe_resolved4, probe);
+	}
+
+	probe->lookups = 0;
+}
+
+/**
+ * Attempt connected first. Cancel the rest of the
+ * race, take over its socket and begin the handshake.
+ */
+static void probe_won (probe_t *probe, attempt_t *winner) {
+	int index;
+
+	winner->end = clock_now();
+	winner->status = ATTEMPT_CONNECTED;
+	probe->active -= 1;
+
+	ev_del(probe->loop, &winner->watch);
+	probe->fd = winner->fd;
+	winner->fd = -1;
+
+	for (index = 0; index < probe->nattempts; index += 1) {
+		attempt_close(&probe->attempts[index], ATTEMPT_CANCELLED);
+	}
+
+	ev_timer_stop(probe->loop, &probe->timer);
+	probe_cancel(probe);
+	copy(probe->addr, winner->name);
+
+	probe->watch.fd = probe->fd;
+
+	if (is_error(ev_add(probe->loop, &probe->watch, EV_WRITE), -1)) {
+		probe_finish(probe, PROBE_ERR_CONNECT);
+		return;
+	}
+
+	probe_attach(probe);
+}
+
+static void probe_advance(probe_t *);
+
+/**
+ * Readiness callback for an attempt socket.
+ */
+static void attempt_event (ev_watch_t *watch, int events) {
+	attempt_t *attempt = watch->arg;
+	probe_t *probe = attempt->probe;
+
+	attempt->error = sock_error(attempt->fd);
+
+	if (attempt->error == 0) {
+		probe_won(probe, attempt);
+		return;
+	}
+
+	/**
+	 * Don't wait out the attempt delay
+	 * when we already know this one failed.
+	 */
+	attempt_close(attempt, ATTEMPT_FAILED);
+	probe_advance(probe);
+}
+
+/**
+ * Pick the next address to try, alternating
+ * between families, starting with IPv6.
+ */
+static resolve_addr_t *probe_candidate (probe_t *probe) {
+	int index, family;
+
+	for (index = 1; index <= NUM_FAMILIES; index += 1) {
+		family = (probe->family + index) % NUM_FAMILIES;
+
+		if (probe->cursor[family] < probe->naddrs[family]) {
+			probe->family = family;
+			return &probe->addrs[family][probe->cursor[family]++];
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Initiate connection attempt to addr. Returns 0 if the
+ * connection is in progress, or -1 if it failed outright.
+ */
+static int probe_attempt (probe_t *probe, const resolve_addr_t *addr) {
+	attempt_t *attempt;
+	struct sockaddr_storage ss;
+	socklen_t sslen;
+
+	attempt = &probe->attempts[probe->nattempts++];
+	attempt->addr = *addr;
+	attempt->fd = -1;
+	attempt->error = 0;
+	attempt->status = ATTEMPT_FAILED;
+	attempt->probe = probe;
+	attempt->begin = clock_now();
+	attempt->end = attempt->begin;
+	attempt->name[0] = '\0';
+	ev_set(&attempt->watch, -1, attempt_event, attempt);
+
+	if (is_error(resolve_sockaddr(addr, probe->target.port, &ss, &sslen), -1)) {
+		attempt->error = EAFNOSUPPORT;
+		return -1;
+	}
+
+	sock_ntop((struct sockaddr *) &ss, attempt->name, sizeof(attempt->name));
+	copy(probe->addr, attempt->name);
+	attempt->fd = sock_connect((struct sockaddr *) &ss, sslen);
+
+	if (is_error(attempt->fd, -1)) {
+		attempt->error = errno;
+		return -1;
+	}
+
+	attempt->watch.fd = attempt->fd;
+
+	if (is_error(ev_add(probe->loop, &attempt->watch, EV_WRITE), -1)) {
+		attempt->error = errno;
+		close(attempt->fd);
+		attempt->fd = -1;
+		return -1;
+	}
+
+	attempt->status = ATTEMPT_PENDING;
+	probe->active += 1;
+
+	return 0;
+}
+
+/**
+ * Start the next connection attempt, if any address is left,
+ * and arm the attempt delay. Fail the probe once there is no
+ * attempt in flight, no address left and no lookup pending.
+ */
+static void probe_advance (probe_t *probe) {
+	int family = probe->family;
+	resolve_addr_t *addr;
+
+	if (probe->state == PROBE_HELD) {
+		return;
+	}
+
+	while (!is_null(addr = probe_candidate(probe))) {
+		if (probe->state == PROBE_RESOLVE) {
+			if (!probe->admitted) {
+				timing_end(&probe->timing, PHASE_RESOLVE);
+				probe->admitted = 1;
+
+				/**
+				 * Owner may hold the probe back before it
+				 * connects anywhere, leaving the address
+				 * to be tried first once it's resumed. The
+				 * deadline doesn't run while it's held.
+				 */
+				if (!is_null((void *) probe->admit) && !probe->admit(probe, addr)) {
+					probe->cursor[probe->family] -= 1;
+					probe->family = family;
+					probe->state = PROBE_HELD;
+					probe->held = clock_now();
+					ev_timer_stop(probe->loop, &probe->overdue);
+					return;
+				}
+			}
+
+			timing_begin(&probe->timing, PHASE_CONNECT);
+			probe->state = PROBE_CONNECT;
+			probe_arm(probe, &probe->expiry, probe->connect_timeout);
+		}
+
+		if (!is_error(probe_attempt(probe, addr), -1)) {
+			ev_timer_start(
+				probe->loop,
+				&probe->timer,
+				(uint64_t) CONNECT_ATTEMPT_DELAY * NSEC_PER_MSEC
+			);
+			return;
+		}
+	}
+
+	if (probe->active == 0 && probe->lookups == 0) {
+		probe_finish(
+			probe,
+			probe->nattempts ? PROBE_ERR_CONNECT : PROBE_ERR_RESOLVE
+		);
+	}
+}
+
+/**
+ * Attempt delay (or resolution delay) elapsed
+ * without a winner, so bring in the next address.
+ */
+static void probe_timeout (ev_timer_t *timer) {
+	probe_advance(timer->arg);
+}
+
+/**
+ * Connect or handshake phase ran over its timeout,
+ * or we've waited long enough for a session ticket.
+ */
+static void probe_expired (ev_timer_t *timer) {
+	probe_t *probe = timer->arg;
+
+	switch (probe->state) {
+		case PROBE_TICKET:
+			probe_finish(probe, PROBE_OK);
+			break;
+		case PROBE_HANDSHAKE:
+			probe_finish(probe, PROBE_ERR_HANDSHAKE_TIMEOUT);
+			break;
+		default:
+			probe_finish(probe, PROBE_ERR_CONNECT_TIMEOUT);
+			break;
+	}
+}
+
+/**
+ * Probe ran over its overall deadline.
+ */
+static void probe_overdue (ev_timer_t *timer) {
+	probe_finish(timer->arg, PROBE_ERR_DEADLINE);
+}
+
+/**
+ * Record addresses from a lookup, and decide whether
+ * to start connecting. Per RFC 8305, if the A answer
+ * arrives before AAAA, wait briefly for the latter.
+ */
+static void probe_resolved (probe_t *probe, int family, int status, const resolve_result_t *result) {
+	int index;
+
+	probe->lookups &= ~(1 << family);
+
+	if (status == RESOLVE_OK) {
+		for (index = 0; index < result->count; index += 1) {
+			if (probe->naddrs[family] < RESOLVE_MAX_ADDRS) {
+				probe->addrs[family][probe->naddrs[family]++] = result->addrs[index];
+			}
+		}
+	}
+
+	if (probe->state == PROBE_RESOLVE
+	    && family == FAMILY_INET
+	    && probe->naddrs[FAMILY_INET] > 0
+	    && (probe->lookups & (1 << FAMILY_INET6))) {
+		ev_timer_start(
+			probe->loop,
+			&probe->timer,
+			(uint64_t) RESOLUTION_DELAY * NSEC_PER_MSEC
+		);
+		return;
+	}
+
+	/**
+	 * Late answers join the race when it's next
+	 * someone's turn, i.e. when the delay expires,
+	 * unless every attempt so far has already failed.
+	 */
+	if (probe->state == PROBE_CONNECT && probe->active > 0 && ev_timer_active(&probe->timer)) {
+		return;
+	}
+
+	ev_timer_stop(probe->loop, &probe->timer);
+	probe_advance(probe);
+}
+
+static void probe_resolved6 (void *arg, int status, const resolve_result_t *result) {
+	probe_resolved(arg, FAMILY_INET6, status, result);
+}
+
+static void probe_resolved4 (void *arg, int status, const resolve_result_t *result) {
+	probe_resolved(arg, FAMILY_INET, status, result);
+}
+
+/**
+ * Create new probe for target.
+ */
+probe_t *probe_new (const target_t *target, SSL_CTX *ctx, ev_loop_t *loop, resolver_t *resolver) {
+	probe_t *probe;
+
+	NEW0(probe);
+	probe->target = *target;
+	probe->state = PROBE_INIT;
+	probe->fd = -1;
+	probe->ctx = ctx;
+	probe->arena = Mem_arena_new();
+	probe->loop = loop;
+	probe->resolver = resolver;
+	probe->family = FAMILY_INET;
+	ev_set(&probe->watch, -1, probe_event, probe);
+	ev_timer_set(&probe->timer, probe_timeout, probe);
+	ev_timer_set(&probe->expiry, probe_expired, probe);
+	ev_timer_set(&probe->overdue, probe_overdue, probe);
+
+	return probe;
+}
+
+/**
+ * Resolve target (AAAA and A in parallel) and race connections
+ * to its addresses, unless it's pinned to one. The probe may
+ * complete (and be released by its owner) before return.
+ */
+void probe_start (probe_t *probe) {
+	int family;
+
+	timing_init(&probe->timing);
+	probe_note(probe, PROBE_NOTE_CONNECT);
+	timing_begin(&probe->timing, PHASE_RESOLVE);
+
+	probe->state = PROBE_RESOLVE;
+	probe_arm(probe, &probe->overdue, probe->deadline);
+
+	/**
+	 * Address was given up front (with --connect),
+	 * so there's nothing to look up, or race.
+	 */
+	if (!is_null((void *) probe->pinned)) {
+		family = (probe->pinned->family == AF_INET6) ? FAMILY_INET6 : FAMILY_INET;
+		probe->addrs[family][0] = *probe->pinned;
+		probe->naddrs[family] = 1;
+		probe_advance(probe);
+		return;
+	}
+
+	probe->lookups = (1 << FAMILY_INET6) | (1 << FAMILY_INET);
+
+	/**
+	 * The A lookup is still outstanding while the AAAA
+	 * lookup calls back, so the probe can't finish here.
+	 */
+	resolver_lookup(probe->resolver, probe->target.host, AF_INET6, probe_resolved6, probe);
+	resolver_lookup(probe->resolver, probe->target.host, AF_INET, probe_resolved4, probe);
+}
+
+/**
+ * Carry on with probe held back by its owner. Time
+ * spent held isn't the target's doing, so the clock
+ * is moved on past it, and the deadline is re-armed
+ * with what's left of it. A probe that's been resumed
+ * has no hold time left. The probe may complete (and
+ * be released by its owner) before return.
+ */
+void probe_resume (probe_t *probe) {
+	uint64_t held, spent, budget;
+
+	if (probe->state != PROBE_HELD) {
+		return;
+	}
+
+	held = clock_now() - probe->held;
+	probe->timing.start += held;
+	probe->timing.begin[PHASE_RESOLVE] += held;
+	probe->timing.end[PHASE_RESOLVE] += held;
+	probe->held = 0;
+	probe->state = PROBE_RESOLVE;
+
+	if (probe->deadline > 0) {
+		spent = clock_now() - probe->timing.start;
+		budget = (uint64_t) probe->deadline * NSEC_PER_MSEC;
+		ev_timer_start(probe->loop, &probe->overdue, (spent < budget) ? (budget - spent) : 0);
+	}
+
+	probe_note(probe, PROBE_NOTE_RESUME);
+	probe_advance(probe);
+}
+
+/**
+ * Release probe, its SSL session and sockets.
+ */
+void probe_free (probe_t *probe) {
+	int index;
+
+	if (is_null(probe)) {
+		return;
+	}
+
+	probe_cancel(probe);
+	ev_timer_stop(probe->loop, &probe->timer);
+	ev_timer_stop(probe->loop, &probe->expiry);
+	ev_timer_stop(probe->loop, &probe->overdue);
+
+	for (index = 0; index < probe->nattempts; index += 1) {
+		attempt_close(&probe->attempts[index], ATTEMPT_CANCELLED);
+	}
+
+	if (!is_error(probe->watch.slot, NOT_FOUND)) {
+		ev_del(probe->loop, &probe->watch);
+	}
+
+	/**
+	 * Close the session cleanly, otherwise OpenSSL
+	 * marks it as not resumable when it is freed.
+	 */
+	if (probe->state == PROBE_DONE && SSL_is_init_finished(probe->ssl)) {
+		SSL_shutdown(probe->ssl);
+	}
+
+	SSL_free(probe->ssl);
+	SSL_SESSION_free(probe->session);
+	SSL_SESSION_free(probe->ticket);
+	sk_X509_pop_free(probe->received, X509_free);
+
+	if (!is_error(probe->fd, -1)) {
+		close(probe->fd);
+	}
+
+	Mem_arena_free(probe->arena);
+	FREE(probe);
+}
+
+/**
+ * New session callback for the shared SSL context. Holds
+ * on to the latest session (or TLS 1.3 ticket) issued to
+ * the probe, so it can be offered on the next round.
+ */
+int probe_session (SSL *ssl, SSL_SESSION *session) {
+	probe_t *probe = SSL_get_app_data(ssl);
+
+	if (is_null(probe)) {
+		return 0;
+	}
+
+	SSL_SESSION_free(probe->ticket);
+	probe->ticket = session;
+
+	return 1;
+}
+
+/**
+ * Certificate verification callback for the shared SSL
+ * context, under --cert-only. It's called as soon as the
+ * server's chain has been received (and kept with the
+ * session), so failing verification cuts the handshake
+ * short, before any key exchange on our part. Probes
+ * that aren't after the chain alone are let through.
+ */
+int probe_certificate (X509_STORE_CTX *store, void *arg) {
+	SSL *ssl;
+	probe_t *probe;
+
+	ssl = X509_STORE_CTX_get_ex_data(store, SSL_get_ex_data_X509_STORE_CTX_idx());
+	probe = is_null(ssl) ? NULL : SSL_get_app_data(ssl);
+
+	if (is_null(probe) || !probe->cert_only) {
+		return 1;
+	}
+
+	/**
+	 * Keep the chain as received, since a session whose
+	 * verification failed may not (e.g. under 1.1.1).
+	 */
+	if (is_null(probe->received)) {
+		probe->received = X509_chain_up_ref(X509_STORE_CTX_get0_untrusted(store));
+	}
+
+	probe->captured = 1;
+	X509_STORE_CTX_set_error(store, X509_V_ERR_APPLICATION_VERIFICATION);
+
+	return 0;
+}
+
+/**
+ * Cipher suite of the session, or the one picked in the
+ * ServerHello, if the handshake was cut short after it.
+ */
+const SSL_CIPHER *probe_cipher (const SSL *ssl) {
+	const SSL_CIPHER *cipher = SSL_get_current_cipher(ssl);
+
+	return is_null((void *) cipher) ? SSL_get_pending_cipher(ssl) : cipher;
+}
+
+/**
+ * Peer chain of the session, or the one kept by
+ * probe_certificate, if it was cut short after it.
+ */
+STACK_OF(X509) *probe_chain (const SSL *ssl) {
+	probe_t *probe = SSL_get_app_data(ssl);
+
+	if (!is_null(probe) && !is_null(probe->received)) {
+		return probe->received;
+	}
+
+	return SSL_get_peer_cert_chain(ssl);
+}
+
+/**
+ * Short, stable name of a probe error, as
+ * used in machine-readable output.
+ */
+const char *probe_error_name (probe_error_t error) {
+	return probe_errors[error];
+}
@@ -0,0 +1,665 @@
+/**
+ * record.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "record.h"
+
+/**
+ * Bounds-checked reader over the body of a record.
+ * Reading past the end yields zeros and flags it.
+ */
+typedef struct {
+	const unsigned char *data;
+	size_t len;
+	size_t pos;
+	int overrun;
+} record_reader_t;
+
+static void record_u8 (buf_t *buf, unsigned int value) {
+	unsigned char byte = (unsigned char) value;
+
+	buf_append(buf, (const char *) &byte, 1);
+}
+
+static void record_u16 (buf_t *buf, unsigned int value) {
+	uint16_t word = htons((uint16_t) value);
+
+	buf_append(buf, (const char *) &word, sizeof(word));
+}
+
+static void record_u32 (buf_t *buf, uint32_t value) {
+	uint32_t word = htonl(value);
+
+	buf_append(buf, (const char *) &word, sizeof(word));
+}
+
+/**
+ * Start a record of type, returning the offset of its
+ * length, which is filled in once the body is written.
+ */
+static size_t record_begin (buf_t *buf, int type) {
+	size_t offset = buf->len;
+
+	record_u32(buf, 0);
+	record_u8(buf, (unsigned int) type);
+
+	return offset;
+}
+
+static void record_end (buf_t *buf, size_t offset) {
+	uint32_t word = htonl((uint32_t) (buf->len - offset - sizeof(word)));
+
+	memcpy(buf->data + offset, &word, sizeof(word));
+}
+
+/**
+ * Microseconds from start to instant, or
+ * RECORD_UNSET if the instant was never reached.
+ */
+static uint32_t record_offset (uint64_t start, uint64_t instant) {
+	if (!instant || instant < start) {
+		return RECORD_UNSET;
+	}
+
+	return (uint32_t) ((instant - start) / NSEC_PER_USEC);
+}
+
+/**
+ * Slot digest is stored in, or the empty
+ * slot it would go in. Digests are uniformly
+ * distributed already, so they hash themselves.
+ */
+static record_slot_t *record_slot (record_certs_t *certs, const unsigned char *digest) {
+	size_t index;
+	uint64_t hash;
+	record_slot_t *slot;
+
+	memcpy(&hash, digest, sizeof(hash));
+	index = (size_t) hash & (certs->size - 1);
+
+	while (1) {
+		slot = &certs->slots[index];
+
+		if (!slot->used || !memcmp(slot->digest, digest, SHA256_DIGEST_LENGTH)) {
+			return slot;
+		}
+
+		index = (index + 1) & (certs->size - 1);
+	}
+}
+
+/**
+ * Double the table once it is half full.
+ */
+static void record_grow (record_certs_t *certs) {
+	size_t index, size;
+	record_slot_t *slots;
+
+	if ((size_t) certs->count * 2 < certs->size) {
+		return;
+	}
+
+	slots = certs->slots;
+	size = certs->size;
+	certs->size = size * 2;
+	certs->slots = CALLOC((long) certs->size, (long) sizeof(record_slot_t));
+
+	for (index = 0; index < size; index += 1) {
+		if (slots[index].used) {
+			*record_slot(certs, slots[index].digest) = slots[index];
+		}
+	}
+
+	FREE(slots);
+}
+
+/**
+ * Write cert record with the DER encoding of crt.
+ */
+static void record_cert (buf_t *buf, uint32_t index, X509 *crt) {
+	int len;
+	size_t offset;
+	unsigned char *der = NULL;
+
+	len = i2d_X509(crt, &der);
+
+	if (len < 0) {
+		return;
+	}
+
+	offset = record_begin(buf, RECORD_CERT);
+	record_u32(buf, index);
+	buf_append(buf, (const char *) der, (size_t) len);
+	record_end(buf, offset);
+
+	OPENSSL_free(der);
+}
+
+record_certs_t *record_certs_new (void) {
+	record_certs_t *certs;
+
+	NEW0(certs);
+	certs->size = RECORD_CERTS_SIZE;
+	certs->slots = CALLOC((long) certs->size, (long) sizeof(record_slot_t));
+
+	return certs;
+}
+
+void record_certs_free (record_certs_t *certs) {
+	if (is_null(certs)) {
+		return;
+	}
+
+	FREE(certs->slots);
+	FREE(certs);
+}
+
+void record_header (buf_t *buf) {
+	buf_append(buf, RECORD_MAGIC, RECORD_MAGIC_LENGTH);
+}
+
+/**
+ * Append record of a finished probe to buf, preceded
+ * by cert records for certificates not written before.
+ * The caller must serialize calls sharing certs, and
+ * write buf out before the next call, so cert records
+ * always come ahead of the first reference to them.
+ */
+void record_probe (buf_t *buf, record_certs_t *certs, const probe_t *probe, int round) {
+	int index, count, family;
+	size_t offset, namelen;
+	uint32_t indices[RECORD_MAX_CHAIN];
+	unsigned char addr[16];
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	STACK_OF(X509) *chain = NULL;
+	const SSL_CIPHER *cipher = NULL;
+	record_slot_t *slot;
+	X509 *crt;
+
+	count = 0;
+	family = 0;
+	memset(addr, 0, sizeof(addr));
+
+	if (probe->state == PROBE_DONE) {
+		chain = probe_chain(probe->ssl);
+		cipher = probe_cipher(probe->ssl);
+	}
+
+	for (index = 0; !is_null(chain) && index < sk_X509_num(chain) && count < RECORD_MAX_CHAIN; index += 1) {
+		crt = sk_X509_value(chain, index);
+
+		if (is_error(cert_digest(crt, digest, NULL), -1)) {
+			continue;
+		}
+
+		record_grow(certs);
+		slot = record_slot(certs, digest);
+
+		if (!slot->used) {
+			memcpy(slot->digest, digest, SHA256_DIGEST_LENGTH);
+			slot->index = certs->count;
+			slot->used = 1;
+			certs->count += 1;
+			record_cert(buf, slot->index, crt);
+		}
+
+		indices[count++] = slot->index;
+	}
+
+	if (inet_pton(AF_INET6, probe->addr, addr) == 1) {
+		family = 6;
+	} else if (inet_pton(AF_INET, probe->addr, addr) == 1) {
+		family = 4;
+	}
+
+	offset = record_begin(buf, RECORD_PROBE);
+	record_u8(buf, (unsigned int) probe->error);
+	record_u8(buf, (probe->state == PROBE_DONE) && SSL_session_reused(probe->ssl));
+	record_u16(buf, (round < 0) ? RECORD_NO_ROUND : (unsigned int) round);
+	record_u16(buf, (probe->state == PROBE_DONE) ? (unsigned int) SSL_version(probe->ssl) : 0);
+	record_u16(buf, is_null((void *) cipher) ? 0 : SSL_CIPHER_get_protocol_id(cipher));
+	record_u8(buf, (unsigned int) family);
+	buf_append(buf, (const char *) addr, sizeof(addr));
+
+	for (index = 0; index < NUM_PHASES; index += 1) {
+		record_u32(buf, record_offset(probe->timing.start, probe->timing.begin[index]));
+		record_u32(buf, record_offset(probe->timing.start, probe->timing.end[index]));
+	}
+
+	namelen = strlen(probe->target.name);
+	record_u16(buf, (unsigned int) namelen);
+	buf_append(buf, probe->target.name, namelen);
+	record_u8(buf, (unsigned int) count);
+
+	for (index = 0; index < count; index += 1) {
+		record_u32(buf, indices[index]);
+	}
+
+	record_end(buf, offset);
+}
+
+static unsigned int record_get_u8 (record_reader_t *reader) {
+	if (reader->pos + 1 > reader->len) {
+		reader->overrun = 1;
+		return 0;
+	}
+
+	return reader->data[reader->pos++];
+}
+
+static unsigned int record_get_u16 (record_reader_t *reader) {
+	unsigned int value;
+
+	value = record_get_u8(reader) << 8;
+	value |= record_get_u8(reader);
+
+	return value;
+}
+
+static uint32_t record_get_u32 (record_reader_t *reader) {
+	uint32_t value;
+
+	value = (uint32_t) record_get_u16(reader) << 16;
+	value |= record_get_u16(reader);
+
+	return value;
+}
+
+static const unsigned char *record_get (record_reader_t *reader, size_t len) {
+	const unsigned char *data = reader->data + reader->pos;
+
+	if (reader->pos + len > reader->len) {
+		reader->overrun = 1;
+		return NULL;
+	}
+
+	reader->pos += len;
+
+	return data;
+}
+
+/**
+ * Read exactly len bytes from fp. Returns 1 if read,
+ * 0 on a clean end of stream, or -1 if truncated.
+ */
+static int record_read (FILE *fp, void *data, size_t len, int eof_ok) {
+	size_t count = fread(data, 1, len, fp);
+
+	if (count == len) {
+		return 1;
+	}
+
+	return (count == 0 && eof_ok) ? 0 : -1;
+}
+
+static const char *record_version_name (int version) {
+	method_t *method = get_method_from_version(version);
+
+	return is_null(method) ? "unknown" : method->name;
+}
+
+/**
+ * Decoding state: certificates read so far, by index,
+ * and what's needed to render probe records.
+ */
+typedef struct {
+	settings_t *settings;
+	BIO *bp;
+	BIO *scratch;
+	buf_t *out;
+	SSL_CTX *ctx;
+	SSL *ssl;
+	X509 **certs;
+	uint32_t ncerts;
+	uint32_t maxcerts;
+	long failed;
+} record_decoder_t;
+
+static int record_decode_cert (record_decoder_t *decoder, record_reader_t *reader) {
+	uint32_t index;
+	const unsigned char *der;
+	X509 *crt;
+
+	index = record_get_u32(reader);
+	der = reader->data + reader->pos;
+
+	if (reader->overrun || index != decoder->ncerts) {
+		return -1;
+	}
+
+	crt = d2i_X509(NULL, &der, (long) (reader->len - reader->pos));
+
+	if (is_null(crt)) {
+		return -1;
+	}
+
+	if (decoder->ncerts == decoder->maxcerts) {
+		decoder->maxcerts = decoder->maxcerts ? decoder->maxcerts * 2 : RECORD_CERTS_SIZE;
+
+		if (is_null(decoder->certs)) {
+			decoder->certs = ALLOC((long) decoder->maxcerts * (long) sizeof(X509 *));
+		} else {
+			RESIZE(decoder->certs, (long) decoder->maxcerts * (long) sizeof(X509 *));
+		}
+	}
+
+	decoder->certs[decoder->ncerts++] = crt;
+
+	return 0;
+}
+
+/**
+ * Render a probe record, the same way it would
+ * have been rendered by a live run in a batch.
+ * What isn't recorded (changes, connection
+ * attempts, memory) is left out, and every
+ * certificate is written out in full.
+ */
+static void record_render (record_decoder_t *decoder, report_t *report, timing_t *timing, int error) {
+	double elapsed;
+	char url[MAX_URL_LENGTH + 8];
+	settings_t *settings = decoder->settings;
+	BIO *bp = decoder->bp;
+
+	if (settings->format == FORMAT_NDJSON) {
+		report_json(decoder->out, decoder->scratch, report);
+		report_json_timing(decoder->out, timing);
+
+		if (decoder->out->len >= BUF_INITIAL_SIZE * 16) {
+			buf_write(decoder->out, STDOUT_FILENO);
+			buf_reset(decoder->out);
+		}
+
+		return;
+	}
+
+	elapsed = (double) timing_total(timing) / NSEC_PER_SEC;
+
+	BIO_printf(bp, "--- Host: %s\n", report->name);
+
+	if (error) {
+		report_outcome(bp, report, (probe_error_t) error, 0, settings->quiet, elapsed);
+	} else {
+		/**
+		 * Certificate details only go with the
+		 * first round, as they do when live.
+		 */
+		if (report->round <= 0) {
+			report_outcome(bp, report, PROBE_OK, settings->cert_only, settings->quiet, elapsed);
+
+			if (settings->address) {
+				BIO_printf(bp, "--- Address: %s\n", report->addr);
+			}
+
+			snprintf(url, sizeof(url), "https://%s", report->name);
+
+			if (is_error(report_text(bp, report, settings, url), -1)) {
+				decoder->failed += 1;
+			}
+		}
+
+		if (report->round == 0) {
+			BIO_printf(
+				bp,
+				"--- Session: full handshake %.3fms\n",
+				(double) timing_duration(timing, PHASE_HANDSHAKE) / NSEC_PER_MSEC
+			);
+		} else if (report->round > 0) {
+			BIO_printf(
+				bp,
+				"--- Session: %s %.3fms (%d)\n",
+				report->resumed ? "resumed handshake" : "full handshake, resumption declined,",
+				(double) timing_duration(timing, PHASE_HANDSHAKE) / NSEC_PER_MSEC,
+				report->round
+			);
+		}
+	}
+
+	if (settings->timing) {
+		report_timing(bp, timing);
+	}
+
+	if (!settings->quiet) {
+		BIO_printf(bp, "\n");
+	}
+}
+
+static int record_decode_probe (record_decoder_t *decoder, record_reader_t *reader) {
+	int index, error, version, cipher_id, family, count;
+	uint32_t begin, end, crt_index;
+	size_t namelen;
+	char name[MAX_URL_LENGTH];
+	char addr[MAX_ADDR_LENGTH];
+	char cipher_name[8];
+	unsigned char cipher_bytes[2];
+	const unsigned char *raw, *rawname;
+	const SSL_CIPHER *cipher;
+	target_t target;
+	timing_t timing;
+	report_t report;
+
+	memset(&report, 0, sizeof(report));
+	addr[0] = '\0';
+
+	error = (int) record_get_u8(reader);
+	report.resumed = (int) record_get_u8(reader);
+	report.round = (int) record_get_u16(reader);
+	version = (int) record_get_u16(reader);
+	cipher_id = (int) record_get_u16(reader);
+	family = (int) record_get_u8(reader);
+	raw = record_get(reader, 16);
+
+	/**
+	 * The start of the probe itself isn't recorded, any
+	 * nonzero instant will do to reconstruct its phases.
+	 */
+	timing.start = NSEC_PER_SEC;
+
+	for (index = 0; index < NUM_PHASES; index += 1) {
+		begin = record_get_u32(reader);
+		end = record_get_u32(reader);
+		timing.begin[index] = (begin == RECORD_UNSET) ? 0 : timing.start + (uint64_t) begin * NSEC_PER_USEC;
+		timing.end[index] = (end == RECORD_UNSET) ? 0 : timing.start + (uint64_t) end * NSEC_PER_USEC;
+	}
+
+	namelen = record_get_u16(reader);
+	rawname = record_get(reader, namelen);
+	count = (int) record_get_u8(reader);
+
+	if (reader->overrun || namelen >= sizeof(name) || error > PROBE_ERR_DEADLINE) {
+		return -1;
+	}
+
+	memcpy(name, rawname, namelen);
+	name[namelen] = '\0';
+
+	if (family) {
+		inet_ntop((family == 6) ? AF_INET6 : AF_INET, raw, addr, sizeof(addr));
+	}
+
+	/**
+	 * A name that doesn't parse is taken as the host,
+	 * provided it fits, as no probe could have had
+	 * a longer one.
+	 */
+	if (is_error(target_parse(&target, name), -1)) {
+		if (namelen >= sizeof(target.host)) {
+			return -1;
+		}
+
+		memcpy(target.host, name, namelen + NULL_BYTE);
+		target.port = 0;
+	}
+
+	if (report.round == RECORD_NO_ROUND) {
+		report.round = -1;
+	}
+
+	report.name = name;
+	report.host = target.host;
+	report.port = target.port;
+	report.addr = addr;
+	report.error = error ? probe_error_name((probe_error_t) error) : NULL;
+
+	if (!error) {
+		cipher_bytes[0] = (unsigned char) (cipher_id >> 8);
+		cipher_bytes[1] = (unsigned char) cipher_id;
+		cipher = SSL_CIPHER_find(decoder->ssl, cipher_bytes);
+
+		if (is_null((void *) cipher)) {
+			snprintf(cipher_name, sizeof(cipher_name), "0x%04X", cipher_id);
+			report.cipher = cipher_name;
+		} else {
+			report.cipher = SSL_CIPHER_get_name(cipher);
+		}
+
+		report.method = record_version_name(version);
+		report.chain = sk_X509_new_null();
+
+		for (index = 0; index < count; index += 1) {
+			crt_index = record_get_u32(reader);
+
+			if (reader->overrun || crt_index >= decoder->ncerts) {
+				sk_X509_free(report.chain);
+				return -1;
+			}
+
+			sk_X509_push(report.chain, decoder->certs[crt_index]);
+		}
+	} else {
+		decoder->failed += 1;
+	}
+
+	record_render(decoder, &report, &timing, error);
+	sk_X509_free(report.chain);
+
+	return 0;
+}
+
+/**
+ * Read records written with --format bin from path
+ * (- for stdin), and render them as text or NDJSON.
+ * Returns EXIT_FAILURE if the stream is malformed,
+ * or if any of the probes in it failed.
+ */
+int record_decode (settings_t *settings, const char *path, BIO *bp) {
+	int status, malformed;
+	uint32_t len, maxlen;
+	unsigned char header[RECORD_MAGIC_LENGTH];
+	unsigned char *body = NULL;
+	record_decoder_t decoder;
+	record_reader_t reader;
+	FILE *fp;
+
+	fp = compare((char *) path, "-") ? fopen(path, "rb") : stdin;
+
+	if (is_null(fp)) {
+		fprintf(stderr, "Error: Unable to open %s.\n", path);
+		return EXIT_FAILURE;
+	}
+
+	if (record_read(fp, header, sizeof(header), 0) != 1
+	    || memcmp(header, RECORD_MAGIC, RECORD_MAGIC_LENGTH)) {
+		fprintf(stderr, "Error: %s is not a keuka binary stream.\n", path);
+
+		if (fp != stdin) {
+			fclose(fp);
+		}
+
+		return EXIT_FAILURE;
+	}
+
+	memset(&decoder, 0, sizeof(decoder));
+	decoder.settings = settings;
+	decoder.bp = bp;
+	decoder.scratch = BIO_new(BIO_s_mem());
+	decoder.out = buf_new(BUF_INITIAL_SIZE * 32);
+
+	/**
+	 * Ciphers are recorded by IANA id, so names
+	 * are looked up against a throwaway session.
+	 */
+	decoder.ctx = SSL_CTX_new(TLS_client_method());
+	decoder.ssl = SSL_new(decoder.ctx);
+
+	malformed = 0;
+	maxlen = 0;
+
+	while ((status = record_read(fp, &len, sizeof(len), 1)) == 1) {
+		len = ntohl(len);
+
+		if (len < 1 || len > RECORD_MAX_LENGTH) {
+			malformed = 1;
+			break;
+		}
+
+		if (len > maxlen) {
+			if (is_null(body)) {
+				body = ALLOC((long) len);
+			} else {
+				RESIZE(body, (long) len);
+			}
+
+			maxlen = len;
+		}
+
+		if (record_read(fp, body, len, 0) != 1) {
+			malformed = 1;
+			break;
+		}
+
+		reader.data = body + 1;
+		reader.len = len - 1;
+		reader.pos = 0;
+		reader.overrun = 0;
+
+		switch (body[0]) {
+			case RECORD_CERT:
+				status = record_decode_cert(&decoder, &reader);
+				break;
+			case RECORD_PROBE:
+				status = record_decode_probe(&decoder, &reader);
+				break;
+			default:
+				/**
+				 * Skip records of types we don't know about.
+				 */
+				status = 0;
+				break;
+		}
+
+		if (is_error(status, -1)) {
+			malformed = 1;
+			break;
+		}
+	}
+
+	if (status == -1) {
+		malformed = 1;
+	}
+
+	if (malformed) {
+		fprintf(stderr, "Error: Malformed or truncated record in %s.\n", path);
+	}
+
+	buf_write(decoder.out, STDOUT_FILENO);
+
+	while (decoder.ncerts > 0) {
+		X509_free(decoder.certs[--decoder.ncerts]);
+	}
+
+	FREE(decoder.certs);
+	FREE(body);
+	buf_free(decoder.out);
+	BIO_free(decoder.scratch);
+	SSL_free(decoder.ssl);
+	SSL_CTX_free(decoder.ctx);
+
+	if (fp != stdin) {
+		fclose(fp);
+	}
+
+	return (malformed || decoder.failed > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
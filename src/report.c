@@ -0,0 +1,848 @@
+/**
+ * report.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "report.h"
+
+/**
+ * Fill in negotiated parameters and peer
+ * chain of an established SSL session.
+ */
+void report_session (report_t *report, SSL *ssl) {
+	report->method = SSL_get_version(ssl);
+	report->cipher = SSL_CIPHER_get_name(probe_cipher(ssl));
+	report->resumed = SSL_session_reused(ssl);
+	report->chain = probe_chain(ssl);
+}
+
+/**
+ * Prefix line with indicator and seconds
+ * elapsed, unless --quiet was given.
+ */
+static void report_stamp (BIO *bp, int quiet, double elapsed, const char *indicator) {
+	if (!quiet) {
+		BIO_printf(bp, "%s [%fs] ", indicator, elapsed);
+	}
+}
+
+/**
+ * Output how a probe ended: the protocol negotiated
+ * (unless quiet), or why it failed. Live runs and
+ * --decode both come through here, so a decoded
+ * record reads the same as it did when it was run.
+ */
+void report_outcome (BIO *bp, const report_t *report, probe_error_t error, int captured, int quiet, double elapsed) {
+	if (is_null((void *) report->error)) {
+		if (!quiet) {
+			report_stamp(bp, quiet, elapsed, KEUKA_INBOUND_INDICATOR);
+			BIO_printf(
+				bp,
+				"%s negotiated, %s.\n",
+				report->method,
+				captured ? "certificate received" : "handshake complete"
+			);
+		}
+
+		return;
+	}
+
+	switch (error) {
+		case PROBE_ERR_RESOLVE:
+			report_stamp(bp, quiet, elapsed, KEUKA_INBOUND_INDICATOR);
+			BIO_printf(bp, "Error: Unable to resolve hostname %s.\n", report->name);
+			break;
+		case PROBE_ERR_CONNECT:
+			report_stamp(bp, quiet, elapsed, KEUKA_INBOUND_INDICATOR);
+			BIO_printf(
+				bp,
+				"Error: Cannot connect to host %s [%s] on port %d.\n",
+				report->host,
+				report->addr,
+				report->port
+			);
+			break;
+		case PROBE_ERR_ATTACH:
+			report_stamp(bp, quiet, elapsed, KEUKA_NEUTRAL_INDICATOR);
+			BIO_printf(bp, "Error: Unable to attach SSL session to socket.\n");
+			break;
+		case PROBE_ERR_CONNECT_TIMEOUT:
+			report_stamp(bp, quiet, elapsed, KEUKA_INBOUND_INDICATOR);
+			BIO_printf(
+				bp,
+				"Error: Timed out connecting to host %s [%s] on port %d.\n",
+				report->host,
+				report->addr,
+				report->port
+			);
+			break;
+		case PROBE_ERR_HANDSHAKE_TIMEOUT:
+			report_stamp(bp, quiet, elapsed, KEUKA_NEUTRAL_INDICATOR);
+			BIO_printf(bp, "Error: Timed out building SSL session with https://%s. Handshake aborted.\n", report->name);
+			break;
+		case PROBE_ERR_DEADLINE:
+			report_stamp(bp, quiet, elapsed, KEUKA_NEUTRAL_INDICATOR);
+			BIO_printf(bp, "Error: Deadline exceeded for %s.\n", report->name);
+			break;
+		case PROBE_ERR_HANDSHAKE:
+		default:
+			report_stamp(bp, quiet, elapsed, KEUKA_NEUTRAL_INDICATOR);
+			BIO_printf(bp, "Error: Could not build SSL session with https://%s. Handshake aborted.\n", report->name);
+			break;
+	}
+}
+
+/**
+ * Output fields of a certificate in the chain, as
+ * selected by the given settings, on lines of their
+ * own, aligned with the index in front of the first.
+ */
+static void report_cert_text (BIO *bp, X509 *tcrt, EVP_PKEY *tpubkey, settings_t *settings) {
+	int sig_type_err, pad_tfmt;
+	const ASN1_BIT_STRING *asn1_sig = NULL;
+	const X509_ALGOR *sig_type = NULL;
+	X509_NAME *tcrtname = X509_get_subject_name(tcrt);
+
+	pad_tfmt = 0;
+
+	/**
+	 * If --subject option was given, output certificate subject information.
+	 */
+	if (settings->subject) {
+		BIO_printf(bp, "--- Subject: ");
+		X509_NAME_print_ex(
+			bp,
+			tcrtname,
+			0,
+			XN_FLAG_SEP_CPLUS_SPC
+		);
+		pad_tfmt = 1;
+	}
+
+	/**
+	 * If --issuer option was given, output certificate issuer information.
+	 */
+	if (settings->issuer) {
+		if (pad_tfmt) {
+			BIO_printf(bp, "%s%7s", "\n", "");
+		} else {
+			pad_tfmt = 1;
+		}
+
+		BIO_printf(bp, "--- Issuer: ");
+		X509_NAME_print_ex(
+			bp,
+			X509_get_issuer_name(tcrt),
+			0,
+			XN_FLAG_SEP_CPLUS_SPC
+		);
+	}
+
+	if (settings->bits) {
+		if (pad_tfmt) {
+			BIO_printf(bp, "%s%7s", "\n", "");
+		} else {
+			pad_tfmt = 1;
+		}
+
+		BIO_printf(
+			bp,
+			"--- Bits: %d",
+			EVP_PKEY_bits(tpubkey)
+		);
+	}
+
+	/**
+	 * If --serial option was given, output ASN1 serial.
+	 */
+	if (settings->serial) {
+		if (pad_tfmt) {
+			BIO_printf(bp, "%s%7s", "\n", "");
+		} else {
+			pad_tfmt = 1;
+		}
+
+		BIO_printf(bp, "--- Serial: ");
+		i2a_ASN1_INTEGER(
+			bp,
+			X509_get_serialNumber(tcrt)
+		);
+	}
+
+	/**
+	 * If --signature-algorithm option was given,
+	 * output signature algorithm for certificate(s).
+	 */
+	if (settings->sig_algo) {
+		if (pad_tfmt) {
+			BIO_printf(bp, "%s%7s", "\n", "");
+		} else {
+			pad_tfmt = 1;
+		}
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+		X509_get0_signature(&asn1_sig, &sig_type, tcrt);
+#else
+		sig_type = tcrt->sig_alg;
+		asn1_sig = tcrt->signature;
+#endif
+
+		BIO_printf(bp, "--- Signature Algorithm: ");
+		sig_type_err = i2a_ASN1_OBJECT(bp, sig_type->algorithm);
+
+		if (is_error(sig_type_err, -1) || is_error(sig_type_err, 0)) {
+			BIO_printf(bp, "Could not get signature algorithm.");
+		}
+	}
+
+	/**
+	 * If --validity option was given, output the
+	 * range of Not Before/Not After timestamps.
+	 */
+	if (settings->validity) {
+		if (pad_tfmt) {
+			BIO_printf(bp, "%s%7s", "\n", "");
+		} else {
+			pad_tfmt = 1;
+		}
+
+		BIO_printf(bp, "--- Validity:\n");
+		BIO_printf(bp, "%11s%s", "", "--- Not Before: ");
+		ASN1_TIME_print(bp, X509_get_notBefore(tcrt));
+		BIO_printf(bp, "\n");
+		BIO_printf(bp, "%11s%s", "", "--- Not After: ");
+		ASN1_TIME_print(bp, X509_get_notAfter(tcrt));
+	}
+
+	if (!pad_tfmt) {
+		BIO_printf(bp, "[redacted]");
+	}
+}
+
+/**
+ * Render callback for the certificate cache, for
+ * text output. The fingerprint is added so later
+ * references to the certificate can be resolved.
+ */
+static void report_cert_render (buf_t *buf, X509 *crt, const char *fingerprint, void *arg) {
+	char *data;
+	long len;
+	BIO *mem = BIO_new(BIO_s_mem());
+
+	report_cert_text(mem, crt, X509_get0_pubkey(crt), arg);
+	BIO_printf(mem, "%s%7s--- SHA-256: %s", "\n", "", fingerprint);
+
+	len = BIO_get_mem_data(mem, &data);
+	buf_append(buf, data, (size_t) len);
+	BIO_free(mem);
+}
+
+/**
+ * Put a reference to the certificate's entry in the
+ * cache at offset in the output, in place of its
+ * fields. Returns 0 if there's no room for more.
+ */
+static int report_cert_ref (const report_t *report, size_t offset, X509 *crt, cert_render_t render, void *arg) {
+	cert_entry_t *entry;
+	cert_refs_t *refs = report->refs;
+
+	if (refs->count == CERT_MAX_REFS) {
+		return 0;
+	}
+
+	entry = cert_cache_get(report->cache, crt, render, arg);
+
+	if (is_null(entry)) {
+		return 0;
+	}
+
+	refs->offsets[refs->count] = offset;
+	refs->entries[refs->count] = entry;
+	refs->count += 1;
+
+	return 1;
+}
+
+/**
+ * Output negotiated parameters and certificate
+ * information for an established SSL session,
+ * as selected by the given settings.
+ */
+int report_text (BIO *bp, const report_t *report, settings_t *settings, const char *url) {
+	size_t crt_index;
+	int sig_type_err;
+	const ASN1_BIT_STRING *asn1_sig = NULL;
+	const X509_ALGOR *sig_type = NULL;
+	STACK_OF(X509) *fullchain = NULL;
+	X509 *crt = NULL,
+	     *tcrt = NULL;
+	X509_NAME *crtname = NULL;
+	EVP_PKEY *pubkey = NULL,
+	         *tpubkey = NULL;
+
+	/**
+	 * Print cipher used if --cipher was given.
+	 */
+	if (settings->cipher) {
+		BIO_printf(
+			bp,
+			"--- Cipher: %s\n",
+			report->cipher
+		);
+	}
+
+	/**
+	 * If --method option was given, output
+	 * version of method used for handshake.
+	 */
+	if (settings->method) {
+		BIO_printf(
+			bp,
+			"--- Method: %s\n",
+			report->method
+		);
+	}
+
+	/**
+	 * Print outcome of verification if --verify was given.
+	 */
+	if (report->verified && is_null((void *) report->verify_error)) {
+		BIO_printf(bp, "--- Verification: ok\n");
+	} else if (report->verified) {
+		BIO_printf(
+			bp,
+			"--- Verification: failed (%s)\n",
+			report->verify_error
+		);
+	}
+
+	/**
+	 * Print full chain if --chain was given.
+	 */
+	if (settings->chain) {
+		/**
+		 * Get peer certificate chain.
+		 */
+		fullchain = report->chain;
+
+		if (is_null(fullchain)) {
+			BIO_printf(
+				bp,
+				"Error: Could not get certificate chain from %s.\n",
+				url
+			);
+			goto on_error;
+		}
+
+		BIO_printf(bp, "--- Certificate Chain:\n");
+
+		/**
+		 * Output certificate chain.
+		 */
+		for (
+			crt_index = 0;
+			crt_index < sk_X509_num(fullchain);
+			crt_index += 1
+		) {
+			tcrt = sk_X509_value(fullchain, crt_index);
+			tpubkey = X509_get0_pubkey(tcrt);
+
+			BIO_printf(
+				bp,
+				"%5d: ",
+				(int) crt_index
+			);
+
+			/**
+			 * In a batch, certificates are rendered once
+			 * and written out in full the first time only.
+			 */
+			if (is_null(report->cache)
+			    || !report_cert_ref(report, (size_t) BIO_get_mem_data(bp, NULL), tcrt, report_cert_render, settings)) {
+				report_cert_text(bp, tcrt, tpubkey, settings);
+			}
+
+			BIO_printf(bp, "\n");
+		}
+
+		/**
+		 * Output raw certificate contents if --raw option was specified.
+		 */
+		if (settings->raw) {
+			BIO_printf(bp, "\n");
+			PEM_write_bio_PUBKEY(bp, tpubkey);
+			BIO_printf(bp, "\n");
+
+			for (
+				crt_index = 0;
+				crt_index < sk_X509_num(fullchain);
+				crt_index += 1
+			) {
+				PEM_write_bio_X509(
+					bp,
+					sk_X509_value(fullchain, crt_index)
+				);
+				BIO_printf(bp, "\n");
+			}
+		}
+	} else {
+		/**
+		 * Get peer certificate, which comes first in
+		 * the chain. Take a reference of our own, as
+		 * SSL_get_peer_certificate would give us.
+		 */
+		if (!is_null(report->chain) && sk_X509_num(report->chain) > 0) {
+			crt = sk_X509_value(report->chain, 0);
+			X509_up_ref(crt);
+		}
+
+		if (is_null(crt)) {
+			BIO_printf(
+				bp,
+				"Error: Could not get certificate from %s.\n",
+				url
+			);
+			goto on_error;
+		}
+
+		crtname = X509_get_subject_name(crt);
+		pubkey = X509_get_pubkey(crt);
+
+		/**
+		 * If --subject option was given, output certificate subject information.
+		 */
+		if (settings->subject) {
+			BIO_printf(bp, "--- Subject: ");
+			X509_NAME_print_ex(
+				bp,
+				crtname,
+				0,
+				XN_FLAG_SEP_COMMA_PLUS
+			);
+			BIO_printf(bp, "\n");
+		}
+
+		/**
+		 * If --issuer option was given, output certificate issuer information.
+		 */
+		if (settings->issuer) {
+			BIO_printf(bp, "--- Issuer: ");
+			X509_NAME_print_ex(
+				bp,
+				X509_get_issuer_name(crt),
+				0,
+				XN_FLAG_SEP_CPLUS_SPC
+			);
+			BIO_printf(bp, "\n");
+		}
+
+		if (settings->bits) {
+			BIO_printf(
+				bp,
+				"%s%d\n", "--- Bits: ",
+				EVP_PKEY_bits(pubkey)
+			);
+		}
+
+		/**
+		 * If --serial option was given, output ASN1 serial.
+		 */
+		if (settings->serial) {
+			BIO_printf(bp, "--- Serial: ");
+			i2a_ASN1_INTEGER(
+				bp,
+				X509_get_serialNumber(crt)
+			);
+			BIO_printf(bp, "\n");
+		}
+
+		/**
+		 * If --signature-algorithm option was given,
+		 * output signature algorithm for certificate(s).
+		 */
+		if (settings->sig_algo) {
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+			X509_get0_signature(&asn1_sig, &sig_type, crt);
+#else
+			sig_type = crt->sig_alg;
+			asn1_sig = crt->signature;
+#endif
+
+			BIO_printf(bp, "--- Signature Algorithm: ");
+			sig_type_err = i2a_ASN1_OBJECT(bp, sig_type->algorithm);
+			BIO_printf(bp, "\n");
+
+			if (is_error(sig_type_err, -1) || is_error(sig_type_err, 0)) {
+				BIO_printf(bp, "Error: Could not get signature algorithm.\n");
+			}
+		}
+
+		/**
+		 * If --validity option was given, output the
+		 * range of Not Before/Not After timestamps.
+		 */
+		if (settings->validity) {
+			BIO_printf(bp, "%s", "--- Validity:\n");
+			BIO_printf(bp, "%4s%s", "", "--- Not Before: ");
+			ASN1_TIME_print(bp, X509_get_notBefore(crt));
+			BIO_printf(bp, "\n");
+			BIO_printf(bp, "%4s%s", "", "--- Not After: ");
+			ASN1_TIME_print(bp, X509_get_notAfter(crt));
+			BIO_printf(bp, "\n");
+		}
+
+		/**
+		 * Output raw certificate contents if --raw option was specified.
+		 */
+		if (settings->raw) {
+			BIO_printf(bp, "\n");
+			PEM_write_bio_PUBKEY(bp, pubkey);
+			BIO_printf(bp, "\n");
+			PEM_write_bio_X509(bp, crt);
+			BIO_printf(bp, "\n");
+		}
+	}
+
+	EVP_PKEY_free(pubkey);
+	X509_free(crt);
+
+	return 0;
+
+on_error:
+	EVP_PKEY_free(pubkey);
+	X509_free(crt);
+
+	return -1;
+}
+
+/**
+ * Output changes since the previous result, as given
+ * with --since, and what the previous result was.
+ */
+void report_changes (BIO *bp, const report_t *report) {
+	int change, first;
+	char fingerprint[CERT_FINGERPRINT_LENGTH + NULL_BYTE];
+	const store_slot_t *previous = report->previous;
+
+	BIO_printf(bp, "--- Changed:");
+
+	for (change = 1, first = 1; change < (1 << NUM_STORE_CHANGES); change <<= 1) {
+		if (report->changes & change) {
+			BIO_printf(bp, "%s %s", first ? "" : ",", store_change_name(change));
+			first = 0;
+		}
+	}
+
+	BIO_printf(bp, "\n");
+
+	if (is_null((void *) previous)) {
+		return;
+	}
+
+	cert_hex(previous->leaf, fingerprint);
+
+	BIO_printf(
+		bp,
+		"%4s--- Previous: %.*s %.*s %s, checked %llds ago\n",
+		"",
+		(int) sizeof(previous->method),
+		previous->method,
+		(int) sizeof(previous->cipher),
+		previous->cipher,
+		fingerprint,
+		(long long) (time(NULL) - previous->checked)
+	);
+}
+
+/**
+ * Output per-phase latency breakdown, in milliseconds.
+ * Phases that were never reached are omitted.
+ */
+void report_timing (BIO *bp, const timing_t *timing) {
+	int index;
+
+	BIO_printf(bp, "--- Timing:");
+
+	for (index = 0; index < NUM_PHASES; index += 1) {
+		if (!timing->begin[index]) {
+			continue;
+		}
+
+		BIO_printf(
+			bp,
+			" %s=%.3fms",
+			phase_name(index),
+			(double) timing_duration(timing, index) / NSEC_PER_MSEC
+		);
+	}
+
+	BIO_printf(
+		bp,
+		" total=%.3fms\n",
+		(double) timing_total(timing) / NSEC_PER_MSEC
+	);
+}
+
+/**
+ * Output memory allocated on behalf of a probe, by
+ * OpenSSL and by us, as accounted with --mem-stats.
+ * Bytes still live are held by the session, which
+ * is released after the report.
+ */
+void report_memory (BIO *bp, const mem_tally_t *tally) {
+	BIO_printf(
+		bp,
+		"--- Memory: %ld allocations, %ld bytes, peak %ld bytes, %ld bytes live\n",
+		tally->allocs,
+		tally->bytes,
+		tally->peak,
+		tally->live
+	);
+}
+
+/**
+ * Append "key":"value" pair, with value taken (and
+ * cleared) from what was printed into scratch.
+ */
+static void report_json_scratch (buf_t *buf, BIO *scratch, const char *key) {
+	char *data;
+	long len;
+
+	len = BIO_get_mem_data(scratch, &data);
+	buf_printf(buf, ",\"%s\":", key);
+	buf_json(buf, data, (size_t) len);
+	(void) BIO_reset(scratch);
+}
+
+/**
+ * Append "key":"value" pair, with an ASN1 time
+ * as an ISO 8601 timestamp, in UTC.
+ */
+static void report_json_time (buf_t *buf, const char *key, const ASN1_TIME *asn1_time) {
+	char stamp[32];
+	struct tm tm;
+
+	if (!ASN1_TIME_to_tm(asn1_time, &tm)) {
+		buf_printf(buf, ",\"%s\":null", key);
+		return;
+	}
+
+	strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", &tm);
+	buf_printf(buf, ",\"%s\":\"%s\"", key, stamp);
+}
+
+/**
+ * Append fields of a certificate to an open JSON object,
+ * and close it. Doubles as render callback for the cache,
+ * with the scratch BIO passed along as its argument.
+ */
+static void report_json_cert (buf_t *buf, X509 *crt, const char *fingerprint, void *arg) {
+	int sig_nid;
+	EVP_PKEY *pubkey;
+	BIO *scratch = arg;
+
+	buf_printf(buf, ",\"sha256\":\"%s\"", fingerprint);
+
+	X509_NAME_print_ex(scratch, X509_get_subject_name(crt), 0, XN_FLAG_RFC2253);
+	report_json_scratch(buf, scratch, "subject");
+
+	X509_NAME_print_ex(scratch, X509_get_issuer_name(crt), 0, XN_FLAG_RFC2253);
+	report_json_scratch(buf, scratch, "issuer");
+
+	i2a_ASN1_INTEGER(scratch, X509_get_serialNumber(crt));
+	report_json_scratch(buf, scratch, "serial");
+
+	sig_nid = X509_get_signature_nid(crt);
+	buf_puts(buf, ",\"signature_algorithm\":");
+
+	if (sig_nid == NID_undef) {
+		buf_puts(buf, "null");
+	} else {
+		buf_json(buf, OBJ_nid2ln(sig_nid), strlen(OBJ_nid2ln(sig_nid)));
+	}
+
+	/**
+	 * X509_get0_pubkey doesn't take a reference,
+	 * so there is nothing to free afterwards.
+	 */
+	pubkey = X509_get0_pubkey(crt);
+	buf_printf(buf, ",\"bits\":%d", is_null(pubkey) ? 0 : EVP_PKEY_bits(pubkey));
+
+	report_json_time(buf, "not_before", X509_get0_notBefore(crt));
+	report_json_time(buf, "not_after", X509_get0_notAfter(crt));
+	buf_puts(buf, "}");
+}
+
+/**
+ * Append "key":"value" pair, with a Unix
+ * time as an ISO 8601 timestamp, in UTC.
+ */
+static void report_json_stamp (buf_t *buf, const char *key, time_t stamp) {
+	char iso[32];
+	struct tm tm;
+
+	gmtime_r(&stamp, &tm);
+	strftime(iso, sizeof(iso), "%Y-%m-%dT%H:%M:%SZ", &tm);
+	buf_printf(buf, ",\"%s\":\"%s\"", key, iso);
+}
+
+/**
+ * Append changes since the previous result, and
+ * what the previous result was, as JSON fields.
+ */
+static void report_json_changes (buf_t *buf, const report_t *report) {
+	int change, first;
+	char fingerprint[CERT_FINGERPRINT_LENGTH + NULL_BYTE];
+	const store_slot_t *previous = report->previous;
+
+	buf_puts(buf, ",\"changes\":[");
+
+	for (change = 1, first = 1; change < (1 << NUM_STORE_CHANGES); change <<= 1) {
+		if (report->changes & change) {
+			buf_printf(buf, "%s\"%s\"", first ? "" : ",", store_change_name(change));
+			first = 0;
+		}
+	}
+
+	buf_puts(buf, "]");
+
+	if (is_null((void *) previous)) {
+		return;
+	}
+
+	cert_hex(previous->leaf, fingerprint);
+
+	buf_puts(buf, ",\"previous\":{\"method\":");
+	buf_json(buf, previous->method, strnlen(previous->method, sizeof(previous->method)));
+	buf_puts(buf, ",\"cipher\":");
+	buf_json(buf, previous->cipher, strnlen(previous->cipher, sizeof(previous->cipher)));
+	buf_printf(buf, ",\"sha256\":\"%s\"", fingerprint);
+	report_json_stamp(buf, "checked", (time_t) previous->checked);
+	buf_puts(buf, "}");
+}
+
+/**
+ * Append report as a JSON object, leaving it open
+ * so the caller can add timing once extraction is
+ * done. Everything is included regardless of settings,
+ * so consumers don't need to know how we were run.
+ */
+void report_json (buf_t *buf, BIO *scratch, const report_t *report) {
+	int crt_index;
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	char fingerprint[CERT_FINGERPRINT_LENGTH + NULL_BYTE];
+	X509 *crt;
+
+	buf_puts(buf, "{\"host\":");
+	buf_json(buf, report->host, strlen(report->host));
+	buf_printf(buf, ",\"port\":%d", report->port);
+
+	if (!is_null((void *) report->addr) && report->addr[0]) {
+		buf_puts(buf, ",\"address\":");
+		buf_json(buf, report->addr, strlen(report->addr));
+	}
+
+	if (report->round >= 0) {
+		buf_printf(buf, ",\"round\":%d", report->round);
+	}
+
+	if (report->changes) {
+		report_json_changes(buf, report);
+	}
+
+	if (!is_null((void *) report->error)) {
+		buf_puts(buf, ",\"status\":\"error\",\"error\":");
+		buf_json(buf, report->error, strlen(report->error));
+		return;
+	}
+
+	buf_puts(buf, ",\"status\":\"ok\",\"method\":");
+	buf_json(buf, report->method, strlen(report->method));
+	buf_puts(buf, ",\"cipher\":");
+	buf_json(buf, report->cipher, strlen(report->cipher));
+	buf_printf(buf, ",\"resumed\":%s", report->resumed ? "true" : "false");
+
+	if (report->verified) {
+		buf_printf(buf, ",\"verified\":%s", is_null((void *) report->verify_error) ? "true" : "false");
+
+		if (!is_null((void *) report->verify_error)) {
+			buf_puts(buf, ",\"verify_error\":");
+			buf_json(buf, report->verify_error, strlen(report->verify_error));
+		}
+	}
+
+	/**
+	 * Resumed sessions may come without a chain.
+	 */
+	if (is_null(report->chain)) {
+		return;
+	}
+
+	buf_puts(buf, ",\"chain\":[");
+
+	for (crt_index = 0; crt_index < sk_X509_num(report->chain); crt_index += 1) {
+		if (crt_index > 0) {
+			buf_puts(buf, ",");
+		}
+
+		crt = sk_X509_value(report->chain, crt_index);
+		buf_printf(buf, "{\"depth\":%d", crt_index);
+
+		if (!is_null(report->cache) && report_cert_ref(report, buf->len, crt, report_json_cert, scratch)) {
+			continue;
+		}
+
+		if (is_error(cert_digest(crt, digest, fingerprint), -1)) {
+			fingerprint[0] = '\0';
+		}
+
+		report_json_cert(buf, crt, fingerprint, scratch);
+	}
+
+	buf_puts(buf, "]");
+}
+
+/**
+ * Append memory allocated on behalf of a probe.
+ */
+void report_json_memory (buf_t *buf, const mem_tally_t *tally) {
+	buf_printf(
+		buf,
+		",\"memory\":{\"allocations\":%ld,\"bytes\":%ld,\"peak\":%ld,\"live\":%ld}",
+		tally->allocs,
+		tally->bytes,
+		tally->peak,
+		tally->live
+	);
+}
+
+/**
+ * Append per-phase latency breakdown, in milliseconds,
+ * and close the object. Phases that were never reached
+ * are omitted.
+ */
+void report_json_timing (buf_t *buf, const timing_t *timing) {
+	int index;
+
+	buf_puts(buf, ",\"timing\":{");
+
+	for (index = 0; index < NUM_PHASES; index += 1) {
+		if (!timing->begin[index]) {
+			continue;
+		}
+
+		buf_printf(
+			buf,
+			"\"%s\":%.3f,",
+			phase_name(index),
+			(double) timing_duration(timing, index) / NSEC_PER_MSEC
+		);
+	}
+
+	buf_printf(
+		buf,
+		"\"total\":%.3f}}\n",
+		(double) timing_total(timing) / NSEC_PER_MSEC
+	);
+}
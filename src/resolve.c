@@ -0,0 +1,1228 @@
+/**
+ * resolve.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include <openssl/rand.h>
+#include "resolve.h"
+
+#define DNS_HEADER_SIZE 12
+#define DNS_TYPE_A 1
+#define DNS_TYPE_CNAME 5
+#define DNS_TYPE_SOA 6
+#define DNS_TYPE_AAAA 28
+#define DNS_TYPE_OPT 41
+#define DNS_CLASS_IN 1
+#define DNS_FLAG_RD 0x0100
+#define DNS_FLAG_QR 0x8000
+#define DNS_RCODE_MASK 0x000f
+#define DNS_RCODE_NXDOMAIN 3
+#define DNS_MAX_HOPS 32
+#define DNS_NUM_IDS 65536
+
+#define RESOLVE_BUCKETS 1024
+
+enum {
+	ENTRY_IDLE = 0,
+	ENTRY_PENDING,
+	ENTRY_DONE
+};
+
+typedef struct resolve_waiter {
+	resolve_cb_t cb;
+	void *arg;
+	struct resolve_waiter *next;
+} resolve_waiter_t;
+
+/**
+ * Cache entry, one per (lowercased) name and address
+ * family, i.e. A and AAAA are cached separately. Entries
+ * are created on first lookup and stay in the table,
+ * being requeried once their TTL has expired.
+ */
+typedef struct resolve_entry {
+	char name[MAX_HOSTNAME_LENGTH + NULL_BYTE];
+	unsigned int hash;
+	int family;
+	int state;
+	int status;
+	int attempts;
+	int server;
+	int step;
+	int id;
+	uint64_t expires;
+	resolve_result_t result;
+	resolve_waiter_t *waiters;
+	ev_timer_t timer;
+	struct resolver *resolver;
+	struct resolve_entry *next;
+	struct resolve_entry *sent_prev;
+	struct resolve_entry *sent_next;
+} resolve_entry_t;
+
+/**
+ * Queries go to each nameserver in turn, moving on to
+ * the next on timeout or refusal, with a socket (and
+ * a list of queries in flight) per nameserver. Short names are tried with each domain
+ * of resolv.conf's search list in turn, then alone.
+ */
+struct resolver {
+	ev_loop_t *loop;
+	int nservers;
+	int fds[RESOLVE_MAX_SERVERS];
+	ev_watch_t watches[RESOLVE_MAX_SERVERS];
+	struct sockaddr_storage servers[RESOLVE_MAX_SERVERS];
+	socklen_t server_lens[RESOLVE_MAX_SERVERS];
+	resolve_entry_t *sent[RESOLVE_MAX_SERVERS];
+	int nsearch;
+	char search[RESOLVE_MAX_SEARCH][MAX_HOSTNAME_LENGTH + NULL_BYTE];
+	int ndots;
+	int delivering;
+	resolve_entry_t **buckets;
+	int nbuckets;
+	int count;
+	resolve_entry_t **pending;
+	unsigned char buf[RESOLVE_BUFSIZE];
+};
+
+static void resolver_send(resolve_entry_t *);
+
+/**
+ * Put entry on the list of queries in flight
+ * to the nameserver it was last sent to.
+ */
+static void resolve_track (resolve_entry_t *entry) {
+	resolver_t *resolver = entry->resolver;
+
+	entry->sent_prev = NULL;
+	entry->sent_next = resolver->sent[entry->server];
+
+	if (!is_null(entry->sent_next)) {
+		entry->sent_next->sent_prev = entry;
+	}
+
+	resolver->sent[entry->server] = entry;
+}
+
+/**
+ * Take entry off the list of queries in flight.
+ */
+static void resolve_untrack (resolve_entry_t *entry) {
+	resolver_t *resolver = entry->resolver;
+
+	if (is_null(entry->sent_prev)) {
+		resolver->sent[entry->server] = entry->sent_next;
+	} else {
+		entry->sent_prev->sent_next = entry->sent_next;
+	}
+
+	if (!is_null(entry->sent_next)) {
+		entry->sent_next->sent_prev = entry->sent_prev;
+	}
+
+	entry->sent_prev = NULL;
+	entry->sent_next = NULL;
+}
+
+/**
+ * FNV-1a hash of name and family.
+ */
+static unsigned int resolve_hash (const char *name, int family) {
+	unsigned int hash = 2166136261u;
+
+	while (*name) {
+		hash ^= (unsigned char) *name++;
+		hash *= 16777619u;
+	}
+
+	hash ^= (unsigned int) family;
+	hash *= 16777619u;
+
+	return hash;
+}
+
+/**
+ * Normalize name for use as cache key: lowercase,
+ * without a trailing dot. Returns -1 if too long.
+ */
+static int resolve_key (char *key, const char *name) {
+	size_t index, len;
+
+	len = strlen(name);
+
+	if (len > 0 && name[len - 1] == '.') {
+		len -= 1;
+	}
+
+	if (len == 0 || len > MAX_HOSTNAME_LENGTH) {
+		return -1;
+	}
+
+	for (index = 0; index < len; index += 1) {
+		key[index] = tolower((unsigned char) name[index]);
+	}
+
+	key[len] = '\0';
+
+	return 0;
+}
+
+static int resolve_expired (resolve_entry_t *entry, uint64_t now) {
+	return (entry->expires != 0 && entry->expires <= now);
+}
+
+static resolve_entry_t *resolve_find (resolver_t *resolver, const char *key, int family, unsigned int hash) {
+	resolve_entry_t *entry;
+
+	entry = resolver->buckets[hash & (resolver->nbuckets - 1)];
+
+	for (; !is_null(entry); entry = entry->next) {
+		if (entry->hash == hash && entry->family == family && !compare(entry->name, (char *) key)) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Drop expired, idle entries. Only done while no
+ * callbacks are being delivered, so entries are
+ * never released out from under a waiter.
+ */
+static void resolve_sweep (resolver_t *resolver) {
+	int index;
+	uint64_t now;
+	resolve_entry_t **link, *entry;
+
+	if (resolver->delivering) {
+		return;
+	}
+
+	now = clock_now();
+
+	for (index = 0; index < resolver->nbuckets; index += 1) {
+		link = &resolver->buckets[index];
+
+		while (!is_null(*link)) {
+			entry = *link;
+
+			if (entry->state == ENTRY_DONE && is_null(entry->waiters) && resolve_expired(entry, now)) {
+				*link = entry->next;
+				resolver->count -= 1;
+				FREE(entry);
+			} else {
+				link = &entry->next;
+			}
+		}
+	}
+}
+
+/**
+ * Double the number of buckets and rehash.
+ */
+static void resolve_grow (resolver_t *resolver) {
+	int index, nbuckets;
+	resolve_entry_t **buckets, *entry, *next;
+
+	nbuckets = resolver->nbuckets * 2;
+	buckets = CALLOC(nbuckets, (long) sizeof(resolve_entry_t *));
+
+	for (index = 0; index < resolver->nbuckets; index += 1) {
+		for (entry = resolver->buckets[index]; !is_null(entry); entry = next) {
+			next = entry->next;
+			entry->next = buckets[entry->hash & (nbuckets - 1)];
+			buckets[entry->hash & (nbuckets - 1)] = entry;
+		}
+	}
+
+	FREE(resolver->buckets);
+	resolver->buckets = buckets;
+	resolver->nbuckets = nbuckets;
+}
+
+static void resolve_timeout (ev_timer_t *);
+
+static resolve_entry_t *resolve_insert (resolver_t *resolver, const char *key, int family, unsigned int hash) {
+	resolve_entry_t *entry;
+
+	if (resolver->count >= resolver->nbuckets) {
+		resolve_sweep(resolver);
+
+		if (resolver->count >= resolver->nbuckets) {
+			resolve_grow(resolver);
+		}
+	}
+
+	NEW0(entry);
+	copy(entry->name, (char *) key);
+	entry->hash = hash;
+	entry->family = family;
+	entry->id = NOT_FOUND;
+	entry->resolver = resolver;
+	ev_timer_set(&entry->timer, resolve_timeout, entry);
+
+	entry->next = resolver->buckets[hash & (resolver->nbuckets - 1)];
+	resolver->buckets[hash & (resolver->nbuckets - 1)] = entry;
+	resolver->count += 1;
+
+	return entry;
+}
+
+static void resolve_add (resolve_result_t *result, int family, const void *addr) {
+	if (result->count >= RESOLVE_MAX_ADDRS) {
+		return;
+	}
+
+	result->addrs[result->count].family = family;
+	memcpy(
+		result->addrs[result->count].addr,
+		addr,
+		(family == AF_INET6) ? 16 : 4
+	);
+	result->count += 1;
+}
+
+/**
+ * Complete entry and deliver result to all
+ * waiters. TTL is in seconds, 0 not cached.
+ */
+static void resolve_done (resolve_entry_t *entry, int status, unsigned long ttl) {
+	resolver_t *resolver = entry->resolver;
+	resolve_waiter_t *waiter, *next;
+
+	ev_timer_stop(resolver->loop, &entry->timer);
+
+	if (!is_error(entry->id, NOT_FOUND)) {
+		resolver->pending[entry->id] = NULL;
+		entry->id = NOT_FOUND;
+		resolve_untrack(entry);
+	}
+
+	if (ttl > RESOLVE_MAX_TTL) {
+		ttl = RESOLVE_MAX_TTL;
+	}
+
+	entry->state = ENTRY_DONE;
+	entry->status = status;
+	entry->expires = clock_now() + ((uint64_t) ttl * NSEC_PER_SEC);
+
+	/**
+	 * Detach waiters first, so callbacks that look up
+	 * or cancel other names never see a stale list.
+	 */
+	waiter = entry->waiters;
+	entry->waiters = NULL;
+	resolver->delivering += 1;
+
+	for (; !is_null(waiter); waiter = next) {
+		next = waiter->next;
+		waiter->cb(waiter->arg, status, &entry->result);
+		FREE(waiter);
+	}
+
+	resolver->delivering -= 1;
+}
+
+/**
+ * Blocking lookup, used when no nameserver is available.
+ */
+static void resolve_fallback (resolve_entry_t *entry) {
+	struct addrinfo hints, *res, *ai;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = entry->family;
+	hints.ai_socktype = SOCK_STREAM;
+
+	entry->result.count = 0;
+
+	if (getaddrinfo(entry->name, NULL, &hints, &res) != 0) {
+		resolve_done(entry, RESOLVE_FAIL, 0);
+		return;
+	}
+
+	for (ai = res; !is_null(ai); ai = ai->ai_next) {
+		if (ai->ai_family == AF_INET6) {
+			resolve_add(
+				&entry->result,
+				AF_INET6,
+				&((struct sockaddr_in6 *) ai->ai_addr)->sin6_addr
+			);
+		} else {
+			resolve_add(
+				&entry->result,
+				AF_INET,
+				&((struct sockaddr_in *) ai->ai_addr)->sin_addr
+			);
+		}
+	}
+
+	freeaddrinfo(res);
+	resolve_done(entry, RESOLVE_OK, RESOLVE_FALLBACK_TTL);
+}
+
+/**
+ * Resend query for entry to the next nameserver, or
+ * fail it once every nameserver has had its retries.
+ */
+static void resolve_retry (resolve_entry_t *entry) {
+	entry->attempts += 1;
+
+	if (entry->attempts >= RESOLVE_RETRIES * entry->resolver->nservers) {
+		resolve_done(entry, RESOLVE_FAIL, 0);
+		return;
+	}
+
+	resolver_send(entry);
+}
+
+/**
+ * Nameserver entry was sent to is unreachable (ICMP
+ * refused). Rather than wait out the timeout, move on
+ * to the next after a short backoff, which grows with
+ * each round like the timeout does.
+ */
+static void resolve_backoff (resolve_entry_t *entry) {
+	resolver_t *resolver = entry->resolver;
+
+	ev_timer_stop(resolver->loop, &entry->timer);
+	ev_timer_start(
+		resolver->loop,
+		&entry->timer,
+		((uint64_t) RESOLVE_REFUSED_BACKOFF << (entry->attempts / resolver->nservers)) * NSEC_PER_MSEC
+	);
+}
+
+/**
+ * Back off every query in flight to server.
+ */
+static void resolve_refused (resolver_t *resolver, int server) {
+	resolve_entry_t *entry;
+
+	for (entry = resolver->sent[server]; !is_null(entry); entry = entry->sent_next) {
+		resolve_backoff(entry);
+	}
+}
+
+static void resolve_timeout (ev_timer_t *timer) {
+	resolve_retry(timer->arg);
+}
+
+/**
+ * Number of names to query for entry: one for each
+ * search domain then the name alone, if it has fewer
+ * dots than ndots, or else just the name alone.
+ */
+static int resolve_steps (resolve_entry_t *entry) {
+	int dots = 0;
+	const char *name;
+
+	for (name = entry->name; *name; name++) {
+		dots += (*name == '.');
+	}
+
+	return (dots < entry->resolver->ndots) ? entry->resolver->nsearch + 1 : 1;
+}
+
+/**
+ * Name to query for entry at its current step, into
+ * qname. Returns -1 if it'd be too long for a name.
+ */
+static int resolve_qname (resolve_entry_t *entry, char *qname) {
+	resolver_t *resolver = entry->resolver;
+
+	if (entry->step == resolve_steps(entry) - 1) {
+		copy(qname, entry->name);
+		return 0;
+	}
+
+	if (strlen(entry->name) + 1 + strlen(resolver->search[entry->step]) > MAX_HOSTNAME_LENGTH) {
+		return -1;
+	}
+
+	sprintf(qname, "%s.%s", entry->name, resolver->search[entry->step]);
+
+	return 0;
+}
+
+/**
+ * Encode query for name into buffer. Returns length.
+ */
+static int dns_query (unsigned char *buf, int id, const char *name, int qtype) {
+	int len;
+	const char *label, *dot;
+
+	memset(buf, 0, DNS_HEADER_SIZE);
+	buf[0] = (id >> 8) & 0xff;
+	buf[1] = id & 0xff;
+	buf[2] = (DNS_FLAG_RD >> 8) & 0xff;
+	buf[5] = 1;
+	buf[11] = 1;
+	len = DNS_HEADER_SIZE;
+
+	for (label = name; *label; label = *dot ? (dot + 1) : dot) {
+		dot = strchr(label, '.');
+
+		if (is_null((void *) dot)) {
+			dot = label + strlen(label);
+		}
+
+		if (dot - label == 0 || dot - label > 63) {
+			return -1;
+		}
+
+		buf[len++] = (unsigned char) (dot - label);
+		memcpy(buf + len, label, dot - label);
+		len += (int) (dot - label);
+	}
+
+	buf[len++] = 0;
+	buf[len++] = (qtype >> 8) & 0xff;
+	buf[len++] = qtype & 0xff;
+	buf[len++] = 0;
+	buf[len++] = DNS_CLASS_IN;
+
+	/**
+	 * EDNS0 OPT record, advertising a larger UDP payload.
+	 */
+	buf[len++] = 0;
+	buf[len++] = 0;
+	buf[len++] = DNS_TYPE_OPT;
+	buf[len++] = (RESOLVE_BUFSIZE >> 8) & 0xff;
+	buf[len++] = RESOLVE_BUFSIZE & 0xff;
+	memset(buf + len, 0, 6);
+	len += 6;
+
+	return len;
+}
+
+static unsigned int dns_u16 (const unsigned char *ptr) {
+	return ((unsigned int) ptr[0] << 8) | ptr[1];
+}
+
+static unsigned long dns_u32 (const unsigned char *ptr) {
+	return ((unsigned long) ptr[0] << 24) | ((unsigned long) ptr[1] << 16)
+	     | ((unsigned long) ptr[2] << 8) | ptr[3];
+}
+
+/**
+ * Decode (possibly compressed) name at offset into out,
+ * if given. Returns offset following the name, or -1.
+ */
+static int dns_name (const unsigned char *buf, int len, int off, char *out, size_t size) {
+	int next, hops;
+	size_t used;
+	unsigned int label;
+
+	next = NOT_FOUND;
+	used = 0;
+
+	for (hops = 0; hops < DNS_MAX_HOPS; hops += 1) {
+		if (off >= len) {
+			return -1;
+		}
+
+		label = buf[off];
+
+		if ((label & 0xc0) == 0xc0) {
+			if (off + 1 >= len) {
+				return -1;
+			}
+
+			if (is_error(next, NOT_FOUND)) {
+				next = off + 2;
+			}
+
+			off = (int) (((label & 0x3f) << 8) | buf[off + 1]);
+			continue;
+		}
+
+		if (label == 0) {
+			if (!is_null(out)) {
+				out[used] = '\0';
+			}
+
+			return is_error(next, NOT_FOUND) ? (off + 1) : next;
+		}
+
+		if (off + 1 + (int) label > len) {
+			return -1;
+		}
+
+		if (!is_null(out)) {
+			if (used + label + 2 > size) {
+				return -1;
+			}
+
+			if (used) {
+				out[used++] = '.';
+			}
+
+			memcpy(out + used, buf + off + 1, label);
+			used += label;
+		}
+
+		off += 1 + label;
+	}
+
+	return -1;
+}
+
+/**
+ * Parse response for entry, and complete it.
+ */
+static void dns_answer (resolve_entry_t *entry, const unsigned char *buf, int len) {
+	int off, index, qdcount, ancount, nscount, rcode, soa;
+	unsigned int type, rdlen, qtype, qlen;
+	unsigned long ttl, minttl, negttl;
+	char qname[MAX_HOSTNAME_LENGTH + 2], sent[MAX_HOSTNAME_LENGTH + NULL_BYTE];
+
+	qdcount = dns_u16(buf + 4);
+	ancount = dns_u16(buf + 6);
+	nscount = dns_u16(buf + 8);
+	rcode = dns_u16(buf + 2) & DNS_RCODE_MASK;
+
+	/**
+	 * The question must echo the name we asked for.
+	 */
+	if (qdcount != 1) {
+		return;
+	}
+
+	off = dns_name(buf, len, DNS_HEADER_SIZE, qname, sizeof(qname));
+
+	if (is_error(off, -1) || off + 4 > len
+	    || is_error(resolve_qname(entry, sent), -1) || strcasecmp(qname, sent)) {
+		return;
+	}
+
+	off += 4;
+
+	if (rcode != 0 && rcode != DNS_RCODE_NXDOMAIN) {
+		resolve_done(entry, RESOLVE_FAIL, 0);
+		return;
+	}
+
+	qtype = (entry->family == AF_INET6) ? DNS_TYPE_AAAA : DNS_TYPE_A;
+	qlen = (entry->family == AF_INET6) ? 16 : 4;
+	entry->result.count = 0;
+	minttl = RESOLVE_MAX_TTL;
+	negttl = RESOLVE_NEG_TTL;
+
+	for (index = 0; index < ancount + nscount; index += 1) {
+		off = dns_name(buf, len, off, NULL, 0);
+
+		if (is_error(off, -1) || off + 10 > len) {
+			break;
+		}
+
+		type = dns_u16(buf + off);
+		ttl = dns_u32(buf + off + 4);
+		rdlen = dns_u16(buf + off + 8);
+		off += 10;
+
+		if (off + (int) rdlen > len) {
+			break;
+		}
+
+		if (index < ancount) {
+			if (type == qtype && rdlen == qlen) {
+				resolve_add(&entry->result, entry->family, buf + off);
+			}
+
+			if ((type == qtype || type == DNS_TYPE_CNAME) && ttl < minttl) {
+				minttl = ttl;
+			}
+		} else if (type == DNS_TYPE_SOA) {
+			/**
+			 * Negative answers are cached for the lesser
+			 * of the SOA record TTL and its MINIMUM field.
+			 */
+			soa = dns_name(buf, len, off, NULL, 0);
+			soa = is_error(soa, -1) ? soa : dns_name(buf, len, soa, NULL, 0);
+
+			if (!is_error(soa, -1) && soa + 20 <= off + (int) rdlen) {
+				negttl = dns_u32(buf + soa + 16);
+				negttl = (ttl < negttl) ? ttl : negttl;
+			}
+		}
+
+		off += rdlen;
+	}
+
+	/**
+	 * The name as queried doesn't resolve, but the next
+	 * one from the search list (or the name alone) might.
+	 */
+	if ((rcode == DNS_RCODE_NXDOMAIN || entry->result.count == 0)
+	    && entry->step < resolve_steps(entry) - 1) {
+		entry->step += 1;
+		entry->attempts = 0;
+		resolver_send(entry);
+	} else if (rcode == DNS_RCODE_NXDOMAIN) {
+		resolve_done(entry, RESOLVE_NXDOMAIN, negttl);
+	} else if (entry->result.count == 0) {
+		resolve_done(entry, RESOLVE_FAIL, negttl);
+	} else {
+		resolve_done(entry, RESOLVE_OK, minttl);
+	}
+}
+
+/**
+ * Read all pending responses from the resolver socket.
+ */
+static void resolve_event (ev_watch_t *watch, int events) {
+	int id, server;
+	ssize_t len;
+	resolver_t *resolver = watch->arg;
+	resolve_entry_t *entry;
+
+	server = (int) (watch - resolver->watches);
+
+	while (1) {
+		len = recv(resolver->fds[server], resolver->buf, sizeof(resolver->buf), 0);
+
+		if (is_error((int) len, -1)) {
+			if (errno == ECONNREFUSED) {
+				resolve_refused(resolver, server);
+				continue;
+			}
+
+			break;
+		}
+
+		if (len < DNS_HEADER_SIZE || !(dns_u16(resolver->buf + 2) & DNS_FLAG_QR)) {
+			continue;
+		}
+
+		id = (int) dns_u16(resolver->buf);
+		entry = resolver->pending[id];
+
+		if (!is_null(entry)) {
+			dns_answer(entry, resolver->buf, (int) len);
+		}
+	}
+}
+
+/**
+ * Send (or resend) query for entry, under a fresh ID,
+ * to the nameserver whose turn it is. Names from the
+ * search list that'd be too long are passed over.
+ */
+static void resolver_send (resolve_entry_t *entry) {
+	int len;
+	unsigned char rnd[2];
+	unsigned char query[RESOLVE_BUFSIZE];
+	char qname[MAX_HOSTNAME_LENGTH + NULL_BYTE];
+	resolver_t *resolver = entry->resolver;
+
+	while (is_error(resolve_qname(entry, qname), -1)) {
+		entry->step += 1;
+	}
+
+	if (!is_error(entry->id, NOT_FOUND)) {
+		resolver->pending[entry->id] = NULL;
+		resolve_untrack(entry);
+	}
+
+	do {
+		if (RAND_bytes(rnd, sizeof(rnd)) != 1) {
+			rnd[0] = random() & 0xff;
+			rnd[1] = random() & 0xff;
+		}
+
+		entry->id = (int) dns_u16(rnd);
+	} while (!is_null(resolver->pending[entry->id]));
+
+	resolver->pending[entry->id] = entry;
+	len = dns_query(
+		query,
+		entry->id,
+		qname,
+		(entry->family == AF_INET6) ? DNS_TYPE_AAAA : DNS_TYPE_A
+	);
+
+	entry->server = entry->attempts % resolver->nservers;
+	resolve_track(entry);
+
+	if (is_error(len, -1)) {
+		resolve_done(entry, RESOLVE_FAIL, 0);
+		return;
+	}
+
+	/**
+	 * Back off exponentially between rounds
+	 * of retransmits to every nameserver.
+	 */
+	ev_timer_start(
+		resolver->loop,
+		&entry->timer,
+		((uint64_t) RESOLVE_TIMEOUT << (entry->attempts / resolver->nservers)) * NSEC_PER_MSEC
+	);
+
+	/**
+	 * A refusal reported here is for an earlier query
+	 * to the same nameserver, but it's just as gone.
+	 */
+	if (is_error((int) send(resolver->fds[entry->server], query, len, 0), -1) && errno == ECONNREFUSED) {
+		resolve_refused(resolver, entry->server);
+	}
+}
+
+/**
+ * Parse nameserver address, e.g. 127.0.0.1, 10.0.0.1:5353, [::1]:53.
+ */
+static int resolve_server (const char *spec, struct sockaddr_storage *addr, socklen_t *addrlen) {
+	int port;
+	char buf[MAX_URL_LENGTH], *host, *sep;
+	struct sockaddr_in *sin = (struct sockaddr_in *) addr;
+	struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) addr;
+
+	if (strlen(spec) >= sizeof(buf)) {
+		return -1;
+	}
+
+	copy(buf, (char *) spec);
+	host = buf;
+	port = RESOLVE_PORT;
+	sep = NULL;
+
+	if (*host == '[') {
+		host++;
+		sep = strchr(host, ']');
+
+		if (is_null(sep)) {
+			return -1;
+		}
+
+		*sep++ = '\0';
+		sep = (*sep == ':') ? sep : NULL;
+	} else if (strchr(host, ':') == strrchr(host, ':')) {
+		sep = strchr(host, ':');
+	}
+
+	if (!is_null(sep)) {
+		*sep++ = '\0';
+
+		if (!is_numeric(sep) || atoi(sep) < 1 || atoi(sep) > 65535) {
+			return -1;
+		}
+
+		port = atoi(sep);
+	}
+
+	/**
+	 * Drop any zone index (e.g. fe80::1%eth0).
+	 */
+	if (!is_null(sep = strchr(host, '%'))) {
+		*sep = '\0';
+	}
+
+	memset(addr, 0, sizeof(*addr));
+
+	if (inet_pton(AF_INET, host, &sin->sin_addr) == 1) {
+		sin->sin_family = AF_INET;
+		sin->sin_port = htons(port);
+		*addrlen = sizeof(*sin);
+	} else if (inet_pton(AF_INET6, host, &sin6->sin6_addr) == 1) {
+		sin6->sin6_family = AF_INET6;
+		sin6->sin6_port = htons(port);
+		*addrlen = sizeof(*sin6);
+	} else {
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Read nameservers from resolv.conf, in the order
+ * listed, along with the search list (search or
+ * domain), and the ndots option.
+ */
+static void resolve_conf (resolver_t *resolver) {
+	int error, ndots, index, count;
+	FILE *fp;
+	char line[RESOLVE_MAX_LINE], *keyword, *value, *saveptr;
+
+	fp = get_file(&error, RESOLV_CONF, "r");
+
+	if (error) {
+		return;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		keyword = strtok_r(line, " \t\r\n", &saveptr);
+
+		if (is_null(keyword)) {
+			continue;
+		}
+
+		value = strtok_r(NULL, " \t\r\n", &saveptr);
+		index = resolver->nservers;
+
+		if (!compare(keyword, "nameserver")) {
+			if (!is_null(value) && index < RESOLVE_MAX_SERVERS
+			    && !is_error(resolve_server(value, &resolver->servers[index], &resolver->server_lens[index]), -1)) {
+				resolver->nservers += 1;
+			}
+		} else if (!compare(keyword, "search") || !compare(keyword, "domain")) {
+			/**
+			 * The last of search and domain wins.
+			 */
+			for (count = 0; !is_null(value); value = strtok_r(NULL, " \t\r\n", &saveptr)) {
+				if (count < RESOLVE_MAX_SEARCH && !is_error(resolve_key(resolver->search[count], value), -1)) {
+					count += 1;
+				}
+			}
+
+			resolver->nsearch = count;
+		} else if (!compare(keyword, "options")) {
+			for (; !is_null(value); value = strtok_r(NULL, " \t\r\n", &saveptr)) {
+				if (sscanf(value, "ndots:%d", &ndots) == 1 && ndots >= 0) {
+					resolver->ndots = (ndots > RESOLVE_MAX_NDOTS) ? RESOLVE_MAX_NDOTS : ndots;
+				}
+			}
+		}
+	}
+
+	fclose(fp);
+}
+
+/**
+ * Nonblocking socket connected to nameserver, so
+ * replies from anyone else are dropped by the kernel.
+ */
+static int resolve_socket (const struct sockaddr_storage *addr, socklen_t addrlen) {
+	int fd;
+
+	fd = socket(addr->ss_family, SOCK_DGRAM, 0);
+
+	if (is_error(fd, -1)) {
+		return -1;
+	}
+
+	if (is_error(fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK), -1)
+	    || is_error(connect(fd, (const struct sockaddr *) addr, addrlen), -1)) {
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/**
+ * Permanent cache entry for key and family, from the
+ * hosts file, with no addresses until some are added.
+ */
+static resolve_entry_t *resolve_host (resolver_t *resolver, const char *key, int family) {
+	unsigned int hash;
+	resolve_entry_t *entry;
+
+	hash = resolve_hash(key, family);
+	entry = resolve_find(resolver, key, family, hash);
+
+	if (is_null(entry)) {
+		entry = resolve_insert(resolver, key, family, hash);
+		entry->state = ENTRY_DONE;
+		entry->status = RESOLVE_FAIL;
+	}
+
+	return entry;
+}
+
+/**
+ * Seed cache with permanent entries from the hosts file.
+ * Names listed there aren't looked up any further, so
+ * one listed for only one family has none of the other.
+ */
+static void resolve_hosts (resolver_t *resolver) {
+	int error, family;
+	FILE *fp;
+	char line[RESOLVE_MAX_LINE], key[MAX_HOSTNAME_LENGTH + NULL_BYTE],
+	     *token, *saveptr;
+	unsigned char addr[16];
+	resolve_entry_t *entry;
+
+	fp = get_file(&error, HOSTS_FILE, "r");
+
+	if (error) {
+		return;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		if (!is_null(token = strchr(line, '#'))) {
+			*token = '\0';
+		}
+
+		token = strtok_r(line, " \t\r\n", &saveptr);
+
+		if (is_null(token)) {
+			continue;
+		}
+
+		if (inet_pton(AF_INET, token, addr) == 1) {
+			family = AF_INET;
+		} else if (inet_pton(AF_INET6, token, addr) == 1) {
+			family = AF_INET6;
+		} else {
+			continue;
+		}
+
+		while (!is_null(token = strtok_r(NULL, " \t\r\n", &saveptr))) {
+			if (is_error(resolve_key(key, token), -1)) {
+				continue;
+			}
+
+			entry = resolve_host(resolver, key, family);
+			entry->status = RESOLVE_OK;
+			resolve_add(&entry->result, family, addr);
+			resolve_host(resolver, key, (family == AF_INET6) ? AF_INET : AF_INET6);
+		}
+	}
+
+	fclose(fp);
+}
+
+/**
+ * Create resolver on loop. Queries go to the given
+ * nameserver (ADDR[:PORT]), or those listed in
+ * resolv.conf if NULL, failing over from one to the
+ * next; failing that, lookups fall back to (blocking)
+ * getaddrinfo.
+ */
+resolver_t *resolver_new (ev_loop_t *loop, const char *server) {
+	int index, count, fd;
+	resolver_t *resolver;
+
+	NEW0(resolver);
+	resolver->loop = loop;
+	resolver->ndots = RESOLVE_NDOTS;
+	resolver->nbuckets = RESOLVE_BUCKETS;
+	resolver->buckets = CALLOC(resolver->nbuckets, (long) sizeof(resolve_entry_t *));
+	resolver->pending = CALLOC(DNS_NUM_IDS, (long) sizeof(resolve_entry_t *));
+
+	if (!is_null((void *) server)) {
+		if (is_error(resolve_server(server, &resolver->servers[0], &resolver->server_lens[0]), -1)) {
+			resolver_free(resolver);
+			return NULL;
+		}
+
+		resolver->nservers = 1;
+	} else {
+		resolve_conf(resolver);
+		resolve_hosts(resolver);
+	}
+
+	/**
+	 * Nameservers from resolv.conf that can't be reached
+	 * (e.g. IPv6 ones, without IPv6) are left out. One
+	 * given explicitly has to be reachable.
+	 */
+	for (index = 0, count = 0; index < resolver->nservers; index += 1) {
+		fd = resolve_socket(&resolver->servers[index], resolver->server_lens[index]);
+
+		if (is_error(fd, -1)) {
+			if (!is_null((void *) server)) {
+				resolver->nservers = count;
+				resolver_free(resolver);
+				return NULL;
+			}
+
+			continue;
+		}
+
+		resolver->servers[count] = resolver->servers[index];
+		resolver->server_lens[count] = resolver->server_lens[index];
+		resolver->fds[count] = fd;
+		ev_set(&resolver->watches[count], fd, resolve_event, resolver);
+		ev_add(loop, &resolver->watches[count], EV_READ);
+		count += 1;
+	}
+
+	resolver->nservers = count;
+
+	return resolver;
+}
+
+/**
+ * Release resolver and cache. Outstanding
+ * waiters are dropped without a callback.
+ */
+void resolver_free (resolver_t *resolver) {
+	int index;
+	resolve_entry_t *entry, *next;
+	resolve_waiter_t *waiter, *wnext;
+
+	if (is_null(resolver)) {
+		return;
+	}
+
+	for (index = 0; index < resolver->nbuckets; index += 1) {
+		for (entry = resolver->buckets[index]; !is_null(entry); entry = next) {
+			next = entry->next;
+			ev_timer_stop(resolver->loop, &entry->timer);
+
+			for (waiter = entry->waiters; !is_null(waiter); waiter = wnext) {
+				wnext = waiter->next;
+				FREE(waiter);
+			}
+
+			FREE(entry);
+		}
+	}
+
+	for (index = 0; index < resolver->nservers; index += 1) {
+		ev_del(resolver->loop, &resolver->watches[index]);
+		close(resolver->fds[index]);
+	}
+
+	FREE(resolver->buckets);
+	FREE(resolver->pending);
+	FREE(resolver);
+}
+
+/**
+ * Look up addresses of family (AF_INET for A records,
+ * AF_INET6 for AAAA) for name. The callback is invoked
+ * exactly once (unless cancelled), either immediately
+ * for literals and cached names, or from the loop once
+ * the nameserver responds. Concurrent lookups of the
+ * same name share a single query.
+ */
+void resolver_lookup (resolver_t *resolver, const char *name, int family, resolve_cb_t cb, void *arg) {
+	unsigned int hash;
+	char key[MAX_HOSTNAME_LENGTH + NULL_BYTE];
+	unsigned char addr[16];
+	resolve_result_t literal;
+	resolve_entry_t *entry;
+	resolve_waiter_t *waiter;
+
+	/**
+	 * Address literals need no lookup.
+	 */
+	literal.count = 0;
+
+	if (inet_pton(AF_INET, name, addr) == 1 || inet_pton(AF_INET6, name, addr) == 1) {
+		if (inet_pton(family, name, addr) == 1) {
+			resolve_add(&literal, family, addr);
+			cb(arg, RESOLVE_OK, &literal);
+		} else {
+			cb(arg, RESOLVE_FAIL, &literal);
+		}
+
+		return;
+	}
+
+	if (is_error(resolve_key(key, name), -1)) {
+		cb(arg, RESOLVE_FAIL, &literal);
+		return;
+	}
+
+	hash = resolve_hash(key, family);
+	entry = resolve_find(resolver, key, family, hash);
+
+	if (!is_null(entry) && entry->state == ENTRY_DONE && !resolve_expired(entry, clock_now())) {
+		cb(arg, entry->status, &entry->result);
+		return;
+	}
+
+	if (is_null(entry)) {
+		entry = resolve_insert(resolver, key, family, hash);
+	}
+
+	NEW(waiter);
+	waiter->cb = cb;
+	waiter->arg = arg;
+	waiter->next = entry->waiters;
+	entry->waiters = waiter;
+
+	if (entry->state == ENTRY_PENDING) {
+		return;
+	}
+
+	entry->state = ENTRY_PENDING;
+	entry->attempts = 0;
+	entry->step = 0;
+
+	if (resolver->nservers > 0) {
+		resolver_send(entry);
+	} else {
+		resolve_fallback(entry);
+	}
+}
+
+/**
+ * Withdraw interest in a pending lookup. The query itself
+ * carries on, so the answer still lands in the cache.
+ */
+void resolver_cancel (resolver_t *resolver, const char *name, int family, resolve_cb_t cb, void *arg) {
+	char key[MAX_HOSTNAME_LENGTH + NULL_BYTE];
+	resolve_entry_t *entry;
+	resolve_waiter_t **link, *waiter;
+
+	if (is_error(resolve_key(key, name), -1)) {
+		return;
+	}
+
+	entry = resolve_find(resolver, key, family, resolve_hash(key, family));
+
+	if (is_null(entry)) {
+		return;
+	}
+
+	for (link = &entry->waiters; !is_null(*link); link = &(*link)->next) {
+		waiter = *link;
+
+		if (waiter->cb == cb && waiter->arg == arg) {
+			*link = waiter->next;
+			FREE(waiter);
+			return;
+		}
+	}
+}
+
+/**
+ * Parse IPv4 or IPv6 address literal host into addr.
+ * Returns -1 if host isn't an address literal.
+ */
+int resolve_literal (const char *host, resolve_addr_t *addr) {
+	memset(addr, 0, sizeof(*addr));
+
+	if (inet_pton(AF_INET, host, addr->addr) == 1) {
+		addr->family = AF_INET;
+	} else if (inet_pton(AF_INET6, host, addr->addr) == 1) {
+		addr->family = AF_INET6;
+	} else {
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * Build socket address for resolved address and port.
+ */
+int resolve_sockaddr (const resolve_addr_t *raddr, int port, struct sockaddr_storage *addr, socklen_t *addrlen) {
+	struct sockaddr_in *sin = (struct sockaddr_in *) addr;
+	struct sockaddr_in6 *sin6 = (struct sockaddr_in6 *) addr;
+
+	memset(addr, 0, sizeof(*addr));
+
+	if (raddr->family == AF_INET6) {
+		sin6->sin6_family = AF_INET6;
+		sin6->sin6_port = htons(port);
+		memcpy(&sin6->sin6_addr, raddr->addr, 16);
+		*addrlen = sizeof(*sin6);
+	} else if (raddr->family == AF_INET) {
+		sin->sin_family = AF_INET;
+		sin->sin_port = htons(port);
+		memcpy(&sin->sin_addr, raddr->addr, 4);
+		*addrlen = sizeof(*sin);
+	} else {
+		return -1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,1378 @@
+/**
+ * scan.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include <stdarg.h>
+#include <signal.h>
+#include "scan.h"
+
+static volatile sig_atomic_t scan_stopped = 0;
+
+static void scan_note(probe_t *, int);
+static void scan_report(scan_job_t *, report_t *);
+
+/**
+ * Signal handler, wind --watch down once
+ * the probes in flight have finished.
+ */
+static void scan_stop (int signum) {
+	scan_stopped = 1;
+}
+
+/**
+ * Print message to bp, prefixed with indicator and time
+ * elapsed since the given instant, unless --quiet.
+ */
+static void scan_print (scan_t *scan, BIO *bp, uint64_t since, const char *indicator, const char *fmt, ...) {
+	va_list args;
+
+	if (!scan->settings->quiet) {
+		BIO_printf(
+			bp,
+			"%s [%fs] ",
+			indicator,
+			get_elapsed_time(since)
+		);
+	}
+
+	va_start(args, fmt);
+	BIO_vprintf(bp, fmt, args);
+	va_end(args);
+}
+
+/**
+ * Progress is stamped relative to the start of the
+ * run for a single host, and relative to the start
+ * of each probe when running a batch of targets.
+ */
+static uint64_t scan_since (scan_t *scan, probe_t *probe) {
+	return scan->progress ? scan->start : probe->timing.start;
+}
+
+/**
+ * Output reason a probe failed.
+ */
+static void scan_error (scan_job_t *job) {
+	report_t report;
+	scan_t *scan = job->scan;
+	probe_t *probe = job->probe;
+
+	scan_report(job, &report);
+	report_outcome(
+		job->bp,
+		&report,
+		probe->error,
+		probe->captured,
+		scan->settings->quiet,
+		get_elapsed_time(scan_since(scan, probe))
+	);
+
+	/**
+	 * The OpenSSL error queue is only meaningful
+	 * when a single probe is driving the session,
+	 * otherwise it was cleared on completion.
+	 */
+	if (scan->progress) {
+		ERR_print_errors(job->bp);
+	}
+}
+
+/**
+ * Output outcome and duration of each connection
+ * attempt made while racing the target addresses.
+ */
+static void scan_attempts (scan_job_t *job) {
+	int index;
+	attempt_t *attempt;
+	probe_t *probe = job->probe;
+
+	for (index = 0; index < probe->nattempts; index += 1) {
+		attempt = &probe->attempts[index];
+
+		BIO_printf(
+			job->bp,
+			"--- Attempt: %s %s %.3fms",
+			attempt->name,
+			(attempt->status == ATTEMPT_CONNECTED) ? "connected"
+				: (attempt->status == ATTEMPT_CANCELLED) ? "cancelled" : "failed",
+			(double) (attempt->end - attempt->begin) / NSEC_PER_MSEC
+		);
+
+		if (attempt->status == ATTEMPT_FAILED && attempt->error) {
+			BIO_printf(job->bp, " (%s)", strerror(attempt->error));
+		}
+
+		BIO_printf(job->bp, "\n");
+	}
+}
+
+/**
+ * Output whether the session was resumed, and how long
+ * the handshake took, for a round of --resume.
+ */
+static void scan_round (scan_job_t *job) {
+	uint64_t elapsed;
+	probe_t *probe = job->probe;
+
+	elapsed = timing_duration(&probe->timing, PHASE_HANDSHAKE);
+
+	if (probe->rounds.round == 0) {
+		BIO_printf(
+			job->bp,
+			"--- Session: full handshake %.3fms%s\n",
+			(double) elapsed / NSEC_PER_MSEC,
+			job->issued ? "" : ", no session issued"
+		);
+		return;
+	}
+
+	BIO_printf(
+		job->bp,
+		"--- Session: %s %.3fms (%d/%d)\n",
+		job->reused ? "resumed handshake" : "full handshake, resumption declined,",
+		(double) elapsed / NSEC_PER_MSEC,
+		probe->rounds.round,
+		job->scan->settings->resume
+	);
+}
+
+/**
+ * Output summary of a finished chain of --resume rounds.
+ */
+static void scan_rounds (scan_job_t *job) {
+	resume_t *rounds = &job->probe->rounds;
+
+	BIO_printf(
+		job->bp,
+		"--- Resumption: %d/%d resumed, full %.3fms",
+		rounds->reused,
+		job->scan->settings->resume,
+		(double) rounds->full / NSEC_PER_MSEC
+	);
+
+	if (rounds->reused) {
+		BIO_printf(
+			job->bp,
+			", resumed %.3fms avg",
+			(double) rounds->resumed / rounds->reused / NSEC_PER_MSEC
+		);
+	}
+
+	BIO_printf(job->bp, "\n");
+}
+
+/**
+ * Account for a finished round of --resume, before
+ * its session is handed over to the next round.
+ */
+static void scan_tally (scan_job_t *job) {
+	uint64_t elapsed;
+	probe_t *probe = job->probe;
+	resume_t *rounds = &probe->rounds;
+
+	job->reused = SSL_session_reused(probe->ssl);
+	job->issued = !is_null(probe->ticket);
+	elapsed = timing_duration(&probe->timing, PHASE_HANDSHAKE);
+
+	if (rounds->round == 0) {
+		rounds->full = elapsed;
+	} else if (job->reused) {
+		rounds->reused += 1;
+		rounds->resumed += elapsed;
+	}
+}
+
+/**
+ * Ask the throttle whether probe may connect yet.
+ */
+static int scan_admit (probe_t *probe, const resolve_addr_t *addr) {
+	scan_t *scan = probe->arg;
+
+	if (!throttle_admit(scan->throttle, probe, addr)) {
+		return 0;
+	}
+
+	if (!is_null(scan->metrics)) {
+		metrics_started(scan->metrics);
+	}
+
+	return 1;
+}
+
+/**
+ * Create probe for target, configured per settings.
+ */
+static probe_t *scan_probe (scan_t *scan, const target_t *target) {
+	probe_t *probe;
+	settings_t *settings = scan->settings;
+
+	probe = probe_new(target, scan->ctx, scan->loop, scan->resolver);
+	probe->no_sni = settings->no_sni;
+	probe->connect_timeout = settings->connect_timeout;
+	probe->handshake_timeout = settings->handshake_timeout;
+	probe->deadline = settings->deadline;
+	probe->resume = settings->resume;
+	probe->cert_only = settings->cert_only;
+	probe->notify = scan_note;
+
+	/**
+	 * Connect to the address given with --connect,
+	 * whatever the target's name resolves to.
+	 */
+	if (!is_null(settings->connect)) {
+		probe->pinned = &scan->addr;
+		probe->target.port = scan->port;
+	}
+
+	probe->arg = scan;
+
+	/**
+	 * With a throttle, a probe counts as started once
+	 * it's let go, so held probes aren't in flight.
+	 */
+	if (!is_null(scan->throttle)) {
+		probe->admit = scan_admit;
+	} else if (!is_null(scan->metrics)) {
+		metrics_started(scan->metrics);
+	}
+
+	return probe;
+}
+
+/**
+ * Follow a successful handshake with another round against
+ * the same target, offering the session it was issued. For
+ * servers that issued nothing, offer the previous session.
+ */
+static probe_t *scan_next_round (scan_t *scan, probe_t *probe) {
+	probe_t *next;
+
+	next = scan_probe(scan, &probe->target);
+	next->rounds = probe->rounds;
+	next->rounds.round += 1;
+
+	if (!is_null(probe->ticket)) {
+		next->session = probe->ticket;
+		probe->ticket = NULL;
+	} else {
+		next->session = probe->session;
+		probe->session = NULL;
+	}
+
+	return next;
+}
+
+/**
+ * Start next repeat of a --count series.
+ */
+static void scan_repeat (ev_timer_t *timer) {
+	series_t *series = timer->arg;
+	probe_t *probe;
+
+	probe = scan_probe(series->scan, &series->target);
+	probe->chain = series;
+	probe_start(probe);
+}
+
+/**
+ * Create series for repeated probes of target.
+ */
+static series_t *scan_series (scan_t *scan, const target_t *target) {
+	int index;
+	series_t *series;
+
+	NEW0(series);
+	series->scan = scan;
+	series->target = *target;
+	ev_timer_set(&series->timer, scan_repeat, series);
+
+	for (index = 0; index <= NUM_PHASES; index += 1) {
+		series->hists[index] = hist_new();
+	}
+
+	return series;
+}
+
+/**
+ * Release series and its histograms.
+ */
+static void scan_series_free (series_t *series) {
+	int index;
+
+	for (index = 0; index <= NUM_PHASES; index += 1) {
+		hist_free(series->hists[index]);
+	}
+
+	FREE(series);
+}
+
+/**
+ * Add latency of each phase of probe to series.
+ * Extraction only happens once, so it's left out.
+ */
+static void scan_sample (series_t *series, probe_t *probe) {
+	int index;
+
+	series->done += 1;
+
+	if (probe->state != PROBE_DONE) {
+		series->failed += 1;
+		return;
+	}
+
+	for (index = 0; index < NUM_PHASES; index += 1) {
+		if (index != PHASE_EXTRACT && probe->timing.begin[index]) {
+			hist_record(series->hists[index], timing_duration(&probe->timing, index));
+		}
+	}
+
+	hist_record(series->hists[NUM_PHASES], timing_total(&probe->timing));
+}
+
+/**
+ * Output latency percentiles of each phase in series.
+ */
+static void scan_latency (scan_job_t *job) {
+	int index;
+	hist_t *hist;
+	series_t *series = job->series;
+
+	BIO_printf(
+		job->bp,
+		"--- Latency (%d probes, %d failed):\n",
+		series->done,
+		series->failed
+	);
+
+	for (index = 0; index <= NUM_PHASES; index += 1) {
+		hist = series->hists[index];
+
+		if (hist->total == 0) {
+			continue;
+		}
+
+		BIO_printf(
+			job->bp,
+			"%4s%-10s p50=%.3fms p90=%.3fms p99=%.3fms max=%.3fms\n",
+			"",
+			(index == NUM_PHASES) ? "total" : phase_name(index),
+			(double) hist_percentile(hist, 50.0) / NSEC_PER_MSEC,
+			(double) hist_percentile(hist, 90.0) / NSEC_PER_MSEC,
+			(double) hist_percentile(hist, 99.0) / NSEC_PER_MSEC,
+			(double) hist->max / NSEC_PER_MSEC
+		);
+	}
+}
+
+/**
+ * Take an output buffer off the free list,
+ * or make a new one if all are in use.
+ */
+static output_t *scan_output (scan_t *scan) {
+	output_t *output;
+
+	if (!is_null(scan->pool)) {
+		pthread_mutex_lock(&scan->lock);
+	}
+
+	output = scan->outputs;
+
+	if (!is_null(output)) {
+		scan->outputs = output->next;
+	}
+
+	if (!is_null(scan->pool)) {
+		pthread_mutex_unlock(&scan->lock);
+	}
+
+	if (is_null(output)) {
+		NEW0(output);
+		output->buf = buf_new(BUF_INITIAL_SIZE);
+		output->expanded = buf_new(BUF_INITIAL_SIZE);
+		output->scratch = BIO_new(BIO_s_mem());
+	}
+
+	buf_reset(output->buf);
+	buf_reset(output->expanded);
+
+	return output;
+}
+
+/**
+ * Put output buffer back on the free list. Called
+ * with the lock held, when rendering on the pool.
+ */
+static void scan_release (scan_t *scan, output_t *output) {
+	output->next = scan->outputs;
+	scan->outputs = output;
+}
+
+/**
+ * Write rendered report out, putting certificates
+ * in place of references to them, if there are any.
+ * Reports in a format other than text are rendered
+ * into the output buffer itself.
+ * Called with the lock held, when rendering on the
+ * pool, so certificates are written out in full
+ * before they are referred to.
+ */
+static void scan_write (scan_job_t *job, output_t *output, const char *data, size_t len) {
+	uint64_t begin;
+	scan_t *scan = job->scan;
+
+	begin = clock_now();
+
+	if (job->refs.count > 0) {
+		cert_cache_expand(&job->refs, data, len, output->expanded);
+		cert_cache_release(scan->cache, &job->refs);
+		data = output->expanded->data;
+		len = output->expanded->len;
+	}
+
+	if (scan->settings->format == FORMAT_TEXT) {
+		BIO_write(scan->bp, data, (int) len);
+
+		if (scan->settings->watch) {
+			BIO_flush(scan->bp);
+		}
+	} else {
+		buf_write((job->refs.count > 0) ? output->expanded : output->buf, STDOUT_FILENO);
+	}
+
+	trace_event("output", "probe", begin, clock_now(), NULL);
+}
+
+/**
+ * Record phase of probe in the trace, if it was reached.
+ */
+static void scan_trace (probe_t *probe, phase_t phase) {
+	if (probe->timing.begin[phase] && probe->timing.end[phase]) {
+		trace_event(phase_name(phase), "probe", probe->timing.begin[phase], probe->timing.end[phase], probe->target.name);
+	}
+}
+
+/**
+ * Fill in report of a finished probe.
+ */
+static void scan_report (scan_job_t *job, report_t *report) {
+	probe_t *probe = job->probe;
+
+	memset(report, 0, sizeof(*report));
+	report->name = probe->target.name;
+	report->host = probe->target.host;
+	report->port = probe->target.port;
+	report->addr = probe->addr;
+	report->round = job->scan->settings->resume ? probe->rounds.round : -1;
+	report->cache = job->scan->cache;
+	report->refs = &job->refs;
+	report->changes = job->changes;
+	report->previous = job->known ? &job->previous : NULL;
+
+	if (job->verify >= 0) {
+		report->verified = 1;
+		report->verify_error = (job->verify == X509_V_OK) ? NULL : X509_verify_cert_error_string(job->verify);
+	}
+
+	if (probe->state == PROBE_DONE) {
+		report_session(report, probe->ssl);
+	} else {
+		report->error = probe_error_name(probe->error);
+	}
+}
+
+/**
+ * Render a finished probe as a single line of JSON,
+ * or as a binary record, and write it out with one
+ * write(2), so records of concurrent probes never
+ * interleave. Binary records refer to certificates
+ * written before, so those are encoded in order,
+ * while holding the lock.
+ */
+static void scan_encode (scan_job_t *job) {
+	report_t report;
+	output_t *output;
+	buf_t *buf;
+	mem_arena_t *previous;
+	scan_t *scan = job->scan;
+	probe_t *probe = job->probe;
+	settings_t *settings = scan->settings;
+
+	output = scan_output(scan);
+	buf = output->buf;
+
+	if (settings->format == FORMAT_NDJSON) {
+		scan_report(job, &report);
+
+		/**
+		 * Only a completed handshake has anything
+		 * to extract, so only its render is timed.
+		 */
+		previous = Mem_arena_enter(probe->arena);
+
+		if (probe->state == PROBE_DONE) {
+			timing_begin(&probe->timing, PHASE_EXTRACT);
+		}
+
+		report_json(buf, output->scratch, &report);
+
+		if (probe->state == PROBE_DONE) {
+			timing_end(&probe->timing, PHASE_EXTRACT);
+		}
+
+		Mem_arena_leave(previous);
+		scan_trace(probe, PHASE_EXTRACT);
+
+		if (settings->mem_stats && !is_null(probe->arena)) {
+			report_json_memory(buf, &probe->arena->tally);
+		}
+
+		report_json_timing(buf, &probe->timing);
+	}
+
+	if (!is_null(scan->pool)) {
+		pthread_mutex_lock(&scan->lock);
+	}
+
+	if (settings->format == FORMAT_BIN) {
+		record_probe(buf, scan->certs, probe, settings->resume ? probe->rounds.round : -1);
+	}
+
+	scan_write(job, output, buf->data, buf->len);
+	scan_release(scan, output);
+
+	if (!is_null(scan->pool)) {
+		pthread_mutex_unlock(&scan->lock);
+	}
+
+	if (!is_null(job->series)) {
+		scan_series_free(job->series);
+	}
+
+	probe_free(probe);
+}
+
+/**
+ * Render report of a finished probe into the job's
+ * buffer, then release the probe. Runs on the pool
+ * when rendering in parallel, so it must not touch
+ * anything the I/O thread may be using.
+ */
+static void scan_render (scan_job_t *job) {
+	int batch, status;
+	report_t report;
+	char url[MAX_URL_LENGTH + 8];
+	mem_arena_t *previous;
+	scan_t *scan = job->scan;
+	probe_t *probe = job->probe;
+	settings_t *settings = scan->settings;
+
+	/**
+	 * Verify chain of the initial handshake, if --verify
+	 * was given. This is done here, so it's spread over
+	 * the pool, rather than holding up the I/O thread.
+	 */
+	if (!is_null(scan->verify) && job->first && probe->state == PROBE_DONE) {
+		job->verify = verify_chain(scan->verify, probe_chain(probe->ssl), probe->target.host);
+
+		if (job->verify != X509_V_OK) {
+			__atomic_add_fetch(&scan->failed, 1, __ATOMIC_RELAXED);
+		}
+	}
+
+	if (settings->format != FORMAT_TEXT) {
+		scan_encode(job);
+		return;
+	}
+
+	batch = !is_null(settings->targets) || settings->watch;
+	snprintf(url, sizeof(url), "https://%s", probe->target.name);
+
+	if (batch) {
+		BIO_printf(job->bp, "--- Host: %s\n", probe->target.name);
+	}
+
+	if (job->changes) {
+		scan_report(job, &report);
+		report_changes(job->bp, &report);
+	}
+
+	if (probe->state == PROBE_DONE) {
+		/**
+		 * Certificate details are the same every round,
+		 * so they're only reported for the first one.
+		 */
+		if (job->first) {
+			scan_report(job, &report);
+			report_outcome(
+				job->bp,
+				&report,
+				probe->error,
+				probe->captured,
+				settings->quiet,
+				get_elapsed_time(scan_since(scan, probe))
+			);
+
+			if (settings->pad_fmt && !batch && !settings->quiet) {
+				BIO_printf(job->bp, "\n");
+			}
+
+			/**
+			 * Print address connected to if --address was given.
+			 */
+			if (settings->address) {
+				BIO_printf(job->bp, "--- Address: %s\n", probe->addr);
+			}
+
+			/**
+			 * Rendering allocates on behalf of the probe
+			 * too, so it's done in the probe's arena.
+			 */
+			previous = Mem_arena_enter(probe->arena);
+			timing_begin(&probe->timing, PHASE_EXTRACT);
+			status = report_text(job->bp, &report, settings, url);
+			timing_end(&probe->timing, PHASE_EXTRACT);
+			Mem_arena_leave(previous);
+			scan_trace(probe, PHASE_EXTRACT);
+
+			if (is_error(status, -1)) {
+				ERR_print_errors(job->bp);
+				__atomic_add_fetch(&scan->failed, 1, __ATOMIC_RELAXED);
+			}
+		}
+
+		if (settings->resume) {
+			scan_round(job);
+		}
+	} else {
+		scan_error(job);
+	}
+
+	if (settings->timing) {
+		report_timing(job->bp, &probe->timing);
+		scan_attempts(job);
+	}
+
+	if (settings->mem_stats && !is_null(probe->arena)) {
+		report_memory(job->bp, &probe->arena->tally);
+	}
+
+	if (settings->resume && !job->chained && (probe->rounds.round > 0 || probe->state == PROBE_DONE)) {
+		scan_rounds(job);
+	}
+
+	if (!is_null(job->series)) {
+		scan_latency(job);
+		scan_series_free(job->series);
+	}
+
+	if (batch && !settings->quiet) {
+		BIO_printf(job->bp, "\n");
+	}
+
+	probe_free(probe);
+}
+
+/**
+ * Pool task: render report, then write it out in
+ * one piece, so reports of probes don't interleave.
+ */
+static void scan_task (void *arg) {
+	char *buf;
+	long len;
+	output_t *output;
+	scan_job_t *job = arg;
+	scan_t *scan = job->scan;
+
+	scan_render(job);
+
+	if (!is_null(job->bp)) {
+		len = BIO_get_mem_data(job->bp, &buf);
+		output = scan_output(scan);
+
+		pthread_mutex_lock(&scan->lock);
+		scan_write(job, output, buf, (size_t) len);
+		scan_release(scan, output);
+		pthread_mutex_unlock(&scan->lock);
+
+		BIO_free(job->bp);
+	}
+
+	FREE(job);
+}
+
+/**
+ * Handle a finished probe on the I/O thread. Settle
+ * everything that affects further probes (series and
+ * --resume rounds) here, then hand the probe off to
+ * be rendered, either inline or on the pool.
+ */
+static void scan_complete (scan_t *scan, probe_t *probe) {
+	int last;
+	unsigned char key[STORE_KEY_LENGTH];
+	store_slot_t *slot, current;
+	probe_t *next = NULL;
+	scan_job_t *job;
+	series_t *series = probe->chain;
+	watch_entry_t *entry = probe->entry;
+	settings_t *settings = scan->settings;
+
+	NEW0(job);
+	job->scan = scan;
+	job->probe = probe;
+	job->first = (probe->rounds.round == 0);
+	job->verify = -1;
+	last = 1;
+
+	if (probe->state != PROBE_DONE) {
+		__atomic_add_fetch(&scan->failed, 1, __ATOMIC_RELAXED);
+	}
+
+	if (!is_null(scan->metrics)) {
+		/**
+		 * A probe that never got past the throttle is
+		 * counted as started on the way out, so none
+		 * is completed without having been started.
+		 */
+		if (probe->held || (!is_null(scan->throttle) && !probe->admitted)) {
+			metrics_started(scan->metrics);
+		}
+
+		metrics_done(scan->metrics, probe);
+	}
+
+	if (!is_null(scan->throttle)) {
+		throttle_done(scan->throttle, probe);
+	}
+
+	scan_trace(probe, PHASE_RESOLVE);
+	scan_trace(probe, PHASE_CONNECT);
+	scan_trace(probe, PHASE_HANDSHAKE);
+
+	scan->completed += 1;
+
+	/**
+	 * Compare result of the initial handshake with the
+	 * snapshot given with --since (or with the check
+	 * before it, under --watch), then keep it in the
+	 * store. Results that didn't change aren't reported.
+	 */
+	if (probe->rounds.round == 0 && (!is_null(scan->store) || !is_null(scan->snapshot) || !is_null(entry))) {
+		store_key(key, &probe->target, probe->no_sni);
+		memcpy(current.key, key, STORE_KEY_LENGTH);
+
+		if (probe->state == PROBE_DONE) {
+			store_fill(&current, probe->ssl);
+		}
+
+		if (!is_null(scan->snapshot)) {
+			slot = store_find(scan->snapshot, key);
+
+			if (!is_null(slot)) {
+				job->previous = *slot;
+				job->known = 1;
+			}
+
+			job->changes = store_diff(slot, (probe->state == PROBE_DONE) ? &current : NULL);
+		}
+
+		if (!is_null(entry)) {
+			job->previous = entry->last;
+			job->known = entry->known;
+			job->changes = watch_done(scan->watch, entry, (probe->state == PROBE_DONE) ? &current : NULL);
+		}
+
+		if (!is_null(scan->store) && probe->state == PROBE_DONE) {
+			slot = store_put(scan->store, key);
+
+			if (!is_null(slot)) {
+				*slot = current;
+			}
+		}
+
+		if ((!is_null(scan->snapshot) || !is_null(entry)) && !job->changes) {
+			probe_free(probe);
+			FREE(job);
+			goto on_release;
+		}
+	}
+
+	if (!is_null(series)) {
+		scan_sample(series, probe);
+		job->first = (series->done == 1);
+		last = (series->done == settings->count);
+
+		if (last) {
+			job->series = series;
+		}
+
+		/**
+		 * Repeats in between the first and last only
+		 * have something to say if they failed, unless
+		 * every probe is reported on a line of its own.
+		 */
+		if (!job->first && !last && probe->state == PROBE_DONE
+		    && !settings->timing && settings->format == FORMAT_TEXT) {
+			probe_free(probe);
+			FREE(job);
+			goto on_release;
+		}
+	}
+
+	if (settings->resume && probe->state == PROBE_DONE) {
+		scan_tally(job);
+
+		if (probe->rounds.round < settings->resume) {
+			next = scan_next_round(scan, probe);
+			job->chained = 1;
+		}
+	}
+
+	if (is_null(scan->pool)) {
+		job->bp = scan->bp;
+		scan_render(job);
+		FREE(job);
+
+		if (settings->watch) {
+			BIO_flush(scan->bp);
+		}
+	} else {
+		ERR_clear_error();
+
+		if (settings->format == FORMAT_TEXT) {
+			job->bp = BIO_new(BIO_s_mem());
+		}
+
+		pool_submit(scan->pool, scan_task, job);
+	}
+
+on_release:
+	/**
+	 * A series holds on to its slot until the last repeat.
+	 */
+	if (!is_null(series) && !last) {
+		ev_timer_start(scan->loop, &series->timer, (uint64_t) settings->interval * NSEC_PER_MSEC);
+		return;
+	}
+
+	scan->inflight -= 1;
+
+	if (!is_null(next)) {
+		scan->inflight += 1;
+		probe_start(next);
+	}
+}
+
+/**
+ * Probe progress callback.
+ */
+static void scan_note (probe_t *probe, int note) {
+	scan_t *scan = probe->arg;
+
+	if (note == PROBE_NOTE_COMPLETE) {
+		scan_complete(scan, probe);
+		return;
+	}
+
+	if (note == PROBE_NOTE_RESUME) {
+		if (!is_null(scan->metrics)) {
+			metrics_started(scan->metrics);
+		}
+
+		return;
+	}
+
+	if (!scan->progress || probe->rounds.round > 0
+	    || (!is_null(probe->chain) && ((series_t *) probe->chain)->done > 0)) {
+		return;
+	}
+
+	switch (note) {
+		case PROBE_NOTE_CONNECT:
+			scan_print(
+				scan,
+				scan->bp,
+				scan_since(scan, probe),
+				KEUKA_OUTBOUND_INDICATOR,
+				"Establishing connection to %s.\n",
+				probe->target.name
+			);
+			break;
+		case PROBE_NOTE_CONNECTED:
+			scan_print(
+				scan,
+				scan->bp,
+				scan_since(scan, probe),
+				KEUKA_INBOUND_INDICATOR,
+				"Connection established.\n"
+			);
+			break;
+		case PROBE_NOTE_ATTACH:
+			scan_print(
+				scan,
+				scan->bp,
+				scan_since(scan, probe),
+				KEUKA_NEUTRAL_INDICATOR,
+				"Attaching SSL session to socket.\n"
+			);
+			break;
+		case PROBE_NOTE_HANDSHAKE:
+			scan_print(
+				scan,
+				scan->bp,
+				scan_since(scan, probe),
+				KEUKA_OUTBOUND_INDICATOR,
+				"SSL session attached, handshake initiated.\n"
+			);
+			break;
+		default:
+			break;
+	}
+}
+
+/**
+ * Report result of target from the store, in
+ * place of probing it. Binary streams only carry
+ * probes, so cached results are left out of them.
+ */
+static void scan_cached (scan_t *scan, const target_t *target, const store_slot_t *slot) {
+	char fingerprint[CERT_FINGERPRINT_LENGTH + NULL_BYTE];
+	char stamp[32];
+	time_t checked;
+	struct tm tm;
+	output_t *output;
+	buf_t *buf;
+	settings_t *settings = scan->settings;
+
+	if (settings->format == FORMAT_BIN) {
+		return;
+	}
+
+	cert_hex(slot->leaf, fingerprint);
+	output = scan_output(scan);
+	buf = output->buf;
+
+	if (settings->format == FORMAT_NDJSON) {
+		checked = (time_t) slot->checked;
+		gmtime_r(&checked, &tm);
+		strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", &tm);
+
+		buf_puts(buf, "{\"host\":");
+		buf_json(buf, target->host, strlen(target->host));
+		buf_printf(
+			buf,
+			",\"port\":%d,\"status\":\"cached\",\"checked\":\"%s\",\"method\":",
+			target->port,
+			stamp
+		);
+		buf_json(buf, slot->method, strlen(slot->method));
+		buf_puts(buf, ",\"cipher\":");
+		buf_json(buf, slot->cipher, strlen(slot->cipher));
+		buf_printf(buf, ",\"sha256\":\"%s\"}\n", fingerprint);
+	} else {
+		if (!is_null(settings->targets)) {
+			buf_printf(buf, "--- Host: %s\n", target->name);
+		}
+
+		buf_printf(buf, "--- Cached: checked %llds ago\n", (long long) (time(NULL) - slot->checked));
+
+		if (settings->cipher) {
+			buf_printf(buf, "--- Cipher: %s\n", slot->cipher);
+		}
+
+		if (settings->method) {
+			buf_printf(buf, "--- Method: %s\n", slot->method);
+		}
+
+		if (settings->chain) {
+			buf_printf(buf, "--- SHA-256: %s\n", fingerprint);
+		}
+
+		if (!is_null(settings->targets) && !settings->quiet) {
+			buf_puts(buf, "\n");
+		}
+	}
+
+	if (!is_null(scan->pool)) {
+		pthread_mutex_lock(&scan->lock);
+	}
+
+	if (settings->format == FORMAT_TEXT) {
+		BIO_write(scan->bp, buf->data, (int) buf->len);
+	} else {
+		buf_write(buf, STDOUT_FILENO);
+	}
+
+	scan_release(scan, output);
+
+	if (!is_null(scan->pool)) {
+		pthread_mutex_unlock(&scan->lock);
+	}
+}
+
+/**
+ * Whether another probe may be started, per the
+ * in-flight limit, or the throttle if there is one.
+ */
+static int scan_room (scan_t *scan) {
+	if (!is_null(scan->throttle)) {
+		return throttle_room(scan->throttle, scan->inflight);
+	}
+
+	return scan->inflight < scan->limit;
+}
+
+/**
+ * Start probes until the in-flight limit
+ * is reached or the target list runs out.
+ * Targets with a fresh enough result in the
+ * store are reported from there instead.
+ * Under --watch, targets are taken from the
+ * queue of those due for a check instead.
+ * Probes held back by the throttle that now
+ * have room go ahead of any new ones.
+ */
+static void scan_fill (scan_t *scan) {
+	unsigned char key[STORE_KEY_LENGTH];
+	target_t target;
+	probe_t *probe;
+	store_slot_t *slot;
+	watch_entry_t *entry = NULL;
+	settings_t *settings = scan->settings;
+
+	if (!is_null(scan->throttle)) {
+		throttle_pump(scan->throttle);
+	}
+
+	while (!scan->eof && scan_room(scan)) {
+		if (!is_null(scan->watch)) {
+			if (scan_stopped) {
+				break;
+			}
+
+			entry = watch_next(scan->watch);
+
+			if (is_null(entry)) {
+				break;
+			}
+
+			target = entry->target;
+		} else if (!target_next(scan->list, &target)) {
+			scan->eof = 1;
+			break;
+		}
+
+		if (!is_null(scan->store) && settings->cache_ttl) {
+			store_key(key, &target, settings->no_sni);
+			slot = store_find(scan->store, key);
+
+			if (!is_null(slot) && time(NULL) - slot->checked < settings->cache_ttl) {
+				scan->completed += 1;
+
+				if (!is_null(scan->metrics)) {
+					metrics_cached(scan->metrics);
+				}
+
+				scan_cached(scan, &target, slot);
+				continue;
+			}
+		}
+
+		probe = scan_probe(scan, &target);
+		probe->entry = entry;
+
+		if (scan->settings->count > 1) {
+			probe->chain = scan_series(scan, &target);
+		}
+
+		scan->inflight += 1;
+		probe_start(probe);
+	}
+}
+
+/**
+ * Probe all targets in list, sharing one SSL context
+ * and event loop. Returns EXIT_FAILURE if any failed.
+ */
+int scan_run (settings_t *settings, target_list_t *list, BIO *bp) {
+	int status = EXIT_FAILURE;
+	target_t target;
+	scan_t scan;
+	output_t *output;
+
+	memset(&scan, 0, sizeof(scan));
+	scan.settings = settings;
+	scan.list = list;
+	scan.bp = bp;
+	scan.progress = (!settings->quiet && is_null(settings->targets) && !settings->watch && settings->format == FORMAT_TEXT);
+	scan.limit = is_null(settings->targets) ? 1 : settings->concurrency;
+
+	sock_rlimit(scan.limit);
+
+	if (!is_null(settings->connect)) {
+		if (is_error(target_parse(&target, settings->connect), -1)
+		    || is_error(resolve_literal(target.host, &scan.addr), -1)) {
+			fprintf(stderr, "Error: Invalid address %s.\n", settings->connect);
+			goto on_error;
+		}
+
+		scan.port = target.port;
+	}
+
+	/**
+	 * Start execution clock.
+	 */
+	scan.start = clock_now();
+
+	if (scan.progress) {
+		scan_print(&scan, bp, scan.start, KEUKA_NEUTRAL_INDICATOR, "Establishing SSL context.\n");
+	}
+
+	/**
+	 * Establish new SSL context, shared by all probes.
+	 */
+	scan.ctx = SSL_CTX_new(SSLv23_client_method());
+
+	if (is_null(scan.ctx)) {
+		scan_print(&scan, bp, scan.start, KEUKA_NEUTRAL_INDICATOR, "Error: Unable to establish SSL context.\n");
+		ERR_print_errors(bp);
+		goto on_error;
+	}
+
+	if (scan.progress) {
+		scan_print(&scan, bp, scan.start, KEUKA_NEUTRAL_INDICATOR, "SSL context established.\n");
+	}
+
+	trace_event("ssl_context", "scan", scan.start, clock_now(), NULL);
+
+	/**
+	 * Trust store for --verify, loaded once up front
+	 * and shared by every probe, along with the outcomes
+	 * of the chains verified against it.
+	 */
+	if (settings->verify) {
+		scan.verify = verify_new(settings->ca_file);
+
+		if (is_null(scan.verify)) {
+			fprintf(stderr, "Error: Unable to load trust store %s.\n", settings->ca_file ? settings->ca_file : X509_get_default_cert_file());
+			goto on_error;
+		}
+	}
+
+	/**
+	 * Keep sessions issued to each probe, so they
+	 * can be offered again if --resume was given.
+	 */
+	if (settings->resume) {
+		SSL_CTX_set_session_cache_mode(
+			scan.ctx,
+			SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE
+		);
+		SSL_CTX_sess_set_new_cb(scan.ctx, probe_session);
+	}
+
+	/**
+	 * Stop each handshake once the chain has arrived,
+	 * if --cert-only was given.
+	 */
+	if (settings->cert_only) {
+		SSL_CTX_set_cert_verify_callback(scan.ctx, probe_certificate, NULL);
+	}
+
+	scan.loop = ev_new();
+
+	if (is_null(scan.loop)) {
+		scan_print(&scan, bp, scan.start, KEUKA_NEUTRAL_INDICATOR, "Error: Unable to create event loop.\n");
+		goto on_error;
+	}
+
+	/**
+	 * Shared resolver, so hosts in the same domain
+	 * are looked up once and then served from cache.
+	 */
+	scan.resolver = resolver_new(scan.loop, settings->resolver);
+
+	if (is_null(scan.resolver)) {
+		fprintf(stderr, "Error: Unable to use resolver %s.\n", settings->resolver ? settings->resolver : RESOLV_CONF);
+		goto on_error;
+	}
+
+	/**
+	 * Counters and histograms of the scan, exposed for
+	 * Prometheus, if --metrics-file or --metrics-port.
+	 */
+	if (!is_null(settings->metrics_file) || settings->metrics_port) {
+		scan.metrics = metrics_new(scan.loop, settings->metrics_file, settings->metrics_port);
+
+		if (is_null(scan.metrics)) {
+			fprintf(stderr, "Error: Unable to listen on metrics port %d.\n", settings->metrics_port);
+			goto on_error;
+		}
+	}
+
+	/**
+	 * Results are kept in the store across runs, so
+	 * hosts checked recently enough can be skipped.
+	 */
+	if (!is_null(settings->cache)) {
+		scan.store = store_open(settings->cache, 0);
+
+		if (is_null(scan.store)) {
+			if (errno == EWOULDBLOCK) {
+				fprintf(stderr, "Error: Cache %s is in use by another run.\n", settings->cache);
+			} else {
+				fprintf(stderr, "Error: Unable to open cache %s.\n", settings->cache);
+			}
+
+			goto on_error;
+		}
+	}
+
+	/**
+	 * Snapshot of an earlier run to compare results to.
+	 * If it's the store itself (by any path), results
+	 * are compared before they're put in it.
+	 */
+	if (!is_null(settings->since)) {
+		if (!is_null(scan.store) && store_same(scan.store, settings->since)) {
+			scan.snapshot = scan.store;
+		} else {
+			scan.snapshot = store_open(settings->since, 1);
+		}
+
+		if (is_null(scan.snapshot)) {
+			if (errno == EWOULDBLOCK) {
+				fprintf(stderr, "Error: Snapshot %s is in use by another run.\n", settings->since);
+			} else {
+				fprintf(stderr, "Error: Unable to open snapshot %s.\n", settings->since);
+			}
+
+			goto on_error;
+		}
+	}
+
+	/**
+	 * Keep checking every target under --watch, on a
+	 * schedule of its own, until told to stop. The SSL
+	 * context, loop and resolver (and its cache) stay
+	 * warm from one check to the next.
+	 */
+	if (settings->watch) {
+		scan.watch = watch_new(scan.loop, list, scan.store, settings->no_sni);
+
+		if (is_null(scan.watch)) {
+			fprintf(stderr, "Error: No targets to watch.\n");
+			goto on_error;
+		}
+
+		signal(SIGINT, scan_stop);
+		signal(SIGTERM, scan_stop);
+	}
+
+	/**
+	 * Pace and spread out connections, if --rate,
+	 * --per-ip, --per-prefix or --adaptive was given.
+	 */
+	if (settings->rate || settings->per_ip || settings->per_prefix || settings->adaptive) {
+		scan.throttle = throttle_new(scan.loop, scan.limit, settings->per_ip, settings->per_prefix, settings->rate, settings->adaptive);
+	}
+
+	/**
+	 * Render reports of a batch on a pool of worker
+	 * threads, so the I/O thread keeps sockets moving.
+	 */
+	if (!is_null(settings->targets)) {
+		pthread_mutex_init(&scan.lock, NULL);
+		scan.pool = pool_new((int) sysconf(_SC_NPROCESSORS_ONLN), scan.limit);
+	}
+
+	/**
+	 * Binary streams start with a header, then refer to
+	 * each certificate by index once it's been written.
+	 */
+	if (settings->format == FORMAT_BIN) {
+		scan.certs = record_certs_new();
+		output = scan_output(&scan);
+		record_header(output->buf);
+		buf_write(output->buf, STDOUT_FILENO);
+		scan_release(&scan, output);
+	}
+
+	/**
+	 * Certificates shared by hosts in a batch are only
+	 * rendered once, and written out in full once.
+	 */
+	if (!is_null(settings->targets) && (settings->format == FORMAT_NDJSON
+	    || (settings->format == FORMAT_TEXT && settings->chain))) {
+		scan.cache = cert_cache_new(
+			(settings->format == FORMAT_TEXT)
+			? "--- SHA-256: %s (repeated)"
+			: ",\"sha256\":\"%s\"}"
+		);
+	}
+
+	scan_fill(&scan);
+
+	while (scan.inflight > 0 || (!is_null(scan.watch) && !scan_stopped)) {
+		if (is_error(ev_wait(scan.loop, -1), -1)) {
+			break;
+		}
+
+		scan_fill(&scan);
+	}
+
+	if (!is_null(scan.pool)) {
+		pool_wait(scan.pool);
+		pool_free(scan.pool);
+		pthread_mutex_destroy(&scan.lock);
+	}
+
+	while (!is_null(scan.outputs)) {
+		output = scan.outputs;
+		scan.outputs = output->next;
+		buf_free(output->buf);
+		buf_free(output->expanded);
+		BIO_free(output->scratch);
+		FREE(output);
+	}
+
+	/**
+	 * Say where --adaptive left the window, and
+	 * how often it had to back off to get there.
+	 */
+	if (settings->adaptive && !settings->quiet && settings->format == FORMAT_TEXT) {
+		BIO_printf(
+			bp,
+			"--- Backoff: %d of %d in flight, halved %ld times\n",
+			(int) scan.throttle->window,
+			scan.limit,
+			scan.throttle->cuts
+		);
+	}
+
+	status = (scan.failed > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+
+	/**
+	 * Reached once the scan is done, too, with status
+	 * set. Whatever wasn't set up yet is still NULL.
+	 */
+on_error:
+	watch_free(scan.watch);
+	record_certs_free(scan.certs);
+	cert_cache_free(scan.cache);
+
+	if (scan.snapshot != scan.store) {
+		store_close(scan.snapshot);
+	}
+
+	store_close(scan.store);
+	throttle_free(scan.throttle);
+	metrics_free(scan.metrics);
+	verify_free(scan.verify);
+	resolver_free(scan.resolver);
+	ev_free(scan.loop);
+	SSL_CTX_free(scan.ctx);
+
+	return status;
+}
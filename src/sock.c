@@ -7,86 +7,129 @@
 #include "sock.h"
 
 /**
- * Create TCP socket.
+ * Create non-blocking TCP socket and initiate connection.
+ * Returns the socket, with the connection either established
+ * or in progress (see sock_error), or -1 on failure.
  */
-int mksock (char *url, BIO *bp) {
-	int sockfd, port, status;
-	char hostname[256] = "";
-	char port_num[6] = "443";
-	char protocol[6] = "";
-	char *tmp_ptr = NULL;
-	struct hostent *host;
-	struct sockaddr_in dest_addr;
+int sock_connect (const struct sockaddr *addr, socklen_t addrlen) {
+	int sockfd, flags, status;
 
 	/**
-	 * Remove trailing slash, if applicable.
+	 * Set TCP socket.
 	 */
-	if (url[strlen(url)] == '/') {
-		url[strlen(url)] = '\0';
-	}
+	sockfd = socket(addr->sa_family, SOCK_STREAM, 0);
 
-	/**
-	 * Protocol type (e.g. https).
-	 */
-	strncpy(protocol, url, (strchr(url, ':') - url));
+	if (is_error(sockfd, -1)) {
+		return -1;
+	}
 
-	/**
-	 * Hostname (e.g. www.example.com)
-	 */
-	strncpy(hostname, strstr(url, "://") + 3, sizeof(hostname));
+	flags = fcntl(sockfd, F_GETFL, 0);
 
-	/**
-	 * Port (if applicable).
-	 */
-	if (strchr(hostname, ':')) {
-		tmp_ptr = strchr(hostname, ':');
-		strncpy(port_num, tmp_ptr + NULL_BYTE,  sizeof(port_num));
-		*tmp_ptr = '\0';
+	if (is_error(flags, -1) || is_error(fcntl(sockfd, F_SETFL, flags | O_NONBLOCK), -1)) {
+		close(sockfd);
+		return -1;
 	}
 
-	port = atoi(port_num);
+	status = connect(sockfd, addr, addrlen);
 
 	/**
-	 * Verify the hostname is resolvable.
+	 * Return error if we're not able to connect.
 	 */
-	if (is_null(gethostbyname(hostname))) {
+	if (is_error(status, -1) && errno != EINPROGRESS) {
+		status = errno;
+		close(sockfd);
+		errno = status;
 		return -1;
 	}
 
-	host = gethostbyname(hostname);
+	return sockfd;
+}
+
+/**
+ * Get pending error on socket, e.g. the outcome
+ * of a non-blocking connect. Returns 0 if none.
+ */
+int sock_error (int sockfd) {
+	int error;
+	socklen_t len;
+
+	error = 0;
+	len = sizeof(error);
+
+	if (is_error(getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &error, &len), -1)) {
+		return errno;
+	}
+
+	return error;
+}
+
+/**
+ * Format socket address as a printable string.
+ */
+const char *sock_ntop (const struct sockaddr *addr, char *buf, size_t size) {
+	const void *src;
+
+	if (addr->sa_family == AF_INET6) {
+		src = &((const struct sockaddr_in6 *) addr)->sin6_addr;
+	} else {
+		src = &((const struct sockaddr_in *) addr)->sin_addr;
+	}
+
+	if (is_null((void *) inet_ntop(addr->sa_family, src, buf, size))) {
+		copy(buf, "?");
+	}
+
+	return buf;
+}
+
+/**
+ * Raise the open file limit so the in-flight
+ * limit isn't capped by descriptor exhaustion.
+ */
+void sock_rlimit (int limit) {
+	struct rlimit rl;
+	rlim_t want;
+
+	want = (rlim_t) limit + 64;
+
+	if (getrlimit(RLIMIT_NOFILE, &rl) != 0 || rl.rlim_cur >= want) {
+		return;
+	}
+
+	rl.rlim_cur = (rl.rlim_max < want) ? rl.rlim_max : want;
+	setrlimit(RLIMIT_NOFILE, &rl);
+}
+
+/**
+ * Create non-blocking TCP socket listening on
+ * the loopback address, on port. Returns the
+ * socket, or -1 on failure.
+ */
+int sock_listen (int port) {
+	int sockfd, flags, reuse;
+	struct sockaddr_in addr;
 
-	/**
-	 * Set TCP socket.
-	 */
 	sockfd = socket(AF_INET, SOCK_STREAM, 0);
 
-	dest_addr.sin_family = AF_INET;
-	dest_addr.sin_port = htons(port);
-	dest_addr.sin_addr.s_addr = *(long*)(host->h_addr);
+	if (is_error(sockfd, -1)) {
+		return -1;
+	}
 
-	/**
-	 * Initialize the rest of the struct.
-	 */
-	memset(&(dest_addr.sin_zero), '\0', 8);
-	tmp_ptr = inet_ntoa(dest_addr.sin_addr);
+	reuse = 1;
+	setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
 
-	status = connect(
-		sockfd,
-		(struct sockaddr*) &dest_addr,
-		sizeof(struct sockaddr)
-	);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons((uint16_t) port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
 
-	/**
-	 * Return error if we're not able to connect.
-	 */
-	if (is_error(status, -1)) {
-		BIO_printf(
-			bp,
-			"Error: Cannot connect to host %s [%s] on port %d.\n",
-			hostname,
-			tmp_ptr,
-			port
-		);
+	flags = fcntl(sockfd, F_GETFL, 0);
+
+	if (is_error(flags, -1)
+	    || is_error(fcntl(sockfd, F_SETFL, flags | O_NONBLOCK), -1)
+	    || is_error(bind(sockfd, (struct sockaddr *) &addr, sizeof(addr)), -1)
+	    || is_error(listen(sockfd, SOMAXCONN), -1)) {
+		close(sockfd);
 		return -1;
 	}
 
@@ -0,0 +1,348 @@
+/**
+ * store.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "store.h"
+
+static const char *store_changes[NUM_STORE_CHANGES] = {
+	"new_host",
+	"certificate",
+	"issuer",
+	"chain",
+	"downgrade",
+	"upgrade",
+	"cipher",
+	"unreachable",
+	"recovered",
+};
+
+/**
+ * Map size bytes of the store file, growing
+ * the file first if it's not that large yet.
+ */
+static int store_map (store_t *store, size_t size) {
+	void *map;
+
+	if (!store->readonly && is_error(ftruncate(store->fd, (off_t) size), -1)) {
+		return -1;
+	}
+
+	map = mmap(NULL, size, store->readonly ? PROT_READ : PROT_READ | PROT_WRITE, MAP_SHARED, store->fd, 0);
+
+	if (map == MAP_FAILED) {
+		return -1;
+	}
+
+	store->size = size;
+	store->header = map;
+	store->slots = (store_slot_t *) ((char *) map + sizeof(store_header_t));
+
+	return 0;
+}
+
+static size_t store_size (uint32_t nslots) {
+	return sizeof(store_header_t) + ((size_t) nslots * sizeof(store_slot_t));
+}
+
+/**
+ * Slot key is stored in, or the empty slot it would go in.
+ */
+static store_slot_t *store_slot (store_t *store, const unsigned char *key) {
+	uint32_t index, mask;
+	store_slot_t *slot;
+
+	mask = store->header->nslots - 1;
+	memcpy(&index, key, sizeof(index));
+	index &= mask;
+
+	while (1) {
+		slot = &store->slots[index];
+
+		if (!slot->checked || !memcmp(slot->key, key, STORE_KEY_LENGTH)) {
+			return slot;
+		}
+
+		index = (index + 1) & mask;
+	}
+}
+
+/**
+ * Double the number of slots once they're 70% full,
+ * rehashing through a copy of the current slots.
+ */
+static int store_grow (store_t *store) {
+	uint32_t index, nslots;
+	store_slot_t *slots;
+
+	nslots = store->header->nslots;
+
+	if (store->header->count * 10 < (uint64_t) nslots * 7) {
+		return 0;
+	}
+
+	slots = ALLOC((long) nslots * (long) sizeof(store_slot_t));
+	memcpy(slots, store->slots, (size_t) nslots * sizeof(store_slot_t));
+	munmap(store->header, store->size);
+
+	if (is_error(store_map(store, store_size(nslots * 2)), -1)) {
+		FREE(slots);
+		return -1;
+	}
+
+	store->header->nslots = nslots * 2;
+	memset(store->slots, 0, (size_t) nslots * 2 * sizeof(store_slot_t));
+
+	for (index = 0; index < nslots; index += 1) {
+		if (slots[index].checked) {
+			*store_slot(store, slots[index].key) = slots[index];
+		}
+	}
+
+	FREE(slots);
+
+	return 0;
+}
+
+/**
+ * Open store at path, creating it if need be, unless
+ * it's opened readonly (as a snapshot to compare to).
+ * Returns NULL if it can't be opened or isn't a store,
+ * with errno EWOULDBLOCK if another run has it locked.
+ */
+store_t *store_open (const char *path, int readonly) {
+	struct stat st;
+	store_t *store;
+
+	NEW0(store);
+	store->readonly = readonly;
+	store->fd = readonly ? open(path, O_RDONLY) : open(path, O_RDWR | O_CREAT, 0644);
+
+	if (is_error(store->fd, -1)) {
+		FREE(store);
+		return NULL;
+	}
+
+	if (is_error(flock(store->fd, (readonly ? LOCK_SH : LOCK_EX) | LOCK_NB), -1)
+	    || is_error(fstat(store->fd, &st), -1)) {
+		goto on_error;
+	}
+
+	if (st.st_size == 0 && !readonly) {
+		if (is_error(store_map(store, store_size(STORE_SLOTS)), -1)) {
+			goto on_error;
+		}
+
+		memcpy(store->header->magic, STORE_MAGIC, STORE_MAGIC_LENGTH);
+		store->header->version = STORE_VERSION;
+		store->header->nslots = STORE_SLOTS;
+		store->header->count = 0;
+
+		return store;
+	}
+
+	if ((size_t) st.st_size < sizeof(store_header_t)
+	    || is_error(store_map(store, (size_t) st.st_size), -1)) {
+		goto on_error;
+	}
+
+	if (memcmp(store->header->magic, STORE_MAGIC, STORE_MAGIC_LENGTH)
+	    || store->header->version != STORE_VERSION
+	    || store_size(store->header->nslots) != (size_t) st.st_size
+	    || (store->header->nslots & (store->header->nslots - 1))) {
+		munmap(store->header, store->size);
+		goto on_error;
+	}
+
+	return store;
+
+on_error:
+	close(store->fd);
+	FREE(store);
+
+	return NULL;
+}
+
+/**
+ * Whether path is the file store is mapped from,
+ * by device and inode rather than by name.
+ */
+int store_same (store_t *store, const char *path) {
+	struct stat a, b;
+
+	if (is_error(fstat(store->fd, &a), -1) || is_error(stat(path, &b), -1)) {
+		return 0;
+	}
+
+	return a.st_dev == b.st_dev && a.st_ino == b.st_ino;
+}
+
+void store_close (store_t *store) {
+	if (is_null(store)) {
+		return;
+	}
+
+	if (!store->readonly) {
+		msync(store->header, store->size, MS_SYNC);
+	}
+
+	munmap(store->header, store->size);
+	close(store->fd);
+	FREE(store);
+}
+
+/**
+ * Key of target in the store, which covers the name
+ * sent as SNI, since it may select another chain.
+ */
+void store_key (unsigned char *key, const target_t *target, int no_sni) {
+	char name[STORE_MAX_KEY];
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+
+	snprintf(
+		name,
+		sizeof(name),
+		"%s:%d:%s",
+		target->host,
+		target->port,
+		no_sni ? "" : target->host
+	);
+
+	SHA256((const unsigned char *) name, strlen(name), digest);
+	memcpy(key, digest, STORE_KEY_LENGTH);
+}
+
+/**
+ * Slot of key, or NULL if there's no result for it.
+ */
+store_slot_t *store_find (store_t *store, const unsigned char *key) {
+	store_slot_t *slot = store_slot(store, key);
+
+	return slot->checked ? slot : NULL;
+}
+
+/**
+ * Slot of key, taking an empty one if need be.
+ * Returns NULL if the store couldn't grow.
+ */
+store_slot_t *store_put (store_t *store, const unsigned char *key) {
+	store_slot_t *slot;
+
+	if (is_error(store_grow(store), -1)) {
+		return NULL;
+	}
+
+	slot = store_slot(store, key);
+
+	if (!slot->checked) {
+		memcpy(slot->key, key, STORE_KEY_LENGTH);
+		store->header->count += 1;
+	}
+
+	return slot;
+}
+
+/**
+ * Record result of an established session in slot:
+ * negotiated parameters, the fingerprint of the leaf
+ * certificate and of the chain as a whole (the digest
+ * of the fingerprints of its certificates, in order),
+ * plus the leaf's issuer and expiry, stamped now.
+ */
+void store_fill (store_slot_t *slot, SSL *ssl) {
+	int index;
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	char fingerprint[CERT_FINGERPRINT_LENGTH + NULL_BYTE];
+	STACK_OF(X509) *chain;
+	EVP_MD_CTX *md;
+	X509 *crt;
+	struct tm tm;
+
+	snprintf(slot->method, sizeof(slot->method), "%s", SSL_get_version(ssl));
+	snprintf(slot->cipher, sizeof(slot->cipher), "%s", SSL_CIPHER_get_name(probe_cipher(ssl)));
+	slot->version = (uint16_t) SSL_version(ssl);
+	slot->chainlen = 0;
+	slot->issuer = 0;
+	slot->not_after = 0;
+	memset(slot->leaf, 0, sizeof(slot->leaf));
+	memset(slot->chain, 0, sizeof(slot->chain));
+
+	chain = probe_chain(ssl);
+
+	md = EVP_MD_CTX_new();
+
+	if (!is_null(chain) && !is_null(md) && EVP_DigestInit_ex(md, EVP_sha256(), NULL)) {
+		for (index = 0; index < sk_X509_num(chain); index += 1) {
+			crt = sk_X509_value(chain, index);
+
+			if (is_error(cert_digest(crt, digest, fingerprint), -1)) {
+				continue;
+			}
+
+			if (index == 0) {
+				memcpy(slot->leaf, digest, sizeof(slot->leaf));
+				slot->issuer = (uint32_t) X509_NAME_hash(X509_get_issuer_name(crt));
+
+				if (ASN1_TIME_to_tm(X509_get0_notAfter(crt), &tm)) {
+					slot->not_after = (int64_t) timegm(&tm);
+				}
+			}
+
+			EVP_DigestUpdate(md, digest, sizeof(digest));
+			slot->chainlen += 1;
+		}
+
+		EVP_DigestFinal_ex(md, slot->chain, NULL);
+	}
+
+	EVP_MD_CTX_free(md);
+
+	slot->checked = (int64_t) time(NULL);
+}
+
+/**
+ * Changes from the previous result (NULL if there
+ * wasn't one) to the current one (NULL if the probe
+ * failed), as a mask of STORE_* bits.
+ */
+int store_diff (const store_slot_t *previous, const store_slot_t *current) {
+	int changes = 0;
+
+	if (is_null((void *) previous)) {
+		return is_null((void *) current) ? 0 : STORE_NEW_HOST;
+	}
+
+	if (is_null((void *) current)) {
+		return STORE_UNREACHABLE;
+	}
+
+	if (memcmp(previous->leaf, current->leaf, sizeof(current->leaf))) {
+		changes |= STORE_NEW_CERT;
+	} else if (memcmp(previous->chain, current->chain, sizeof(current->chain))) {
+		changes |= STORE_NEW_CHAIN;
+	}
+
+	if (previous->issuer != current->issuer) {
+		changes |= STORE_NEW_ISSUER;
+	}
+
+	if (current->version < previous->version) {
+		changes |= STORE_DOWNGRADE;
+	} else if (current->version > previous->version) {
+		changes |= STORE_UPGRADE;
+	}
+
+	if (strncmp(previous->cipher, current->cipher, sizeof(current->cipher))) {
+		changes |= STORE_NEW_CIPHER;
+	}
+
+	return changes;
+}
+
+/**
+ * Name of a single change bit.
+ */
+const char *store_change_name (int change) {
+	return store_changes[__builtin_ctz((unsigned int) change)];
+}
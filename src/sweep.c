@@ -0,0 +1,449 @@
+/**
+ * sweep.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "sweep.h"
+
+static void sweep_note(probe_t *, int);
+
+/**
+ * Copy of str, allocated on the heap.
+ */
+static char *sweep_strdup (const char *str, size_t len) {
+	char *dup;
+
+	dup = ALLOC((long) len + NULL_BYTE);
+	memcpy(dup, str, len);
+	dup[len] = '\0';
+
+	return dup;
+}
+
+static int sweep_bucket (const sweep_t *sweep, const unsigned char *digest) {
+	uint64_t hash;
+
+	memcpy(&hash, digest, sizeof(hash));
+
+	return (int) (hash & (uint64_t) (sweep->nbuckets - 1));
+}
+
+/**
+ * Double the number of buckets once there
+ * are more certificate groups than buckets.
+ */
+static void sweep_grow (sweep_t *sweep) {
+	int index, nbuckets;
+	sweep_group_t **buckets, *group, *next;
+
+	if (sweep->certs < sweep->nbuckets) {
+		return;
+	}
+
+	buckets = sweep->buckets;
+	nbuckets = sweep->nbuckets;
+	sweep->nbuckets = nbuckets * 2;
+	sweep->buckets = CALLOC(sweep->nbuckets, (long) sizeof(sweep_group_t *));
+
+	for (index = 0; index < nbuckets; index += 1) {
+		for (group = buckets[index]; !is_null(group); group = next) {
+			next = group->bucket_next;
+			group->bucket_next = sweep->buckets[sweep_bucket(sweep, group->digest)];
+			sweep->buckets[sweep_bucket(sweep, group->digest)] = group;
+		}
+	}
+
+	FREE(buckets);
+}
+
+/**
+ * Group for leaf certificate crt (or error, if crt
+ * is NULL), created the first time it comes up.
+ */
+static sweep_group_t *sweep_group (sweep_t *sweep, X509 *crt, probe_error_t error) {
+	char *data;
+	long len;
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	BIO *scratch;
+	sweep_group_t *group;
+
+	if (!is_null(crt) && !X509_digest(crt, EVP_sha256(), digest, NULL)) {
+		crt = NULL;
+		error = PROBE_ERR_HANDSHAKE;
+	}
+
+	if (is_null(crt)) {
+		group = sweep->errors[error];
+	} else {
+		group = sweep->buckets[sweep_bucket(sweep, digest)];
+
+		while (!is_null(group) && memcmp(group->digest, digest, SHA256_DIGEST_LENGTH)) {
+			group = group->bucket_next;
+		}
+	}
+
+	if (!is_null(group)) {
+		return group;
+	}
+
+	NEW0(group);
+	group->order = sweep->ngroups++;
+	group->error = error;
+	group->next = sweep->groups;
+	sweep->groups = group;
+
+	if (is_null(crt)) {
+		sweep->errors[error] = group;
+		return group;
+	}
+
+	sweep_grow(sweep);
+	memcpy(group->digest, digest, SHA256_DIGEST_LENGTH);
+	group->bucket_next = sweep->buckets[sweep_bucket(sweep, digest)];
+	sweep->buckets[sweep_bucket(sweep, digest)] = group;
+	cert_hex(digest, group->fingerprint);
+	sweep->certs += 1;
+
+	scratch = BIO_new(BIO_s_mem());
+	X509_NAME_print_ex(scratch, X509_get_subject_name(crt), 0, XN_FLAG_RFC2253);
+	len = BIO_get_mem_data(scratch, &data);
+	group->subject = sweep_strdup(data, (size_t) len);
+	BIO_free(scratch);
+
+	return group;
+}
+
+/**
+ * Start probe for the next server name in the list,
+ * keeping a place for it, in the order of the list.
+ */
+static int sweep_start (sweep_t *sweep) {
+	target_t target;
+	probe_t *probe;
+	sweep_name_t *name;
+	settings_t *settings = sweep->settings;
+
+	if (!target_next(sweep->list, &target)) {
+		return 0;
+	}
+
+	if (sweep->nnames == sweep->size) {
+		sweep->size *= 2;
+		RESIZE(sweep->names, (long) sweep->size * (long) sizeof(sweep_name_t *));
+	}
+
+	NEW0(name);
+	name->sweep = sweep;
+	name->name = sweep_strdup(target.host, strlen(target.host));
+	sweep->names[sweep->nnames++] = name;
+
+	/**
+	 * Every name goes to the same address and port,
+	 * whatever port its line of the list might give.
+	 */
+	target.port = sweep->port;
+
+	probe = probe_new(&target, sweep->ctx, sweep->loop, NULL);
+	probe->pinned = &sweep->addr;
+	probe->connect_timeout = settings->connect_timeout;
+	probe->handshake_timeout = settings->handshake_timeout;
+	probe->deadline = settings->deadline;
+	probe->cert_only = settings->cert_only;
+	probe->notify = sweep_note;
+	probe->arg = name;
+
+	sweep->inflight += 1;
+	probe_start(probe);
+
+	return 1;
+}
+
+/**
+ * Start probes until the in-flight limit is reached.
+ */
+static void sweep_fill (sweep_t *sweep) {
+	while (!sweep->eof && sweep->inflight < sweep->limit) {
+		sweep->eof = !sweep_start(sweep);
+	}
+}
+
+/**
+ * Probe progress callback. Put the name in the group
+ * of the leaf certificate it got back, or of the
+ * error, and check it's a name the leaf is good for.
+ */
+static void sweep_note (probe_t *probe, int note) {
+	X509 *crt = NULL;
+	STACK_OF(X509) *chain;
+	sweep_name_t *name = probe->arg;
+	sweep_t *sweep = name->sweep;
+
+	if (note != PROBE_NOTE_COMPLETE) {
+		return;
+	}
+
+	if (probe->state == PROBE_DONE) {
+		chain = probe_chain(probe->ssl);
+
+		if (!is_null(chain) && sk_X509_num(chain) > 0) {
+			crt = sk_X509_value(chain, 0);
+		}
+	}
+
+	name->group = sweep_group(sweep, crt, is_null(crt) ? probe->error : PROBE_OK);
+	name->group->count += 1;
+
+	if (is_null(name->group->subject)) {
+		sweep->failed += 1;
+	} else {
+		name->mismatch = (X509_check_host(crt, name->name, 0, X509_CHECK_FLAG_NO_PARTIAL_WILDCARDS, NULL) != 1);
+	}
+
+	ERR_clear_error();
+	probe_free(probe);
+
+	sweep->inflight -= 1;
+}
+
+/**
+ * Order groups by number of names, most first, so
+ * names that went astray end up at the bottom.
+ * Failures go last, and ties keep their order.
+ */
+static int sweep_compare (const void *a, const void *b) {
+	const sweep_group_t *left = *(sweep_group_t * const *) a;
+	const sweep_group_t *right = *(sweep_group_t * const *) b;
+
+	if (is_null(left->subject) != is_null(right->subject)) {
+		return is_null(left->subject) ? 1 : -1;
+	}
+
+	if (left->count != right->count) {
+		return right->count - left->count;
+	}
+
+	return left->order - right->order;
+}
+
+/**
+ * Output group, as text.
+ */
+static void sweep_text (sweep_t *sweep, sweep_group_t *group) {
+	sweep_name_t *name;
+
+	if (is_null(group->subject)) {
+		BIO_printf(
+			sweep->bp,
+			"--- Failed: %s (%d name%s)\n",
+			probe_error_name(group->error),
+			group->count,
+			(group->count == 1) ? "" : "s"
+		);
+	} else {
+		BIO_printf(
+			sweep->bp,
+			"--- SHA-256: %s (%d name%s)\n",
+			group->fingerprint,
+			group->count,
+			(group->count == 1) ? "" : "s"
+		);
+		BIO_printf(sweep->bp, "--- Subject: %s\n", group->subject);
+	}
+
+	for (name = group->names; !is_null(name); name = name->next) {
+		BIO_printf(sweep->bp, "%4s%s%s\n", "", name->name, name->mismatch ? " (name mismatch)" : "");
+	}
+
+	if (!sweep->settings->quiet) {
+		BIO_printf(sweep->bp, "\n");
+	}
+}
+
+/**
+ * Output group, as a line of JSON.
+ */
+static void sweep_json (sweep_t *sweep, sweep_group_t *group) {
+	int first;
+	sweep_name_t *name;
+	buf_t *buf = sweep->buf;
+
+	buf_reset(buf);
+
+	if (is_null(group->subject)) {
+		buf_printf(buf, "{\"status\":\"error\",\"error\":\"%s\"", probe_error_name(group->error));
+	} else {
+		buf_printf(buf, "{\"status\":\"ok\",\"sha256\":\"%s\",\"subject\":", group->fingerprint);
+		buf_json(buf, group->subject, strlen(group->subject));
+	}
+
+	buf_printf(buf, ",\"count\":%d,\"names\":[", group->count);
+
+	for (name = group->names, first = 1; !is_null(name); name = name->next, first = 0) {
+		buf_puts(buf, first ? "" : ",");
+		buf_json(buf, name->name, strlen(name->name));
+	}
+
+	buf_puts(buf, "]");
+
+	if (!is_null(group->subject)) {
+		buf_puts(buf, ",\"mismatched\":[");
+
+		for (name = group->names, first = 1; !is_null(name); name = name->next) {
+			if (name->mismatch) {
+				buf_puts(buf, first ? "" : ",");
+				buf_json(buf, name->name, strlen(name->name));
+				first = 0;
+			}
+		}
+
+		buf_puts(buf, "]");
+	}
+
+	buf_puts(buf, "}\n");
+	buf_write(buf, STDOUT_FILENO);
+}
+
+/**
+ * Output every group, with its names in the order
+ * of the list, then release groups and names.
+ */
+static void sweep_report (sweep_t *sweep, uint64_t start) {
+	int index;
+	sweep_name_t *name;
+	sweep_group_t *group, **groups;
+	settings_t *settings = sweep->settings;
+
+	for (index = sweep->nnames - 1; index >= 0; index -= 1) {
+		name = sweep->names[index];
+
+		if (!is_null(name->group)) {
+			name->next = name->group->names;
+			name->group->names = name;
+		}
+	}
+
+	groups = CALLOC(sweep->ngroups ? sweep->ngroups : 1, (long) sizeof(sweep_group_t *));
+
+	for (group = sweep->groups, index = 0; !is_null(group); group = group->next) {
+		groups[index++] = group;
+	}
+
+	qsort(groups, (size_t) sweep->ngroups, sizeof(sweep_group_t *), sweep_compare);
+
+	if (settings->format == FORMAT_TEXT && !settings->quiet) {
+		BIO_printf(sweep->bp, "--- Connect: %s\n\n", settings->connect);
+	}
+
+	for (index = 0; index < sweep->ngroups; index += 1) {
+		if (settings->format == FORMAT_NDJSON) {
+			sweep_json(sweep, groups[index]);
+		} else {
+			sweep_text(sweep, groups[index]);
+		}
+	}
+
+	if (settings->format == FORMAT_TEXT && !settings->quiet) {
+		BIO_printf(
+			sweep->bp,
+			"--- Sweep: %d names, %d certificates, %ld failed in %fs\n",
+			sweep->nnames,
+			sweep->certs,
+			sweep->failed,
+			get_elapsed_time(start)
+		);
+	}
+
+	for (index = 0; index < sweep->ngroups; index += 1) {
+		FREE(groups[index]->subject);
+		FREE(groups[index]);
+	}
+
+	for (index = 0; index < sweep->nnames; index += 1) {
+		FREE(sweep->names[index]->name);
+		FREE(sweep->names[index]);
+	}
+
+	FREE(groups);
+	FREE(sweep->buckets);
+	FREE(sweep->names);
+}
+
+/**
+ * Probe every server name in list against the one
+ * address given with --connect, sharing the SSL
+ * context, and with no lookups at all. Results are
+ * reported once all are in, grouped by the leaf
+ * certificate returned. Returns EXIT_FAILURE if the
+ * handshake failed for any name.
+ */
+int sweep_run (settings_t *settings, target_list_t *list, BIO *bp) {
+	uint64_t start;
+	target_t target;
+	sweep_t sweep;
+
+	memset(&sweep, 0, sizeof(sweep));
+	sweep.settings = settings;
+	sweep.list = list;
+	sweep.bp = bp;
+	sweep.limit = settings->concurrency;
+
+	if (is_error(target_parse(&target, settings->connect), -1)
+	    || is_error(resolve_literal(target.host, &sweep.addr), -1)) {
+		fprintf(stderr, "Error: Invalid address %s.\n", settings->connect);
+		return EXIT_FAILURE;
+	}
+
+	sweep.port = target.port;
+	start = clock_now();
+
+	sock_rlimit(sweep.limit);
+
+	sweep.ctx = SSL_CTX_new(SSLv23_client_method());
+
+	if (is_null(sweep.ctx)) {
+		fprintf(stderr, "Error: Unable to establish SSL context.\n");
+		ERR_print_errors(bp);
+		return EXIT_FAILURE;
+	}
+
+	/**
+	 * The chain is all that's needed of
+	 * each name, if --cert-only was given.
+	 */
+	if (settings->cert_only) {
+		SSL_CTX_set_cert_verify_callback(sweep.ctx, probe_certificate, NULL);
+	}
+
+	sweep.loop = ev_new();
+
+	if (is_null(sweep.loop)) {
+		fprintf(stderr, "Error: Unable to create event loop.\n");
+		SSL_CTX_free(sweep.ctx);
+		return EXIT_FAILURE;
+	}
+
+	sweep.buf = buf_new(BUF_INITIAL_SIZE);
+	sweep.size = SWEEP_INITIAL_NAMES;
+	sweep.names = CALLOC(sweep.size, (long) sizeof(sweep_name_t *));
+	sweep.nbuckets = SWEEP_INITIAL_BUCKETS;
+	sweep.buckets = CALLOC(sweep.nbuckets, (long) sizeof(sweep_group_t *));
+
+	sweep_fill(&sweep);
+
+	while (sweep.inflight > 0) {
+		if (is_error(ev_wait(sweep.loop, -1), -1)) {
+			break;
+		}
+
+		sweep_fill(&sweep);
+	}
+
+	sweep_report(&sweep, start);
+
+	buf_free(sweep.buf);
+	ev_free(sweep.loop);
+	SSL_CTX_free(sweep.ctx);
+
+	return (sweep.failed > 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,196 @@
+/**
+ * target.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "target.h"
+
+/**
+ * Parse host[:port] (or [v6addr]:port) into target. A
+ * host with more than one colon, unbracketed, has to be
+ * an IPv6 address (with no port).
+ */
+int target_parse (target_t *target, const char *spec) {
+	int bare = 0;
+	size_t hostlen;
+	unsigned char addr[16];
+	const char *host, *port, *end;
+
+	while (isspace((unsigned char) *spec)) {
+		spec++;
+	}
+
+	end = spec + strlen(spec);
+
+	while (end > spec && isspace((unsigned char) end[-1])) {
+		end--;
+	}
+
+	if (end == spec || (size_t) (end - spec) >= sizeof(target->name)) {
+		return -1;
+	}
+
+	memcpy(target->name, spec, end - spec);
+	target->name[end - spec] = '\0';
+	target->port = DEFAULT_PORT;
+	host = target->name;
+	port = NULL;
+
+	if (*host == '[') {
+		/**
+		 * Bracketed IPv6 literal, e.g. [::1]:443.
+		 */
+		host++;
+		end = strchr(host, ']');
+
+		if (is_null((void *) end)) {
+			return -1;
+		}
+
+		if (end[1] == ':') {
+			port = end + 2;
+		} else if (end[1] != '\0') {
+			return -1;
+		}
+	} else {
+		end = strrchr(host, ':');
+
+		/**
+		 * A bare IPv6 literal has more than one colon,
+		 * in which case there is no port to split off.
+		 */
+		if (!is_null((void *) end) && strchr(host, ':') == end) {
+			port = end + 1;
+		} else {
+			bare = !is_null((void *) end);
+			end = host + strlen(host);
+		}
+	}
+
+	hostlen = (size_t) (end - host);
+
+	if (hostlen == 0 || hostlen > MAX_HOSTNAME_LENGTH) {
+		return -1;
+	}
+
+	memcpy(target->host, host, hostlen);
+	target->host[hostlen] = '\0';
+
+	if (bare && inet_pton(AF_INET6, target->host, addr) != 1) {
+		return -1;
+	}
+
+	if (!is_null((void *) port)) {
+		if (*port == '\0' || !is_numeric((char *) port)) {
+			return -1;
+		}
+
+		target->port = atoi(port);
+
+		if (target->port < 1 || target->port > 65535) {
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Open target list from file, or stdin if path is "-".
+ */
+target_list_t *target_open (const char *path) {
+	int error;
+	target_list_t *list;
+
+	NEW0(list);
+
+	if (!compare((char *) path, "-")) {
+		list->fp = stdin;
+	} else {
+		list->fp = get_file(&error, path, "r");
+		list->owned = 1;
+
+		if (error) {
+			FREE(list);
+			return NULL;
+		}
+	}
+
+	return list;
+}
+
+/**
+ * Wrap a single hostname given on the command line.
+ */
+target_list_t *target_single (const char *spec) {
+	target_list_t *list;
+
+	NEW0(list);
+	list->single = spec;
+
+	return list;
+}
+
+/**
+ * Get next target from list. Blank lines and lines
+ * starting with '#' are skipped, as are malformed
+ * lines, which are reported to stderr and counted
+ * as invalid. Returns 1 if a target was read, 0
+ * when the list is exhausted.
+ */
+int target_next (target_list_t *list, target_t *target) {
+	char buf[MAX_TARGET_LINE], *ptr;
+
+	if (!is_null((void *) list->single)) {
+		if (list->line++) {
+			return 0;
+		}
+
+		if (is_error(target_parse(target, list->single), -1)) {
+			fprintf(stderr, "Error: Invalid target %s.\n", list->single);
+			list->invalid += 1;
+			return 0;
+		}
+
+		return 1;
+	}
+
+	while (fgets(buf, sizeof(buf), list->fp)) {
+		list->line += 1;
+		ptr = buf;
+
+		while (isspace((unsigned char) *ptr)) {
+			ptr++;
+		}
+
+		if (*ptr == '\0' || *ptr == '#') {
+			continue;
+		}
+
+		if (is_error(target_parse(target, ptr), -1)) {
+			fprintf(stderr, "Error: Invalid target on line %ld.\n", list->line);
+			list->invalid += 1;
+			continue;
+		}
+
+		return 1;
+	}
+
+	return 0;
+}
+
+/**
+ * Release target list.
+ */
+void target_close (target_list_t *list) {
+	if (is_null(list)) {
+		return;
+	}
+
+	if (list->owned) {
+		fclose(list->fp);
+	}
+
+	FREE(list);
+}
@@ -0,0 +1,431 @@
+/**
+ * throttle.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "throttle.h"
+
+static unsigned int throttle_hash (int family, int bits, const unsigned char *addr) {
+	int index;
+	unsigned int hash = 2166136261u;
+
+	for (index = 0; index < bits / 8; index += 1) {
+		hash ^= addr[index];
+		hash *= 16777619u;
+	}
+
+	hash ^= (unsigned int) family;
+	hash *= 16777619u;
+	hash ^= (unsigned int) bits;
+	hash *= 16777619u;
+
+	return hash;
+}
+
+/**
+ * Destination for the first bits of addr, created
+ * (with nothing in flight) if create is set.
+ */
+static throttle_dest_t *throttle_dest (throttle_t *throttle, const resolve_addr_t *addr, int bits, int create) {
+	unsigned char key[16];
+	unsigned int bucket;
+	throttle_dest_t *dest;
+
+	memset(key, 0, sizeof(key));
+	memcpy(key, addr->addr, (size_t) bits / 8);
+	bucket = throttle_hash(addr->family, bits, key) % THROTTLE_BUCKETS;
+
+	for (dest = throttle->buckets[bucket]; !is_null(dest); dest = dest->next) {
+		if (dest->family == addr->family && dest->bits == bits && !memcmp(dest->addr, key, sizeof(key))) {
+			return dest;
+		}
+	}
+
+	if (!create) {
+		return NULL;
+	}
+
+	NEW0(dest);
+	dest->family = addr->family;
+	dest->bits = bits;
+	memcpy(dest->addr, key, sizeof(key));
+	dest->next = throttle->buckets[bucket];
+	throttle->buckets[bucket] = dest;
+
+	return dest;
+}
+
+/**
+ * Give up place with dest, and forget
+ * about it once nothing's in flight.
+ */
+static void throttle_release (throttle_t *throttle, throttle_dest_t *dest) {
+	unsigned int bucket;
+	throttle_dest_t **link;
+
+	if (is_null(dest) || --dest->count > 0) {
+		return;
+	}
+
+	bucket = throttle_hash(dest->family, dest->bits, dest->addr) % THROTTLE_BUCKETS;
+
+	for (link = &throttle->buckets[bucket]; !is_null(*link); link = &(*link)->next) {
+		if (*link == dest) {
+			*link = dest->next;
+			FREE(dest);
+			return;
+		}
+	}
+}
+
+static int throttle_prefix (const resolve_addr_t *addr) {
+	return (addr->family == AF_INET6) ? THROTTLE_PREFIX_INET6 : THROTTLE_PREFIX_INET;
+}
+
+static int throttle_bits (const resolve_addr_t *addr) {
+	return (addr->family == AF_INET6) ? 128 : 32;
+}
+
+/**
+ * Whether another probe may go to addr
+ * without going over either cap.
+ */
+static int throttle_fits (throttle_t *throttle, const resolve_addr_t *addr) {
+	throttle_dest_t *dest;
+
+	if (throttle->per_ip) {
+		dest = throttle_dest(throttle, addr, throttle_bits(addr), 0);
+
+		if (!is_null(dest) && dest->count >= throttle->per_ip) {
+			return 0;
+		}
+	}
+
+	if (throttle->per_prefix) {
+		dest = throttle_dest(throttle, addr, throttle_prefix(addr), 0);
+
+		if (!is_null(dest) && dest->count >= throttle->per_prefix) {
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+/**
+ * Top up the bucket for the time since it last was.
+ * Returns 1 if there's a token in it (or no --rate).
+ */
+static int throttle_refill (throttle_t *throttle) {
+	uint64_t now;
+
+	if (!throttle->rate) {
+		return 1;
+	}
+
+	now = clock_now();
+	throttle->tokens += (double) (now - throttle->refilled) * throttle->rate / NSEC_PER_SEC;
+	throttle->refilled = now;
+
+	if (throttle->tokens > throttle->burst) {
+		throttle->tokens = throttle->burst;
+	}
+
+	return throttle->tokens >= 1;
+}
+
+/**
+ * Take a token from the bucket. Returns 0 if none
+ * is left, or 1 if taken (or there's no --rate).
+ */
+static int throttle_token (throttle_t *throttle) {
+	if (!throttle_refill(throttle)) {
+		return 0;
+	}
+
+	if (throttle->rate) {
+		throttle->tokens -= 1;
+	}
+
+	return 1;
+}
+
+/**
+ * Hold entry back, at the end of the queue.
+ */
+static void throttle_queue (throttle_t *throttle, throttle_entry_t *entry) {
+	entry->next = NULL;
+	entry->prev = throttle->tail;
+
+	if (is_null(throttle->tail)) {
+		throttle->head = entry;
+	} else {
+		throttle->tail->next = entry;
+	}
+
+	throttle->tail = entry;
+	entry->held = 1;
+	throttle->nheld += 1;
+}
+
+/**
+ * Take held entry off the queue.
+ */
+static void throttle_unqueue (throttle_t *throttle, throttle_entry_t *entry) {
+	if (is_null(entry->prev)) {
+		throttle->head = entry->next;
+	} else {
+		entry->prev->next = entry->next;
+	}
+
+	if (is_null(entry->next)) {
+		throttle->tail = entry->prev;
+	} else {
+		entry->next->prev = entry->prev;
+	}
+
+	entry->prev = NULL;
+	entry->next = NULL;
+	throttle->nheld -= 1;
+}
+
+/**
+ * Wake up once the next token is due, for
+ * probes held back waiting for one.
+ */
+static void throttle_arm (throttle_t *throttle) {
+	if (ev_timer_active(&throttle->timer)) {
+		return;
+	}
+
+	ev_timer_start(
+		throttle->loop,
+		&throttle->timer,
+		(uint64_t) ((1 - throttle->tokens) * NSEC_PER_SEC / throttle->rate) + 1
+	);
+}
+
+/**
+ * Let entry go ahead, taking its place with
+ * the address and prefix it connects to.
+ */
+static void throttle_go (throttle_t *throttle, throttle_entry_t *entry) {
+	entry->held = 0;
+
+	if (throttle->per_ip) {
+		entry->ip = throttle_dest(throttle, &entry->addr, throttle_bits(&entry->addr), 1);
+		entry->ip->count += 1;
+	}
+
+	if (throttle->per_prefix) {
+		entry->prefix = throttle_dest(throttle, &entry->addr, throttle_prefix(&entry->addr), 1);
+		entry->prefix->count += 1;
+	}
+}
+
+static void throttle_tick (ev_timer_t *timer) {
+	throttle_pump(timer->arg);
+}
+
+/**
+ * New throttle, for scans with at most limit probes
+ * in flight. Caps and rate of 0 mean no limit.
+ */
+throttle_t *throttle_new (ev_loop_t *loop, int limit, int per_ip, int per_prefix, int rate, int adaptive) {
+	throttle_t *throttle;
+
+	NEW0(throttle);
+	throttle->loop = loop;
+	throttle->limit = limit;
+	throttle->per_ip = per_ip;
+	throttle->per_prefix = per_prefix;
+	throttle->rate = rate;
+	throttle->adaptive = adaptive;
+	throttle->window = limit;
+	throttle->burst = (rate / THROTTLE_BURST > 1) ? rate / THROTTLE_BURST : 1;
+	throttle->tokens = throttle->burst;
+	throttle->refilled = clock_now();
+	ev_timer_set(&throttle->timer, throttle_tick, throttle);
+
+	return throttle;
+}
+
+/**
+ * Release throttle. Every probe
+ * should be done with it by now.
+ */
+void throttle_free (throttle_t *throttle) {
+	int index;
+	throttle_dest_t *dest, *next;
+	throttle_entry_t *entry;
+
+	if (is_null(throttle)) {
+		return;
+	}
+
+	if (ev_timer_active(&throttle->timer)) {
+		ev_timer_stop(throttle->loop, &throttle->timer);
+	}
+
+	while (!is_null(entry = throttle->head)) {
+		throttle->head = entry->next;
+		entry->probe->slot = NULL;
+		FREE(entry);
+	}
+
+	for (index = 0; index < THROTTLE_BUCKETS; index += 1) {
+		for (dest = throttle->buckets[index]; !is_null(dest); dest = next) {
+			next = dest->next;
+			FREE(dest);
+		}
+	}
+
+	FREE(throttle);
+}
+
+/**
+ * Whether another probe may be started, with inflight
+ * started so far. Held probes don't count against the
+ * window, as they've nothing open, though no more than
+ * limit of them are kept waiting.
+ */
+int throttle_room (throttle_t *throttle, int inflight) {
+	return (inflight - throttle->nheld) < (int) throttle->window && throttle->nheld < throttle->limit;
+}
+
+/**
+ * Decide whether probe may connect to addr now. If not,
+ * it's held back, in order, until throttle_pump finds it
+ * room. Returns 1 if the probe may go ahead.
+ *
+ * A probe is admitted once, for the first address it
+ * tries, and counts against that address (and prefix)
+ * until done. Happy Eyeballs attempts at its other
+ * addresses aren't capped on their own.
+ */
+int throttle_admit (throttle_t *throttle, probe_t *probe, const resolve_addr_t *addr) {
+	int starved = 0;
+	throttle_entry_t *entry;
+
+	NEW0(entry);
+	entry->probe = probe;
+	entry->addr = *addr;
+	probe->slot = entry;
+
+	if (throttle_fits(throttle, addr)) {
+		if (throttle_token(throttle)) {
+			throttle_go(throttle, entry);
+			return 1;
+		}
+
+		starved = 1;
+	}
+
+	throttle_queue(throttle, entry);
+
+	/**
+	 * Probes held for a cap get their turn when
+	 * one in flight is done, those held for the
+	 * rate once the next token is due.
+	 */
+	if (starved) {
+		throttle_arm(throttle);
+	}
+
+	return 0;
+}
+
+/**
+ * Resume held probes there's now room for, oldest
+ * first, until the bucket runs dry. Probes are taken
+ * off the queue before any is resumed, since a probe
+ * may complete (and be done with the throttle) while
+ * it's resumed.
+ */
+void throttle_pump (throttle_t *throttle) {
+	throttle_entry_t *entry, *next, *ready = NULL, **tail = &ready;
+
+	for (entry = throttle->head; !is_null(entry); entry = next) {
+		next = entry->next;
+
+		if (!throttle_refill(throttle)) {
+			throttle_arm(throttle);
+			break;
+		}
+
+		if (!throttle_fits(throttle, &entry->addr)) {
+			continue;
+		}
+
+		throttle_token(throttle);
+		throttle_unqueue(throttle, entry);
+		throttle_go(throttle, entry);
+
+		*tail = entry;
+		tail = &entry->next;
+	}
+
+	while (!is_null(entry = ready)) {
+		ready = entry->next;
+		entry->next = NULL;
+		probe_resume(entry->probe);
+	}
+}
+
+/**
+ * Probe is done. Give up its place (or its turn), and,
+ * under --adaptive, adjust the window for the outcome.
+ */
+void throttle_done (throttle_t *throttle, probe_t *probe) {
+	throttle_entry_t *entry = probe->slot;
+
+	if (!is_null(entry)) {
+		if (entry->held) {
+			throttle_unqueue(throttle, entry);
+		} else {
+			throttle_release(throttle, entry->ip);
+			throttle_release(throttle, entry->prefix);
+		}
+
+		FREE(entry);
+		probe->slot = NULL;
+	}
+
+	if (!throttle->adaptive) {
+		return;
+	}
+
+	switch (probe->error) {
+		case PROBE_OK:
+			throttle->window += 1 / throttle->window;
+
+			if (throttle->window > throttle->limit) {
+				throttle->window = throttle->limit;
+			}
+
+			break;
+		case PROBE_ERR_CONNECT:
+		case PROBE_ERR_CONNECT_TIMEOUT:
+		case PROBE_ERR_HANDSHAKE:
+		case PROBE_ERR_HANDSHAKE_TIMEOUT:
+			/**
+			 * Probes started before the last cut were
+			 * already in flight under the old window,
+			 * so their failures are nothing new.
+			 */
+			if (probe->timing.start >= throttle->cut) {
+				throttle->window /= 2;
+				throttle->cut = clock_now();
+				throttle->cuts += 1;
+
+				if (throttle->window < 1) {
+					throttle->window = 1;
+				}
+			}
+
+			break;
+		default:
+			break;
+	}
+}
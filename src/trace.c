@@ -0,0 +1,145 @@
+/**
+ * trace.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "trace.h"
+
+/**
+ * Buffer of the calling thread, once it's recorded
+ * anything, and the list of every thread's buffer.
+ */
+static __thread trace_buf_t *trace_local = NULL;
+static trace_buf_t *trace_bufs = NULL;
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static FILE *trace_fp = NULL;
+static uint64_t trace_origin = 0;
+static int trace_tids = 0;
+
+/**
+ * Buffer of the calling thread, set up (and named,
+ * in the trace) the first time the thread records.
+ */
+static trace_buf_t *trace_buf (void) {
+	trace_buf_t *local = trace_local;
+
+	if (!is_null(local)) {
+		return local;
+	}
+
+	NEW0(local);
+	local->buf = buf_new(BUF_INITIAL_SIZE);
+
+	pthread_mutex_lock(&trace_lock);
+	local->tid = ++trace_tids;
+	local->next = trace_bufs;
+	trace_bufs = local;
+	pthread_mutex_unlock(&trace_lock);
+
+	if (local->tid == 1) {
+		buf_printf(local->buf, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":1,\"args\":{\"name\":\"main\"}}", (int) getpid());
+	} else {
+		buf_printf(
+			local->buf,
+			"{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"worker %d\"}}",
+			(int) getpid(),
+			local->tid,
+			local->tid - 1
+		);
+	}
+
+	trace_local = local;
+
+	return local;
+}
+
+/**
+ * Start tracing to path. Nothing is written
+ * until trace_close. Returns -1 on error.
+ */
+int trace_open (const char *path) {
+	trace_fp = fopen(path, "w");
+
+	if (is_null(trace_fp)) {
+		return -1;
+	}
+
+	trace_origin = clock_now();
+
+	return 0;
+}
+
+/**
+ * Record that name (of category cat) ran from begin to
+ * end (from clock_now) on the calling thread, for host,
+ * if given. Does nothing unless tracing.
+ */
+void trace_event (const char *name, const char *cat, uint64_t begin, uint64_t end, const char *host) {
+	trace_buf_t *local;
+	buf_t *buf;
+
+	if (is_null(trace_fp) || begin < trace_origin || end < begin) {
+		return;
+	}
+
+	local = trace_buf();
+	buf = local->buf;
+
+	buf_printf(
+		buf,
+		",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":%d,\"tid\":%d",
+		name,
+		cat,
+		(double) (begin - trace_origin) / 1000,
+		(double) (end - begin) / 1000,
+		(int) getpid(),
+		local->tid
+	);
+
+	if (!is_null((void *) host)) {
+		buf_puts(buf, ",\"args\":{\"host\":");
+		buf_json(buf, host, strlen(host));
+		buf_puts(buf, "}");
+	}
+
+	buf_puts(buf, "}");
+}
+
+/**
+ * Write out the events of every thread as Chrome
+ * trace-event JSON, then stop tracing. Threads
+ * that recorded must be done by now.
+ */
+void trace_close (void) {
+	int first = 1;
+	trace_buf_t *local, *next;
+
+	if (is_null(trace_fp)) {
+		return;
+	}
+
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", trace_fp);
+
+	for (local = trace_bufs; !is_null(local); local = next) {
+		next = local->next;
+
+		if (!first) {
+			fputs(",\n", trace_fp);
+		}
+
+		fwrite(local->buf->data, 1, local->buf->len, trace_fp);
+		first = 0;
+
+		buf_free(local->buf);
+		FREE(local);
+	}
+
+	fputs("\n]}\n", trace_fp);
+	fclose(trace_fp);
+
+	trace_fp = NULL;
+	trace_bufs = NULL;
+	trace_local = NULL;
+}
@@ -0,0 +1,275 @@
+/**
+ * verify.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "verify.h"
+
+/**
+ * Bucket digest falls in, as with the cert cache.
+ */
+static size_t verify_bucket (const verify_t *verify, const unsigned char *digest) {
+	uint64_t hash;
+
+	memcpy(&hash, digest, sizeof(hash));
+
+	return (size_t) hash & (verify->size - 1);
+}
+
+static verify_entry_t *verify_find (const verify_t *verify, const unsigned char *digest, int64_t bucket) {
+	verify_entry_t *entry;
+
+	for (entry = verify->buckets[verify_bucket(verify, digest)]; !is_null(entry); entry = entry->next) {
+		if (entry->bucket == bucket && !memcmp(entry->digest, digest, SHA256_DIGEST_LENGTH)) {
+			return entry;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Double the number of buckets once there are more
+ * entries than buckets. Entries from earlier time
+ * buckets will never be looked up again, so they're
+ * dropped along the way.
+ */
+static void verify_grow (verify_t *verify, int64_t bucket) {
+	size_t index, size;
+	verify_entry_t **buckets, *entry, *next;
+
+	if (verify->count < verify->size) {
+		return;
+	}
+
+	buckets = verify->buckets;
+	size = verify->size;
+	verify->size = size * 2;
+	verify->buckets = CALLOC((long) verify->size, (long) sizeof(verify_entry_t *));
+
+	for (index = 0; index < size; index += 1) {
+		for (entry = buckets[index]; !is_null(entry); entry = next) {
+			next = entry->next;
+
+			if (entry->bucket < bucket) {
+				FREE(entry);
+				verify->count -= 1;
+				continue;
+			}
+
+			entry->next = verify->buckets[verify_bucket(verify, entry->digest)];
+			verify->buckets[verify_bucket(verify, entry->digest)] = entry;
+		}
+	}
+
+	FREE(buckets);
+}
+
+/**
+ * Digest of a chain, over the digests of its
+ * certificates (leaf first), then the bucket.
+ */
+static int verify_digest (STACK_OF(X509) *chain, int64_t bucket, unsigned char *digest) {
+	int index, status;
+	unsigned char crt_digest[SHA256_DIGEST_LENGTH];
+	EVP_MD_CTX *md;
+
+	md = EVP_MD_CTX_new();
+	status = (!is_null(md) && EVP_DigestInit_ex(md, EVP_sha256(), NULL)) ? 0 : -1;
+
+	for (index = 0; !status && index < sk_X509_num(chain); index += 1) {
+		if (!X509_digest(sk_X509_value(chain, index), EVP_sha256(), crt_digest, NULL)
+		    || !EVP_DigestUpdate(md, crt_digest, sizeof(crt_digest))) {
+			status = -1;
+		}
+	}
+
+	if (!status && (!EVP_DigestUpdate(md, &bucket, sizeof(bucket)) || !EVP_DigestFinal_ex(md, digest, NULL))) {
+		status = -1;
+	}
+
+	EVP_MD_CTX_free(md);
+
+	return status;
+}
+
+/**
+ * Verify chain against the trust store, for a TLS
+ * server, with the rest of the chain as untrusted.
+ */
+static int verify_store (verify_t *verify, STACK_OF(X509) *chain) {
+	int result;
+	X509_STORE_CTX *ctx;
+
+	ctx = X509_STORE_CTX_new();
+
+	if (is_null(ctx)) {
+		return X509_V_ERR_OUT_OF_MEM;
+	}
+
+	if (!X509_STORE_CTX_init(ctx, verify->store, sk_X509_value(chain, 0), chain)) {
+		X509_STORE_CTX_free(ctx);
+		return X509_V_ERR_UNSPECIFIED;
+	}
+
+	X509_STORE_CTX_set_default(ctx, "ssl_server");
+	result = X509_V_OK;
+
+	/**
+	 * It may fail without saying why, e.g. out of memory.
+	 */
+	if (X509_verify_cert(ctx) != 1) {
+		result = X509_STORE_CTX_get_error(ctx);
+		result = (result == X509_V_OK) ? X509_V_ERR_UNSPECIFIED : result;
+	}
+
+	X509_STORE_CTX_free(ctx);
+	ERR_clear_error();
+
+	return result;
+}
+
+/**
+ * New trust store, with every certificate in cafile
+ * loaded up front, or those of the default bundle.
+ * Without a bundle, fall back to the default paths,
+ * where certificates are looked up as needed.
+ */
+verify_t *verify_new (const char *cafile) {
+	const char *path;
+	verify_t *verify;
+
+	NEW0(verify);
+	verify->store = X509_STORE_new();
+
+	if (is_null(verify->store)) {
+		FREE(verify);
+		return NULL;
+	}
+
+	path = cafile;
+
+	if (is_null((void *) path)) {
+		path = getenv(X509_get_default_cert_file_env());
+	}
+
+	if (is_null((void *) path)) {
+		path = X509_get_default_cert_file();
+	}
+
+	if (!X509_STORE_load_locations(verify->store, path, NULL)) {
+		if (!is_null((void *) cafile) || !X509_STORE_set_default_paths(verify->store)) {
+			X509_STORE_free(verify->store);
+			FREE(verify);
+			return NULL;
+		}
+	}
+
+	ERR_clear_error();
+
+	verify->size = VERIFY_CACHE_SIZE;
+	verify->buckets = CALLOC((long) verify->size, (long) sizeof(verify_entry_t *));
+	pthread_mutex_init(&verify->lock, NULL);
+
+	return verify;
+}
+
+void verify_free (verify_t *verify) {
+	size_t index;
+	verify_entry_t *entry, *next;
+
+	if (is_null(verify)) {
+		return;
+	}
+
+	for (index = 0; index < verify->size; index += 1) {
+		for (entry = verify->buckets[index]; !is_null(entry); entry = next) {
+			next = entry->next;
+			FREE(entry);
+		}
+	}
+
+	pthread_mutex_destroy(&verify->lock);
+	X509_STORE_free(verify->store);
+	FREE(verify->buckets);
+	FREE(verify);
+}
+
+/**
+ * Verify chain, and that its leaf is for host (a name
+ * or an address). Returns X509_V_OK, or why it failed.
+ * The chain's outcome is cached, so a chain shared by
+ * many hosts is verified once per time bucket. Only
+ * the host is checked every time, which is cheap.
+ * Verifying is done outside the lock, so if two threads
+ * race on a new chain, both verify it, and one is kept.
+ */
+int verify_chain (verify_t *verify, STACK_OF(X509) *chain, const char *host) {
+	int result, matched;
+	int64_t bucket;
+	unsigned char digest[SHA256_DIGEST_LENGTH];
+	verify_entry_t *entry, *found;
+	X509 *leaf;
+
+	if (is_null(chain) || sk_X509_num(chain) < 1) {
+		return X509_V_ERR_UNSPECIFIED;
+	}
+
+	bucket = (int64_t) time(NULL) / VERIFY_BUCKET;
+
+	if (is_error(verify_digest(chain, bucket, digest), -1)) {
+		ERR_clear_error();
+		return X509_V_ERR_UNSPECIFIED;
+	}
+
+	pthread_mutex_lock(&verify->lock);
+	entry = verify_find(verify, digest, bucket);
+
+	result = is_null(entry) ? X509_V_OK : entry->result;
+	pthread_mutex_unlock(&verify->lock);
+
+	if (is_null(entry)) {
+		result = verify_store(verify, chain);
+
+		NEW0(entry);
+		memcpy(entry->digest, digest, SHA256_DIGEST_LENGTH);
+		entry->bucket = bucket;
+		entry->result = result;
+
+		pthread_mutex_lock(&verify->lock);
+		found = verify_find(verify, digest, bucket);
+
+		if (is_null(found)) {
+			verify_grow(verify, bucket);
+			entry->next = verify->buckets[verify_bucket(verify, digest)];
+			verify->buckets[verify_bucket(verify, digest)] = entry;
+			verify->count += 1;
+			entry = NULL;
+		}
+
+		pthread_mutex_unlock(&verify->lock);
+		FREE(entry);
+	}
+
+	if (result != X509_V_OK) {
+		return result;
+	}
+
+	/**
+	 * Malformed as an address, so host is a name.
+	 */
+	leaf = sk_X509_value(chain, 0);
+	matched = X509_check_ip_asc(leaf, host, 0);
+
+	if (is_error(matched, -2)) {
+		matched = X509_check_host(leaf, host, 0, X509_CHECK_FLAG_NO_PARTIAL_WILDCARDS, NULL);
+		result = (matched == 1) ? X509_V_OK : X509_V_ERR_HOSTNAME_MISMATCH;
+	} else {
+		result = (matched == 1) ? X509_V_OK : X509_V_ERR_IP_ADDRESS_MISMATCH;
+	}
+
+	ERR_clear_error();
+
+	return result;
+}
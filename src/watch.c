@@ -0,0 +1,228 @@
+/**
+ * watch.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "watch.h"
+
+/**
+ * Ticks (seconds) since the watch started.
+ */
+static uint64_t watch_now (watch_t *watch) {
+	return (clock_now() - watch->origin) / NSEC_PER_SEC;
+}
+
+/**
+ * Queue entry to be probed once there's room.
+ */
+static void watch_queue (watch_t *watch, watch_entry_t *entry) {
+	entry->next = NULL;
+
+	if (is_null(watch->tail)) {
+		watch->head = entry;
+	} else {
+		watch->tail->next = entry;
+	}
+
+	watch->tail = entry;
+}
+
+/**
+ * Wheel callback, entry is due for a check.
+ */
+static void watch_due (wheel_timer_t *timer) {
+	watch_entry_t *entry = timer->arg;
+
+	watch_queue(entry->watch, entry);
+}
+
+/**
+ * Event loop callback, move the wheel on to the
+ * current second, then wait for the next one.
+ */
+static void watch_tick (ev_timer_t *timer) {
+	watch_t *watch = timer->arg;
+
+	wheel_advance(&watch->wheel, watch_now(watch));
+	ev_timer_start(watch->loop, &watch->tick, NSEC_PER_SEC);
+}
+
+/**
+ * Seconds until entry should be checked again. Hosts
+ * are checked more often the closer their certificate
+ * is to expiring, and the more recently their result
+ * changed, backing off as it holds steady. Failures
+ * are retried with exponential backoff. Jitter derived
+ * from the key keeps hosts that were first checked
+ * together from coming due together ever after.
+ */
+static int64_t watch_interval (watch_entry_t *entry, int64_t now) {
+	int64_t interval, remaining, age;
+	uint32_t jitter;
+
+	if (entry->failures > 0) {
+		interval = WATCH_RETRY_INTERVAL << ((entry->failures < 11) ? entry->failures - 1 : 10);
+	} else {
+		remaining = entry->last.not_after - now;
+		interval = (remaining > 0) ? remaining / WATCH_EXPIRY_DIVISOR : WATCH_EXPIRED_INTERVAL;
+		age = now - entry->stable;
+
+		if (age / 2 < interval) {
+			interval = age / 2;
+		}
+	}
+
+	if (interval < WATCH_MIN_INTERVAL) {
+		interval = WATCH_MIN_INTERVAL;
+	}
+
+	if (interval > WATCH_MAX_INTERVAL) {
+		interval = WATCH_MAX_INTERVAL;
+	}
+
+	memcpy(&jitter, entry->last.key, sizeof(jitter));
+
+	return interval + (int64_t) (jitter % (uint32_t) (interval / WATCH_JITTER_DIVISOR + 1));
+}
+
+/**
+ * Read every target in list, seeding each with its
+ * last result in store (if given), so a restarted
+ * watch doesn't report everything as new. All are
+ * queued for an initial check.
+ */
+watch_t *watch_new (ev_loop_t *loop, target_list_t *list, store_t *store, int no_sni) {
+	long size, index;
+	target_t target;
+	watch_entry_t *entry;
+	store_slot_t *slot;
+	watch_t *watch;
+
+	NEW0(watch);
+	watch->loop = loop;
+	size = 0;
+
+	while (target_next(list, &target)) {
+		if (watch->count == size) {
+			if (size == 0) {
+				size = 64;
+				watch->entries = CALLOC(size, (long) sizeof(watch_entry_t));
+			} else {
+				size *= 2;
+				RESIZE(watch->entries, (long) sizeof(watch_entry_t) * size);
+			}
+		}
+
+		entry = &watch->entries[watch->count++];
+		memset(entry, 0, sizeof(*entry));
+		entry->target = target;
+		entry->watch = watch;
+		entry->stable = (int64_t) time(NULL);
+		store_key(entry->last.key, &target, no_sni);
+
+		if (!is_null(store)) {
+			slot = store_find(store, entry->last.key);
+
+			if (!is_null(slot)) {
+				entry->last = *slot;
+				entry->known = 1;
+				entry->stable = slot->checked;
+			}
+		}
+	}
+
+	if (watch->count == 0) {
+		watch_free(watch);
+		return NULL;
+	}
+
+	/**
+	 * Timers are linked to one another, so they're
+	 * only set once the entries are done moving.
+	 */
+	watch->origin = clock_now();
+	wheel_init(&watch->wheel, 0);
+
+	for (index = 0; index < watch->count; index += 1) {
+		entry = &watch->entries[index];
+		wheel_timer_set(&entry->timer, watch_due, entry);
+		watch_queue(watch, entry);
+	}
+
+	ev_timer_set(&watch->tick, watch_tick, watch);
+	ev_timer_start(loop, &watch->tick, NSEC_PER_SEC);
+
+	return watch;
+}
+
+/**
+ * Stop watching, and release all entries.
+ */
+void watch_free (watch_t *watch) {
+	if (is_null(watch)) {
+		return;
+	}
+
+	if (ev_timer_active(&watch->tick)) {
+		ev_timer_stop(watch->loop, &watch->tick);
+	}
+
+	FREE(watch->entries);
+	FREE(watch);
+}
+
+/**
+ * Take the next entry due for a check off the
+ * queue, or NULL if none are due right now.
+ */
+watch_entry_t *watch_next (watch_t *watch) {
+	watch_entry_t *entry = watch->head;
+
+	if (!is_null(entry)) {
+		watch->head = entry->next;
+
+		if (is_null(watch->head)) {
+			watch->tail = NULL;
+		}
+	}
+
+	return entry;
+}
+
+/**
+ * Settle a finished check of entry, given its result
+ * (NULL if the probe failed), and schedule the next.
+ * Returns the changes since the result before it. A
+ * host that keeps failing is only reported unreachable
+ * once, and reported again when it comes back.
+ */
+int watch_done (watch_t *watch, watch_entry_t *entry, const store_slot_t *current) {
+	int changes;
+	int64_t now;
+
+	now = (int64_t) time(NULL);
+
+	if (is_null((void *) current)) {
+		changes = (entry->failures == 0) ? STORE_UNREACHABLE : 0;
+		entry->failures += 1;
+	} else {
+		changes = store_diff(entry->known ? &entry->last : NULL, current);
+
+		if (entry->failures > 0 && entry->known) {
+			changes |= STORE_RECOVERED;
+		}
+
+		entry->failures = 0;
+		entry->last = *current;
+		entry->known = 1;
+	}
+
+	if (changes) {
+		entry->stable = now;
+	}
+
+	wheel_add(&watch->wheel, &entry->timer, watch->wheel.now + (uint64_t) watch_interval(entry, now));
+
+	return changes;
+}
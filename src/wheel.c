@@ -0,0 +1,202 @@
+/**
+ * wheel.c
+ *
+ * Copyright (C) 2026 Nickolas Burr <nickolasburr@gmail.com>
+ */
+
+#include "wheel.h"
+
+/**
+ * Empty the list headed by sentinel.
+ */
+static void wheel_list_init (wheel_timer_t *head) {
+	head->next = head;
+	head->prev = head;
+}
+
+/**
+ * Link timer in at the tail of the list.
+ */
+static void wheel_list_push (wheel_timer_t *head, wheel_timer_t *timer) {
+	timer->prev = head->prev;
+	timer->next = head;
+	head->prev->next = timer;
+	head->prev = timer;
+}
+
+/**
+ * Unlink timer from whatever list it's on.
+ */
+static void wheel_list_remove (wheel_timer_t *timer) {
+	timer->prev->next = timer->next;
+	timer->next->prev = timer->prev;
+	timer->next = NULL;
+	timer->prev = NULL;
+}
+
+/**
+ * Move every timer on list from onto list to.
+ */
+static void wheel_list_splice (wheel_timer_t *from, wheel_timer_t *to) {
+	wheel_list_init(to);
+
+	if (from->next == from) {
+		return;
+	}
+
+	to->next = from->next;
+	to->prev = from->prev;
+	to->next->prev = to;
+	to->prev->next = to;
+	wheel_list_init(from);
+}
+
+/**
+ * Link timer into the slot it's due in. The level
+ * is picked by how far off the timer is, the slot
+ * by the bits of its tick that level counts.
+ */
+static void wheel_place (wheel_t *wheel, wheel_timer_t *timer) {
+	int level;
+	uint64_t delta;
+
+	if (timer->expires < wheel->now) {
+		timer->expires = wheel->now;
+	}
+
+	delta = timer->expires - wheel->now;
+
+	for (level = 0; level < WHEEL_LEVELS - 1; level += 1) {
+		if (delta < ((uint64_t) 1 << (WHEEL_BITS * (level + 1)))) {
+			break;
+		}
+	}
+
+	/**
+	 * Timers beyond the reach of the top level are
+	 * parked as far out as it goes, and placed again
+	 * when that comes around.
+	 */
+	if (delta >= ((uint64_t) 1 << (WHEEL_BITS * WHEEL_LEVELS))) {
+		timer->expires = wheel->now + ((uint64_t) 1 << (WHEEL_BITS * WHEEL_LEVELS)) - 1;
+	}
+
+	wheel_list_push(
+		&wheel->slots[level][(timer->expires >> (WHEEL_BITS * level)) & WHEEL_MASK],
+		timer
+	);
+}
+
+/**
+ * Place timers in slot of level again, now
+ * that the level below has wrapped around.
+ * Returns the index of the slot.
+ */
+static int wheel_cascade (wheel_t *wheel, int level) {
+	int index;
+	wheel_timer_t pending, *timer;
+
+	index = (int) ((wheel->now >> (WHEEL_BITS * level)) & WHEEL_MASK);
+	wheel_list_splice(&wheel->slots[level][index], &pending);
+
+	while (pending.next != &pending) {
+		timer = pending.next;
+		wheel_list_remove(timer);
+		wheel_place(wheel, timer);
+	}
+
+	return index;
+}
+
+/**
+ * Start wheel at tick now.
+ */
+void wheel_init (wheel_t *wheel, uint64_t now) {
+	int level, index;
+
+	wheel->now = now;
+	wheel->count = 0;
+
+	for (level = 0; level < WHEEL_LEVELS; level += 1) {
+		for (index = 0; index < WHEEL_SIZE; index += 1) {
+			wheel_list_init(&wheel->slots[level][index]);
+		}
+	}
+}
+
+/**
+ * Set callback and argument of timer.
+ */
+void wheel_timer_set (wheel_timer_t *timer, wheel_cb_t cb, void *arg) {
+	timer->next = NULL;
+	timer->prev = NULL;
+	timer->expires = 0;
+	timer->cb = cb;
+	timer->arg = arg;
+}
+
+/**
+ * Add timer, due at tick expires. If it's
+ * already pending, it's moved instead.
+ */
+void wheel_add (wheel_t *wheel, wheel_timer_t *timer, uint64_t expires) {
+	wheel_del(wheel, timer);
+
+	timer->expires = expires;
+	wheel_place(wheel, timer);
+	wheel->count += 1;
+}
+
+/**
+ * Remove timer, if pending.
+ */
+void wheel_del (wheel_t *wheel, wheel_timer_t *timer) {
+	if (!wheel_pending(timer)) {
+		return;
+	}
+
+	wheel_list_remove(timer);
+	wheel->count -= 1;
+}
+
+/**
+ * Determine if timer is pending.
+ */
+int wheel_pending (wheel_timer_t *timer) {
+	return !is_null(timer->next);
+}
+
+/**
+ * Fire all timers due up to and including tick until,
+ * one tick at a time. The tick is moved on before the
+ * callbacks run, so timers they add for the current
+ * tick fire on the next one, rather than a revolution
+ * from now.
+ */
+void wheel_advance (wheel_t *wheel, uint64_t until) {
+	int level, index;
+	wheel_timer_t pending, *timer;
+
+	while (wheel->now <= until) {
+		if (wheel->count == 0) {
+			wheel->now = until + 1;
+			break;
+		}
+
+		index = (int) (wheel->now & WHEEL_MASK);
+
+		for (level = 1; level < WHEEL_LEVELS && index == 0; level += 1) {
+			index = wheel_cascade(wheel, level);
+		}
+
+		wheel_list_splice(&wheel->slots[0][wheel->now & WHEEL_MASK], &pending);
+		wheel->now += 1;
+
+		while (pending.next != &pending) {
+			timer = pending.next;
+			wheel_list_remove(timer);
+			wheel->count -= 1;
+			timer->cb(timer);
+		}
+	}
+}
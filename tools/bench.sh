@@ -0,0 +1,249 @@
+#!/bin/sh
+
+# Handshake benchmarks against local openssl s_server
+# fixtures, with certificates generated for the run, of
+# varying key types and chain lengths. Each fixture is
+# measured probed on its own (single), in a batch, and
+# repeatedly (--count). Results are printed, and saved
+# to $BENCH_OUT to compare with later runs.
+
+set -e
+
+PROJ_DIR="$(dirname $PWD)"
+TARGET="$PROJ_DIR/keuka"
+
+BENCH_PORT=${BENCH_PORT:-14430}
+BENCH_SINGLE=${BENCH_SINGLE:-50}
+BENCH_BATCH=${BENCH_BATCH:-2000}
+BENCH_COUNT=${BENCH_COUNT:-500}
+BENCH_CONCURRENCY=${BENCH_CONCURRENCY:-64}
+BENCH_OUT=${BENCH_OUT:-"$PROJ_DIR/bench_output.txt"}
+
+WORK_DIR="$(mktemp -d)"
+PIDS=""
+
+cleanup () {
+	for pid in $PIDS; do
+		kill "$pid" 2>/dev/null || true
+	done
+
+	rm -rf "$WORK_DIR"
+}
+
+trap cleanup EXIT INT TERM
+
+# Current time, in milliseconds.
+now () {
+	echo $(($(date +%s%N) / 1000000))
+}
+
+# Generate key of type ($1) into $2.
+genkey () {
+	case "$1" in
+		rsa2048) openssl genpkey -algorithm RSA -pkeyopt rsa_keygen_bits:2048 -out "$2" 2>/dev/null ;;
+		rsa4096) openssl genpkey -algorithm RSA -pkeyopt rsa_keygen_bits:4096 -out "$2" 2>/dev/null ;;
+		p256) openssl genpkey -algorithm EC -pkeyopt ec_paramgen_curve:P-256 -out "$2" 2>/dev/null ;;
+		ed25519) openssl genpkey -algorithm ED25519 -out "$2" 2>/dev/null ;;
+	esac
+}
+
+# Generate fixture named $1, with a leaf key of type $2, under
+# a chain of $3 certificates in all (1 being self-signed).
+fixture () {
+	dir="$WORK_DIR/$1"
+	mkdir -p "$dir"
+
+	genkey "$2" "$dir/leaf.key"
+
+	if test "$3" -eq 1; then
+		openssl req -x509 -new -key "$dir/leaf.key" -subj "/CN=localhost" \
+			-days 1 -out "$dir/leaf.pem" 2>/dev/null
+		: > "$dir/chain.pem"
+		return
+	fi
+
+	genkey rsa2048 "$dir/ca0.key"
+	openssl req -x509 -new -key "$dir/ca0.key" -subj "/CN=bench root" \
+		-addext "basicConstraints=critical,CA:TRUE" -days 1 -out "$dir/ca0.pem" 2>/dev/null
+	: > "$dir/chain.pem"
+
+	level=1
+	issuer=ca0
+
+	while test "$level" -lt $(($3 - 1)); do
+		genkey rsa2048 "$dir/ca$level.key"
+		openssl req -new -key "$dir/ca$level.key" -subj "/CN=bench intermediate $level" \
+			-out "$dir/ca$level.csr" 2>/dev/null
+		printf 'basicConstraints=critical,CA:TRUE\n' > "$dir/ca.ext"
+		openssl x509 -req -in "$dir/ca$level.csr" -CA "$dir/$issuer.pem" -CAkey "$dir/$issuer.key" \
+			-CAcreateserial -extfile "$dir/ca.ext" -days 1 -out "$dir/ca$level.pem" 2>/dev/null
+		cat "$dir/ca$level.pem" "$dir/chain.pem" > "$dir/chain.tmp"
+		mv "$dir/chain.tmp" "$dir/chain.pem"
+		issuer=ca$level
+		level=$((level + 1))
+	done
+
+	openssl req -new -key "$dir/leaf.key" -subj "/CN=localhost" -out "$dir/leaf.csr" 2>/dev/null
+	printf 'subjectAltName=DNS:localhost\n' > "$dir/leaf.ext"
+	openssl x509 -req -in "$dir/leaf.csr" -CA "$dir/$issuer.pem" -CAkey "$dir/$issuer.key" \
+		-CAcreateserial -extfile "$dir/leaf.ext" -days 1 -out "$dir/leaf.pem" 2>/dev/null
+}
+
+# Serve fixture $1 on port $2, with extra s_server options.
+serve () {
+	dir="$WORK_DIR/$1"
+	port=$2
+	shift 2
+
+	if test -s "$dir/chain.pem"; then
+		set -- -cert_chain "$dir/chain.pem" "$@"
+	fi
+
+	openssl s_server -accept "127.0.0.1:$port" -cert "$dir/leaf.pem" -key "$dir/leaf.key" \
+		-www -quiet "$@" >/dev/null 2>&1 &
+	PIDS="$PIDS $!"
+
+	tries=0
+
+	until "$TARGET" -q -D 1000 -H 1000 "127.0.0.1:$port" >/dev/null 2>&1; do
+		tries=$((tries + 1))
+
+		if test "$tries" -gt 50; then
+			echo "Unable to start server for $1 on port $port." >&2
+			exit 1
+		fi
+
+		sleep 0.1
+	done
+}
+
+# Run command, printing its peak RSS in KB (or "-"),
+# and discarding its output.
+rss () {
+	if test -x /usr/bin/time && /usr/bin/time -f %M true >/dev/null 2>&1; then
+		/usr/bin/time -f %M -o "$WORK_DIR/rss" "$@" >/dev/null 2>&1 || true
+		cat "$WORK_DIR/rss"
+		return
+	fi
+
+	"$@" >/dev/null 2>&1 &
+	pid=$!
+	peak=-
+
+	while kill -0 "$pid" 2>/dev/null; do
+		hwm=$(awk '/^VmHWM/ { print $2 }' "/proc/$pid/status" 2>/dev/null || true)
+
+		if test -n "$hwm"; then
+			peak=$hwm
+		fi
+
+		sleep 0.01
+	done
+
+	wait "$pid" || true
+	echo "$peak"
+}
+
+# Mean and p99 of a timing field ($1), in ms, from ndjson on stdin.
+phase () {
+	sed -n "s/.*\"timing\":{.*\"$1\":\([0-9.]*\).*/\1/p" | sort -n | awk '
+		{ values[NR] = $1; sum += $1 }
+		END {
+			if (NR == 0) { print "-"; exit }
+			index99 = int(NR * 0.99); if (index99 < 1) index99 = 1
+			printf "%.3f/%.3f", sum / NR, values[index99]
+		}'
+}
+
+# Benchmark fixture $1, served on port $2.
+bench () {
+	name=$1
+	target="localhost:$2"
+
+	# Single: one probe per run, as from the command line.
+	start=$(now)
+	run=0
+
+	while test "$run" -lt "$BENCH_SINGLE"; do
+		"$TARGET" -q "$target" >/dev/null
+		run=$((run + 1))
+	done
+
+	elapsed=$(($(now) - start))
+	single=$(awk -v n="$BENCH_SINGLE" -v ms="$elapsed" 'BEGIN { printf "%.1f", (ms > 0) ? n * 1000 / ms : 0 }')
+	single_rss=$(rss "$TARGET" -q "$target")
+
+	# Batch: every probe of a target list, concurrently.
+	run=0
+	: > "$WORK_DIR/targets"
+
+	while test "$run" -lt "$BENCH_BATCH"; do
+		echo "$target" >> "$WORK_DIR/targets"
+		run=$((run + 1))
+	done
+
+	start=$(now)
+	"$TARGET" -q --format ndjson --concurrency "$BENCH_CONCURRENCY" \
+		--targets "$WORK_DIR/targets" > "$WORK_DIR/batch.json"
+	elapsed=$(($(now) - start))
+	batch=$(awk -v n="$BENCH_BATCH" -v ms="$elapsed" 'BEGIN { printf "%.1f", (ms > 0) ? n * 1000 / ms : 0 }')
+	failed=$(grep -c '"status":"error"' "$WORK_DIR/batch.json" || true)
+	connect=$(phase connect < "$WORK_DIR/batch.json")
+	handshake=$(phase handshake < "$WORK_DIR/batch.json")
+	total=$(phase total < "$WORK_DIR/batch.json")
+	batch_rss=$(rss "$TARGET" -q --format ndjson --concurrency "$BENCH_CONCURRENCY" --targets "$WORK_DIR/targets")
+
+	# Repeated: the same target, back to back.
+	start=$(now)
+	"$TARGET" -q --count "$BENCH_COUNT" --format ndjson "$target" > "$WORK_DIR/count.json"
+	elapsed=$(($(now) - start))
+	repeated=$(awk -v n="$BENCH_COUNT" -v ms="$elapsed" 'BEGIN { printf "%.1f", (ms > 0) ? n * 1000 / ms : 0 }')
+	repeated_total=$(phase total < "$WORK_DIR/count.json")
+	repeated_rss=$(rss "$TARGET" -q --count "$BENCH_COUNT" "$target")
+
+	printf '%-16s %9s %9s %9s %6s %15s %15s %15s %15s %8s %8s %8s\n' \
+		"$name" "$single" "$batch" "$repeated" "$failed" "$connect" "$handshake" "$total" \
+		"$repeated_total" "$single_rss" "$batch_rss" "$repeated_rss" | tee -a "$BENCH_OUT"
+}
+
+if ! test -x "$TARGET"; then
+	echo "Build $TARGET first." >&2
+	exit 1
+fi
+
+echo "Generating fixtures."
+
+fixture rsa2048 rsa2048 1
+fixture rsa4096 rsa4096 1
+fixture p256 p256 1
+fixture ed25519 ed25519 1
+fixture chain3 rsa2048 3
+fixture chain5 p256 5
+
+serve rsa2048 $BENCH_PORT
+serve rsa4096 $((BENCH_PORT + 1))
+serve p256 $((BENCH_PORT + 2))
+serve ed25519 $((BENCH_PORT + 3))
+serve chain3 $((BENCH_PORT + 4))
+serve chain5 $((BENCH_PORT + 5))
+serve rsa2048 $((BENCH_PORT + 6)) -tls1_2
+serve p256 $((BENCH_PORT + 7)) -tls1_2
+
+{
+	echo
+	echo "# $(date -u +%Y-%m-%dT%H:%M:%SZ) $("$TARGET" --version) $(openssl version)"
+	echo "# single=$BENCH_SINGLE batch=$BENCH_BATCH concurrency=$BENCH_CONCURRENCY count=$BENCH_COUNT"
+	echo "# Rates in handshakes/s, latency as mean/p99 in ms, peak RSS in KB."
+	printf '%-16s %9s %9s %9s %6s %15s %15s %15s %15s %8s %8s %8s\n' \
+		fixture single/s batch/s repeat/s failed connect handshake total repeat-total \
+		rss-1 rss-batch rss-rep
+} | tee -a "$BENCH_OUT"
+
+bench rsa2048 $BENCH_PORT
+bench rsa4096 $((BENCH_PORT + 1))
+bench p256 $((BENCH_PORT + 2))
+bench ed25519 $((BENCH_PORT + 3))
+bench chain3 $((BENCH_PORT + 4))
+bench chain5 $((BENCH_PORT + 5))
+bench rsa2048-tls1.2 $((BENCH_PORT + 6))
+bench p256-tls1.2 $((BENCH_PORT + 7))